@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch.hpp"
+#include "main.hpp"
+#include "simulation.hpp"
+#include "chara.hpp"
+#include "chardiff.hpp"
+#include "gamedump.hpp"
+#include "replay.hpp"
+
+static bool checkProfileBuild(bool profile)
+{
+    if (profile && !profileEnabled) {
+        fprintf(stderr, "--profile needs a build with -Dprofile=true\n");
+        return false;
+    }
+    return true;
+}
+
+// every .json under a directory, or a file listing one replay path per line
+static std::vector<std::string> collectReplayPaths(const std::string &source)
+{
+    std::vector<std::string> paths;
+    std::error_code error;
+    if (std::filesystem::is_directory(source, error)) {
+        for (auto &entry : std::filesystem::recursive_directory_iterator(source, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+    } else {
+        std::ifstream listFile(source);
+        std::string line;
+        while (std::getline(listFile, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                paths.push_back(line);
+            }
+        }
+    }
+    return paths;
+}
+
+// RR;<path>;<version>;<round>;<status>;<error frame>;<summary>, round 0 is for
+// the whole replay when it didn't get as far as a round
+static std::string replayResultLine(const std::string &path, int version, int round, const char *status, int errorFrame, const std::string &summary)
+{
+    return "RR;" + path + ";" + std::to_string(version) + ";" + std::to_string(round) + ";" + status + ";" +
+        std::to_string(errorFrame) + ";" + summary + "\n";
+}
+
+struct RegressionTest {
+    std::string name;
+    std::string version;
+    std::string path;
+};
+
+// tests/dumps/<version>/<name>.json, or the .pdump next to it from
+// convert_dump when that's at least as new
+static std::vector<RegressionTest> collectRegressionTests(const std::string &dumpDir)
+{
+    std::vector<RegressionTest> tests;
+    std::error_code error;
+    for (auto &entry : std::filesystem::recursive_directory_iterator(dumpDir, error)) {
+        const std::filesystem::path &path = entry.path();
+        if (!entry.is_regular_file() || path.extension() != ".json") {
+            continue;
+        }
+        RegressionTest test;
+        std::string fileName = path.filename().string();
+        test.name = fileName.substr(0, fileName.find('.'));
+        test.version = path.parent_path().filename().string();
+        test.path = path.string();
+
+        std::filesystem::path binaryPath = path.parent_path() / (test.name + ".pdump");
+        if (std::filesystem::is_regular_file(binaryPath, error) &&
+            std::filesystem::last_write_time(binaryPath, error) >= std::filesystem::last_write_time(path, error)) {
+            test.path = binaryPath.string();
+        }
+        tests.push_back(test);
+    }
+    std::sort(tests.begin(), tests.end(), [](const RegressionTest &a, const RegressionTest &b) {
+        return a.name < b.name;
+    });
+    return tests;
+}
+
+// same layout tests/run_tests.py used to build from run_dump's E; lines, so
+// the results viewer and history scripts keep working
+static nlohmann::ordered_json runRegressionTest(const RegressionTest &test)
+{
+    nlohmann::ordered_json result;
+    result["testName"] = test.name;
+    result["testVersion"] = test.version;
+    result["finished"] = false;
+
+    struct ErrorTypeStats {
+        int count = 0;
+        int firstFrame = -1;
+        int lastFrame = -1;
+    };
+    std::vector<ErrorTypeStats> errorTypes(12);
+
+    Simulation sim;
+    sim.onGameStateError = [&](const Simulation::GameStateError &error) {
+        if ((int)errorTypes.size() <= error.type) {
+            errorTypes.resize(error.type + 1);
+        }
+        ErrorTypeStats &stats = errorTypes[error.type];
+        if (stats.firstFrame == -1) {
+            stats.firstFrame = error.frame;
+        }
+        stats.lastFrame = error.frame;
+        stats.count++;
+    };
+
+    try {
+        result["finished"] = simulateGameDump(&sim, test.path, atoi(test.version.c_str()));
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s: %s\n", test.path.c_str(), e.what());
+    }
+
+    result["errorTypes"] = nlohmann::ordered_json::array();
+    for (const ErrorTypeStats &stats : errorTypes) {
+        nlohmann::ordered_json errorType;
+        errorType["count"] = stats.count;
+        errorType["firstFrame"] = stats.firstFrame;
+        errorType["lastFrame"] = stats.lastFrame;
+        result["errorTypes"].push_back(errorType);
+    }
+    return result;
+}
+
+bool runBatchCommand(int argc, char **argv, int &exitCode)
+{
+    // --profile can go anywhere, take it out before looking at positional args
+    bool profile = false;
+    std::vector<char *> args;
+    for (int i = 0; i < argc; i++) {
+        if (std::string(argv[i]) == "--profile") {
+            profile = true;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = args.size();
+    argv = args.data();
+
+    if (argc > 2 && std::string(argv[1]) == "run_dump") {
+        gameMode = Batch;
+        int version = -1;
+        if (argc > 3) {
+            version = atoi(argv[3]);
+        }
+        if (!checkProfileBuild(profile)) {
+            exitCode = 1;
+            return true;
+        }
+
+        Simulation sim;
+        simulateGameDump(&sim, argv[2], version);
+
+        if (profile) {
+            printf("%s", sim.profile.Summary().c_str());
+        }
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "check_allocs") {
+        gameMode = Batch;
+#ifndef PSYCHODRIVE_PROFILE
+        fprintf(stderr, "check_allocs needs a build with -Dprofile=true to count allocations\n");
+        exitCode = 1;
+#else
+        int version = -1;
+        if (argc > 3) {
+            version = atoi(argv[3]);
+        }
+        // set up from the dump and let the guys idle from there, once their
+        // containers and the frame arena are done growing a frame shouldn't
+        // touch the heap at all
+        const int warmupFrames = 300;
+        const int checkedFrames = 600;
+        Simulation sim;
+        if (!sim.SetupFromGameDump(argv[2], version) || sim.simGuys.empty()) {
+            fprintf(stderr, "failed to set up from %s\n", argv[2]);
+            exitCode = 1;
+            return true;
+        }
+        sim.replayingGameStateDump = false;
+
+        for (int i = 0; i < warmupFrames; i++) {
+            sim.RunFrame();
+            sim.AdvanceFrame();
+        }
+
+        uint64_t startAllocations = profileAllocations;
+        uint64_t startAllocatedBytes = profileAllocatedBytes;
+        int startGrowCount = sim.frameArena.growCount;
+        for (int i = 0; i < checkedFrames; i++) {
+            sim.RunFrame();
+            sim.AdvanceFrame();
+        }
+        uint64_t allocations = profileAllocations - startAllocations;
+        uint64_t allocatedBytes = profileAllocatedBytes - startAllocatedBytes;
+        int arenaGrowCount = sim.frameArena.growCount - startGrowCount;
+
+        printf("%d frames: %llu allocations, %llu bytes, frame arena grew %d times (%zu bytes)\n", checkedFrames,
+               (unsigned long long)allocations, (unsigned long long)allocatedBytes, arenaGrowCount,
+               sim.frameArena.capacity());
+
+        exitCode = (allocations || arenaGrowCount) ? 1 : 0;
+#endif
+        return true;
+    }
+
+    if (argc > 3 && std::string(argv[1]) == "run_tests") {
+        gameMode = Batch;
+
+        std::vector<RegressionTest> tests = collectRegressionTests(argv[2]);
+        if (tests.empty()) {
+            fprintf(stderr, "no dumps found in %s\n", argv[2]);
+            exitCode = 1;
+            return true;
+        }
+
+        // everything in one process so character data only loads once per
+        // version, each worker takes the next dump off the list
+        std::vector<nlohmann::ordered_json> results(tests.size());
+        std::atomic<size_t> nextTest = 0;
+
+        auto worker = [&]() {
+            size_t i;
+            while ((i = nextTest++) < tests.size()) {
+                results[i] = runRegressionTest(tests[i]);
+            }
+        };
+
+        size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, tests.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < workerCount; i++) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : workers) {
+            thread.join();
+        }
+
+        int finishedCount = 0;
+        int errorCount = 0;
+        nlohmann::ordered_json resultsJson = nlohmann::ordered_json::array();
+        for (nlohmann::ordered_json &result : results) {
+            finishedCount += result["finished"].get<bool>();
+            for (auto &errorType : result["errorTypes"]) {
+                errorCount += errorType["count"].get<int>();
+            }
+            resultsJson.push_back(std::move(result));
+        }
+
+        std::ofstream resultsFile(argv[3]);
+        if (!resultsFile) {
+            fprintf(stderr, "failed to write %s\n", argv[3]);
+            exitCode = 1;
+            return true;
+        }
+        resultsFile << "var newResults =\n" << resultsJson.dump(4) << "\n";
+
+        fprintf(stderr, "F;tests finished;%zu;%d finished;%d errors\n", tests.size(), finishedCount, errorCount);
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 3 && std::string(argv[1]) == "convert_dump") {
+        GameDump dump;
+        if (!loadGameDump(argv[2], dump)) {
+            fprintf(stderr, "failed to load dump %s\n", argv[2]);
+            exitCode = 1;
+            return true;
+        }
+        if (!writeBinaryGameDump(dump, argv[3])) {
+            fprintf(stderr, "failed to write %s\n", argv[3]);
+            exitCode = 1;
+            return true;
+        }
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "run_replay") {
+        gameMode = Batch;
+        int version = -1;
+        if (argc > 3) {
+            version = atoi(argv[3]);
+        }
+
+        nlohmann::json replayJson = parse_json_file(argv[2]);
+        if (replayJson == nullptr) {
+            fprintf(stderr, "failed to load replay %s\n", argv[2]);
+            exitCode = 1;
+            return true;
+        }
+        ReplayData replay;
+        if (!loadReplayData(replayJson, version, replay)) {
+            fprintf(stderr, "replay missing InputData or ReplayInfo\n");
+            exitCode = 1;
+            return true;
+        }
+        if (!checkProfileBuild(profile)) {
+            exitCode = 1;
+            return true;
+        }
+
+        SimProfile replayProfile;
+        simulateReplayRounds(replay, nullptr, [&](int, Simulation *pSim, ReplayRoundResult &) {
+            replayProfile.Add(pSim->profile);
+        });
+
+        if (profile) {
+            printf("%s", replayProfile.Summary().c_str());
+        }
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "index_replay") {
+        gameMode = Batch;
+        int version = -1;
+        if (argc > 3) {
+            version = atoi(argv[3]);
+        }
+        int checkpointInterval = defaultReplayCheckpointInterval;
+        if (argc > 4) {
+            checkpointInterval = std::max(atoi(argv[4]), 1);
+        }
+
+        nlohmann::json replayJson = parse_json_file(argv[2]);
+        if (replayJson == nullptr) {
+            fprintf(stderr, "failed to load replay %s\n", argv[2]);
+            exitCode = 1;
+            return true;
+        }
+        ReplayData replay;
+        if (!loadReplayData(replayJson, version, replay)) {
+            fprintf(stderr, "replay missing InputData or ReplayInfo\n");
+            exitCode = 1;
+            return true;
+        }
+
+        ReplayIndex index;
+        buildReplayIndex(replay, index, checkpointInterval);
+        std::string indexPath = replayIndexPath(argv[2]);
+        if (!writeReplayIndex(index, indexPath)) {
+            fprintf(stderr, "failed to write %s\n", indexPath.c_str());
+            exitCode = 1;
+            return true;
+        }
+        for (size_t round = 0; round < index.rounds.size(); round++) {
+            fprintf(stderr, "round %zu: %d frames, %zu checkpoints\n", round + 1, index.rounds[round].frameCount,
+                    index.rounds[round].checkpoints.size());
+        }
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "run_replays") {
+        gameMode = Batch;
+        int version = -1;
+        if (argc > 3) {
+            version = atoi(argv[3]);
+        }
+
+        std::vector<std::string> paths = collectReplayPaths(argv[2]);
+        if (paths.empty()) {
+            fprintf(stderr, "no replays found in %s\n", argv[2]);
+            exitCode = 1;
+            return true;
+        }
+
+        // one replay per worker at a time, rounds stay on that worker - the
+        // character cache is shared so each version only loads once
+        std::atomic<size_t> nextReplay = 0;
+        std::atomic<int> desyncCount = 0;
+        std::atomic<int> failCount = 0;
+        std::mutex mutexOutput;
+
+        auto worker = [&]() {
+            size_t i;
+            while ((i = nextReplay++) < paths.size()) {
+                const std::string &path = paths[i];
+                std::string lines;
+                try {
+                    nlohmann::json replayJson = parse_json_file(path);
+                    ReplayData replay;
+                    if (replayJson == nullptr || !loadReplayData(replayJson, version, replay)) {
+                        lines = replayResultLine(path, version, 0, "LOAD_ERROR", -1, "");
+                        failCount++;
+                    } else {
+                        ReplayRunOptions options;
+                        options.parallelRounds = false;
+                        options.printResults = false;
+
+                        bool desynced = false;
+                        simulateReplayRounds(replay, nullptr, [&](int round, Simulation *, ReplayRoundResult &result) {
+                            lines += replayResultLine(path, replay.version, round + 1, result.hasErrors ? "DESYNC" : "OK",
+                                                      result.hasErrors ? result.finishFrame : -1, result.summary);
+                            desynced |= result.hasErrors;
+                        }, options);
+
+                        if (lines.empty()) {
+                            lines = replayResultLine(path, replay.version, 0, "NO_ROUNDS", -1, "");
+                        }
+                        if (desynced) {
+                            desyncCount++;
+                        }
+                    }
+                } catch (const std::exception &e) {
+                    // a malformed replay shouldn't take the rest of the batch down
+                    lines = replayResultLine(path, version, 0, "ERROR", -1, e.what());
+                    failCount++;
+                }
+
+                std::lock_guard<std::mutex> lock(mutexOutput);
+                fputs(lines.c_str(), stdout);
+                fflush(stdout);
+            }
+        };
+
+        size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, paths.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < workerCount; i++) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : workers) {
+            thread.join();
+        }
+
+        fprintf(stderr, "F;replays finished;%zu;%d desynced;%d failed\n", paths.size(), desyncCount.load(), failCount.load());
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "printversions") {
+        for (int i = 0; i < charVersionCount; i++) {
+            printf("%d\n", atoi(charVersions[i]));
+        }
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 3 && std::string(argv[1]) == "diff_versions") {
+        gameMode = Batch;
+        int oldVersion = atoi(argv[2]);
+        int newVersion = atoi(argv[3]);
+
+        std::vector<std::string> diffChars;
+        if (argc > 4 && std::string(argv[4]) != "all") {
+            std::stringstream charList(argv[4]);
+            std::string charName;
+            while (std::getline(charList, charName, ',')) {
+                diffChars.push_back(charName);
+            }
+        } else {
+            for (const char *charName : charNames) {
+                diffChars.push_back(charName);
+            }
+        }
+
+        std::vector<CharDiffEntry> diff = diffVersions(diffChars, oldVersion, newVersion);
+        if (argc > 5 && std::string(argv[5]) == "json") {
+            printf("%s\n", charDiffEntriesToJson(diff).dump(2).c_str());
+        } else {
+            for (const CharDiffEntry &entry : diff) {
+                printf("%s\n", formatCharDiffEntry(entry).c_str());
+            }
+        }
+
+        exitCode = 0;
+        return true;
+    }
+
+    if (argc > 3 && std::string(argv[1]) == "cook") {
+        char* charSpec = argv[2];
+        std::string outFile = argv[3];
+
+        std::string charName;
+        int version = atoi(charVersions[charVersionCount - 1]);
+        extractCharVersion(charSpec, charName, version);
+
+        std::shared_ptr<CharacterData> pData;
+        try {
+            pData = loadCharacter(charName, version);
+        } catch (const std::exception &e) {
+            fprintf(stderr, "%s\n", e.what());
+        }
+        if (!pData) {
+            fprintf(stderr, "failed to load %s v%d\n", charName.c_str(), version);
+            exitCode = 1;
+            return true;
+        }
+
+        if (!cookCharacter(pData.get(), outFile)) {
+            fprintf(stderr, "failed to cook %s v%d\n", charName.c_str(), version);
+            exitCode = 1;
+            return true;
+        }
+
+        exitCode = 0;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// the command line modes that don't need a window - run_dump, run_tests,
+// run_replay, run_replays, index_replay, convert_dump, diff_versions, cook
+// and printversions. returns false if argv isn't one of them, otherwise runs
+// it and sets the process exit code
+bool runBatchCommand(int argc, char **argv, int &exitCode);
@@ -0,0 +1,182 @@
+#include <mutex>
+
+#define PD_BUILDING_LIBRARY
+#include "psychodrive.h"
+#include "simulation.hpp"
+#include "guy.hpp"
+#include "chara.hpp"
+#include "input.hpp"
+
+struct pd_sim {
+    Simulation sim;
+};
+
+static void initCore(void)
+{
+    static std::once_flag initFlag;
+    std::call_once(initFlag, [] {
+        if (charNames.empty()) {
+            makeCharEntries();
+        }
+        gameMode = Batch;
+    });
+}
+
+// same order the sim controller uses - inputs go in between RunFrame and
+// AdvanceFrame, the sim keeps frame events for the ui so drop them here
+static void stepSim(Simulation &sim, const int32_t *inputs)
+{
+    sim.RunFrame();
+    for (size_t i = 0; i < sim.simGuys.size(); i++) {
+        Guy *pGuy = sim.simGuys[i];
+        pGuy->Input(addPressBits(inputs[i], pGuy->getCurrentInput()));
+    }
+    sim.AdvanceFrame();
+    sim.getCurrentFrameEvents().clear();
+}
+
+extern "C" {
+
+int pd_api_version(void)
+{
+    return PD_API_VERSION;
+}
+
+pd_sim *pd_sim_create(void)
+{
+    try {
+        initCore();
+        return new pd_sim;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+pd_sim *pd_sim_clone(pd_sim *sim)
+{
+    if (!sim) {
+        return nullptr;
+    }
+    try {
+        pd_sim *pNewSim = new pd_sim;
+        pNewSim->sim.Clone(&sim->sim);
+        return pNewSim;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void pd_sim_free(pd_sim *sim)
+{
+    delete sim;
+}
+
+int pd_sim_add_guy(pd_sim *sim, const char *char_name, int version, double pos_x, int direction)
+{
+    if (!sim || !char_name || (direction != 1 && direction != -1)) {
+        return -1;
+    }
+    try {
+        // Guy can't deal with missing char data, check before making one
+        if (!getCharIDFromName(char_name) || !loadCharacter(char_name, version)) {
+            return -1;
+        }
+        color charColor = {1.0f, 1.0f, 1.0f};
+        sim->sim.CreateGuy(char_name, version, Fixed(pos_x, true), Fixed(0), direction, charColor);
+        Guy *pGuy = sim->sim.simGuys.back();
+        pGuy->DoInstantAction(580); // IMM_STAGE_INIT
+        pGuy->DoInstantAction(581); // IMM_ROUND_INIT
+        return sim->sim.simGuys.size() - 1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int pd_sim_guy_count(pd_sim *sim)
+{
+    if (!sim) {
+        return -1;
+    }
+    return sim->sim.simGuys.size();
+}
+
+int pd_sim_step(pd_sim *sim, const int32_t *inputs, int input_count)
+{
+    return pd_sim_step_frames(sim, inputs, input_count, 1);
+}
+
+int pd_sim_step_frames(pd_sim *sim, const int32_t *inputs, int input_count, int frame_count)
+{
+    return pd_sim_step_frames_states(sim, inputs, input_count, frame_count, nullptr);
+}
+
+int pd_sim_step_frames_states(pd_sim *sim, const int32_t *inputs, int input_count, int frame_count, pd_guy_state *out_states)
+{
+    if (!sim || frame_count < 0) {
+        return -1;
+    }
+    int guyCount = sim->sim.simGuys.size();
+    if (input_count != guyCount * frame_count || (input_count && !inputs)) {
+        return -1;
+    }
+    try {
+        for (int frame = 0; frame < frame_count; frame++) {
+            stepSim(sim->sim, inputs + frame * guyCount);
+            if (out_states) {
+                for (int guy = 0; guy < guyCount; guy++) {
+                    pd_sim_get_guy_state(sim, guy, out_states + frame * guyCount + guy);
+                }
+            }
+        }
+        return sim->sim.frameCounter;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int pd_sim_get_frame(pd_sim *sim)
+{
+    if (!sim) {
+        return -1;
+    }
+    return sim->sim.frameCounter;
+}
+
+int pd_sim_get_guy_state(pd_sim *sim, int guy_index, pd_guy_state *out_state)
+{
+    if (!sim || !out_state || guy_index < 0 || guy_index >= (int)sim->sim.simGuys.size()) {
+        return -1;
+    }
+    Guy *pGuy = sim->sim.simGuys[guy_index];
+
+    Fixed velX, velY, accelX, accelY;
+    pGuy->getVel(velX, velY, accelX, accelY);
+
+    out_state->unique_id = pGuy->getUniqueID();
+    out_state->char_id = pGuy->getCharData()->charID;
+    out_state->action_id = pGuy->getCurrentAction();
+    out_state->action_frame = pGuy->getCurrentFrame();
+    out_state->direction = pGuy->getDirection();
+    out_state->health = pGuy->getHealth();
+    out_state->drive_gauge = pGuy->getFocus();
+    out_state->super_gauge = pGuy->getGauge();
+    out_state->combo_hits = pGuy->getComboHits();
+    out_state->combo_damage = pGuy->getComboDamage();
+    out_state->hit_stop = pGuy->getHitStop();
+    out_state->hit_stun = pGuy->getHitStun();
+    out_state->current_input = pGuy->getCurrentInput();
+    out_state->can_act = pGuy->canAct();
+    out_state->airborne = pGuy->getAirborne();
+    out_state->minion_count = pGuy->getMinions().size();
+    out_state->pos_x = pGuy->getPosX().data;
+    out_state->pos_y = pGuy->getPosY().data;
+    out_state->vel_x = velX.data;
+    out_state->vel_y = velY.data;
+    out_state->accel_x = accelX.data;
+    out_state->accel_y = accelY.data;
+    out_state->hit_vel_x = pGuy->getHitVelX().data;
+    out_state->hit_accel_x = pGuy->getHitAccelX().data;
+    return 0;
+}
+
+}
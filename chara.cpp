@@ -3,9 +3,39 @@
 #include <string>
 #include <cstdlib>
 #include <fstream>
-
-std::unordered_map<std::string, nlohmann::json> mapCharFileLoader;
-std::unordered_map<std::string, CharacterData*> mapCharDataLoader;
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <unordered_set>
+
+// every file and character gets its own entry, created under the map lock but
+// loaded outside of it through call_once - concurrent callers for the same key
+// wait on the one load in flight, callers for other keys don't wait at all
+struct CharFileCacheEntry {
+    std::once_flag loadOnce;
+    std::shared_ptr<nlohmann::json> pJson;
+};
+
+struct CharDataCacheEntry {
+    std::once_flag loadOnce;
+    std::atomic<bool> loaded = false;
+    // set when the last attempt threw, cleared again if a later one succeeds
+    std::atomic<bool> failed = false;
+    std::shared_ptr<CharacterData> pData;
+    // the shared common files the load used, they stay cached until the last
+    // character using them is evicted
+    std::vector<std::string> commonFiles;
+};
+
+static std::mutex mutexCharFileLoader;
+static std::unordered_map<std::string, std::shared_ptr<CharFileCacheEntry>> mapCharFileLoader;
+static std::mutex mutexCharDataLoader;
+static std::unordered_map<std::string, std::shared_ptr<CharDataCacheEntry>> mapCharDataLoader;
 
 bool charFileExists(const std::string &path, const std::string &charFileName)
 {
@@ -26,7 +56,8 @@ int findCharVersionSlot(int version)
     return versionSlot;
 }
 
-nlohmann::json *loadCharFile(const std::string &charName, int version, const std::string &jsonName)
+std::shared_ptr<nlohmann::json> loadCharFile(const std::string &charName, int version, const std::string &jsonName,
+                                              std::vector<std::string> *pUsedFiles = nullptr)
 {
     std::string charPath = "data/chars/" + charName + "/";
     std::string charFileName;
@@ -47,17 +78,25 @@ nlohmann::json *loadCharFile(const std::string &charName, int version, const std
     if (!foundFile) {
         return nullptr;
     }
+    if (pUsedFiles) {
+        pUsedFiles->push_back(charFileName);
+    }
 
-    if (mapCharFileLoader.find(charFileName) == mapCharFileLoader.end()) {
-        std::string fullPath = charPath + charFileName;
-        if (std::filesystem::exists(fullPath)) {
-            mapCharFileLoader[charFileName] = parse_json_file(fullPath);
-        } else {
-            mapCharFileLoader[charFileName] = nullptr;
+    std::shared_ptr<CharFileCacheEntry> pEntry;
+    {
+        std::scoped_lock lock(mutexCharFileLoader);
+        auto &entry = mapCharFileLoader[charFileName];
+        if (!entry) {
+            entry = std::make_shared<CharFileCacheEntry>();
         }
+        pEntry = entry;
     }
 
-    return &mapCharFileLoader[charFileName];
+    std::call_once(pEntry->loadOnce, [&]() {
+        pEntry->pJson = std::make_shared<nlohmann::json>(parse_json_file(charPath + charFileName));
+    });
+
+    return pEntry->pJson;
 }
 
 void loadCharges(nlohmann::json* pChargeJson, CharacterData* pRet)
@@ -304,7 +343,35 @@ void loadRects(nlohmann::json* pRectsJson, std::vector<Rect>* pOutputVector)
     }
 }
 
-void loadHurtBoxKeys(nlohmann::json* pHurtBoxJson, std::vector<HurtBoxKey>* pOutputVector, std::map<std::pair<int, int>, Rect*>& rectsByIDs, std::map<int, AtemiData*>& atemiByID)
+template<typename T>
+static KeySpan<T> arenaSpanSince(const std::vector<T> &arena, size_t first)
+{
+    KeySpan<T> span;
+    span.first = first;
+    span.count = arena.size() - first;
+    return span;
+}
+
+template<typename T>
+static void resolveKeySpan(KeySpan<T> &span, std::vector<T> &arena)
+{
+    assert(span.first + span.count <= arena.size());
+    span.pData = arena.data() + span.first;
+}
+
+KeySpan<Rect *> loadRectRefs(nlohmann::json& boxListJson, int rectListID, std::vector<Rect *>* pRectRefs, std::map<std::pair<int, int>, Rect*>& rectsByIDs)
+{
+    size_t first = pRectRefs->size();
+    for (auto& [boxNumber, boxID] : boxListJson.items()) {
+        auto it = rectsByIDs.find(std::make_pair(rectListID, boxID));
+        if (it != rectsByIDs.end()) {
+            pRectRefs->push_back(it->second);
+        }
+    }
+    return arenaSpanSince(*pRectRefs, first);
+}
+
+void loadHurtBoxKeys(nlohmann::json* pHurtBoxJson, std::vector<HurtBoxKey>* pOutputVector, std::vector<Rect *>* pRectRefs, std::map<std::pair<int, int>, Rect*>& rectsByIDs, std::map<int, AtemiData*>& atemiByID)
 {
     if (!pHurtBoxJson) {
         return;
@@ -338,34 +405,10 @@ void loadHurtBoxKeys(nlohmann::json* pHurtBoxJson, std::vector<HurtBoxKey>* pOut
         newKey.immunity = hurtBox["Immune"];
         newKey.flags = hurtBox["TypeFlag"];
 
-        newKey.headRects.reserve(hurtBox["HeadList"].size());
-        for (auto& [boxNumber, boxID] : hurtBox["HeadList"].items()) {
-            auto it = rectsByIDs.find(std::make_pair(magicHurtBoxID, boxID));
-            if (it != rectsByIDs.end()) {
-                newKey.headRects.push_back(it->second);
-            }
-        }
-        newKey.bodyRects.reserve(hurtBox["BodyList"].size());
-        for (auto& [boxNumber, boxID] : hurtBox["BodyList"].items()) {
-            auto it = rectsByIDs.find(std::make_pair(magicHurtBoxID, boxID));
-            if (it != rectsByIDs.end()) {
-                newKey.bodyRects.push_back(it->second);
-            }
-        }
-        newKey.legRects.reserve(hurtBox["LegList"].size());
-        for (auto& [boxNumber, boxID] : hurtBox["LegList"].items()) {
-            auto it = rectsByIDs.find(std::make_pair(magicHurtBoxID, boxID));
-            if (it != rectsByIDs.end()) {
-                newKey.legRects.push_back(it->second);
-            }
-        }
-        newKey.throwRects.reserve(hurtBox["ThrowList"].size());
-        for (auto& [boxNumber, boxID] : hurtBox["ThrowList"].items()) {
-            auto it = rectsByIDs.find(std::make_pair(magicThrowBoxID, boxID));
-            if (it != rectsByIDs.end()) {
-                newKey.throwRects.push_back(it->second);
-            }
-        }
+        newKey.headRects = loadRectRefs(hurtBox["HeadList"], magicHurtBoxID, pRectRefs, rectsByIDs);
+        newKey.bodyRects = loadRectRefs(hurtBox["BodyList"], magicHurtBoxID, pRectRefs, rectsByIDs);
+        newKey.legRects = loadRectRefs(hurtBox["LegList"], magicHurtBoxID, pRectRefs, rectsByIDs);
+        newKey.throwRects = loadRectRefs(hurtBox["ThrowList"], magicThrowBoxID, pRectRefs, rectsByIDs);
 
         pOutputVector->push_back(newKey);
     }
@@ -401,7 +444,7 @@ void loadPushBoxKeys(nlohmann::json* pPushBoxJson, std::vector<PushBoxKey>* pOut
     }
 }
 
-void loadHitBoxKeys(nlohmann::json* pHitBoxJson, std::vector<HitBoxKey>* pOutputVector, std::map<std::pair<int, int>, Rect*>& rectsByIDs, bool isOther, std::map<int, HitData*>& hitByID)
+void loadHitBoxKeys(nlohmann::json* pHitBoxJson, std::vector<HitBoxKey>* pOutputVector, std::vector<Rect *>* pRectRefs, std::map<std::pair<int, int>, Rect*>& rectsByIDs, bool isOther, std::map<int, HitData*>& hitByID)
 {
     if (!pHitBoxJson) {
         return;
@@ -548,13 +591,7 @@ void loadHitBoxKeys(nlohmann::json* pHitBoxJson, std::vector<HitBoxKey>* pOutput
         if (type == domain) {
             pOutputVector->push_back(newKey);
         } else {
-            newKey.rects.reserve(hitBox["BoxList"].size());
-            for (auto& [boxNumber, boxID] : hitBox["BoxList"].items()) {
-                auto it = rectsByIDs.find(std::make_pair(rectListID, boxID));
-                if (it != rectsByIDs.end()) {
-                    newKey.rects.push_back(it->second);
-                }
-            }
+            newKey.rects = loadRectRefs(hitBox["BoxList"], rectListID, pRectRefs, rectsByIDs);
             if (!newKey.rects.empty()) {
                 pOutputVector->push_back(newKey);
             }
@@ -562,7 +599,7 @@ void loadHitBoxKeys(nlohmann::json* pHitBoxJson, std::vector<HitBoxKey>* pOutput
     }
 }
 
-void loadUniqueBoxKeys(nlohmann::json* pHitBoxJson, std::vector<UniqueBoxKey>* pOutputVector, std::map<std::pair<int, int>, Rect*>& rectsByIDs)
+void loadUniqueBoxKeys(nlohmann::json* pHitBoxJson, std::vector<UniqueBoxKey>* pOutputVector, std::vector<UniqueBoxOp>* pOps, std::vector<Rect *>* pRectRefs, std::map<std::pair<int, int>, Rect*>& rectsByIDs)
 {
     if (!pHitBoxJson) {
         return;
@@ -589,7 +626,7 @@ void loadUniqueBoxKeys(nlohmann::json* pHitBoxJson, std::vector<UniqueBoxKey>* p
         newKey.uniquePitcher = hitBox["CheckType"] == 0;
         newKey.applyOpToTarget = hitBox["PropHolder"] == 1;
 
-        newKey.ops.reserve(hitBox["Datas"].size());
+        size_t firstOp = pOps->size();
         for (auto& [dataID, dataOp] : hitBox["Datas"].items()) {
             UniqueBoxOp newOp;
             newOp.op = dataOp["OpeType"];
@@ -598,18 +635,15 @@ void loadUniqueBoxKeys(nlohmann::json* pHitBoxJson, std::vector<UniqueBoxKey>* p
             newOp.opParam2 = dataOp["Param02"];
             newOp.opParam3 = dataOp["Param03"];
             newOp.opParam4 = dataOp["Param04"];
-            newKey.ops.push_back(newOp);
+            pOps->push_back(newOp);
         }
+        newKey.ops = arenaSpanSince(*pOps, firstOp);
 
-        newKey.rects.reserve(hitBox["BoxList"].size());
-        for (auto& [boxNumber, boxID] : hitBox["BoxList"].items()) {
-            auto it = rectsByIDs.find(std::make_pair(rectListID, boxID));
-            if (it != rectsByIDs.end()) {
-                newKey.rects.push_back(it->second);
-            }
-        }
+        newKey.rects = loadRectRefs(hitBox["BoxList"], rectListID, pRectRefs, rectsByIDs);
         if (!newKey.rects.empty()) {
             pOutputVector->push_back(newKey);
+        } else {
+            pOps->resize(firstOp);
         }
     }
 }
@@ -643,7 +677,7 @@ void loadSteerKeys(nlohmann::json* pSteerJson, std::vector<SteerKey>* pOutputVec
     }
 }
 
-void loadPlaceKeys(nlohmann::json* pPlaceJson, std::vector<PlaceKey>* pOutputVector, bool isBG)
+void loadPlaceKeys(nlohmann::json* pPlaceJson, std::vector<PlaceKey>* pOutputVector, std::vector<PlaceKeyPos>* pPositions, bool isBG)
 {
     if (!pPlaceJson) {
         return;
@@ -661,15 +695,16 @@ void loadPlaceKeys(nlohmann::json* pPlaceJson, std::vector<PlaceKey>* pOutputVec
         newKey.axis = placeKey.value("Axis", 0);
         newKey.bgOnly = isBG;
 
+        size_t firstPos = pPositions->size();
         if (placeKey.contains("PosList")) {
-            newKey.posList.reserve(placeKey["PosList"].size());
             for (auto& [frame, offset] : placeKey["PosList"].items()) {
                 PlaceKeyPos pos;
                 pos.frame = atoi(frame.c_str());
                 pos.offset = Fixed(offset.get<double>());
-                newKey.posList.push_back(pos);
+                pPositions->push_back(pos);
             }
         }
+        newKey.posList = arenaSpanSince(*pPositions, firstPos);
 
         pOutputVector->push_back(newKey);
     }
@@ -763,7 +798,7 @@ void loadLockKeys(nlohmann::json* pLockJson, std::vector<LockKey>* pOutputVector
         if (newKey.type == 2) {
             auto hitIt = hitByID.find(newKey.param02);
             if (hitIt != hitByID.end()) {
-                newKey.pHitEntry = &hitIt->second->common[0];
+                newKey.pHitEntry = hitIt->second->common(0);
             }
         }
 
@@ -771,7 +806,7 @@ void loadLockKeys(nlohmann::json* pLockJson, std::vector<LockKey>* pOutputVector
     }
 }
 
-void loadBranchKeys(nlohmann::json* pBranchJson, std::vector<BranchKey>* pOutputVector)
+void loadBranchKeys(nlohmann::json* pBranchJson, std::vector<BranchKey>* pOutputVector, std::vector<std::string>* pTypeNames)
 {
     if (!pBranchJson) {
         return;
@@ -794,7 +829,12 @@ void loadBranchKeys(nlohmann::json* pBranchJson, std::vector<BranchKey>* pOutput
         newKey.branchFrame = branchKey["ActionFrame"];
         newKey.keepFrame = branchKey["_InheritFrameX"] || branchKey["_InheritFrame"];
         newKey.keepPlace = branchKey["_KeepPlace"];
-        newKey.typeName = branchKey.value("_TypesName", "");
+        std::string typeName = branchKey.value("_TypesName", "");
+        auto typeNameIt = std::find(pTypeNames->begin(), pTypeNames->end(), typeName);
+        newKey.typeNameIndex = typeNameIt - pTypeNames->begin();
+        if (typeNameIt == pTypeNames->end()) {
+            pTypeNames->push_back(typeName);
+        }
 
         pOutputVector->push_back(newKey);
     }
@@ -935,76 +975,109 @@ void loadStyles(nlohmann::json* pCharInfoJson, std::vector<StyleData>* pOutputVe
     }
 }
 
+// a value that doesn't fit would make the sim quietly disagree with the game,
+// fail the whole load (and the cook) instead
+static int32_t loadHitField(nlohmann::json& fieldJson, const char *fieldName)
+{
+    int64_t value = fieldJson;
+    if (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<int32_t>::max()) {
+        throw std::out_of_range("hit entry " + std::string(fieldName) + " out of range: " + std::to_string(value));
+    }
+    return (int32_t)value;
+}
+
 void loadHitEntry(nlohmann::json* pHitEntryJson, HitEntry* pEntry)
 {
-    pEntry->comboAdd = (*pHitEntryJson)["ComboAdd"];
-    pEntry->juggleFirst = (*pHitEntryJson)["Juggle1st"];
-    pEntry->juggleAdd = (*pHitEntryJson)["JuggleAdd"];
-    pEntry->juggleLimit = (*pHitEntryJson)["JuggleLimit"];
-    pEntry->hitStun = (*pHitEntryJson)["HitStun"];
-    pEntry->moveDestX = (*pHitEntryJson)["MoveDest"]["x"];
-    pEntry->moveDestY = (*pHitEntryJson)["MoveDest"]["y"];
-    pEntry->moveTime = (*pHitEntryJson)["MoveTime"];
-    pEntry->curveTargetID = (*pHitEntryJson)["CurveTgtID"];
-    pEntry->curveOwnID = (*pHitEntryJson)["CurveOwnID"];
-    pEntry->dmgValue = (*pHitEntryJson)["DmgValue"];
-    pEntry->recoverableDamage = (*pHitEntryJson)["DmgRecover"];
-    pEntry->focusGainOwn = (*pHitEntryJson)["FocusOwn"];
-    pEntry->focusGainTarget = (*pHitEntryJson)["FocusTgt"];
-    pEntry->superGainOwn = (*pHitEntryJson)["SuperOwn"];
-    pEntry->superGainTarget = (*pHitEntryJson)["SuperTgt"];
-    pEntry->parryGain = (*pHitEntryJson)["DriveNorm"];
-    pEntry->perfectParryGain = (*pHitEntryJson)["DriveJust"];
+    nlohmann::json& hitEntry = *pHitEntryJson;
+    pEntry->comboAdd = loadHitField(hitEntry["ComboAdd"], "ComboAdd");
+    pEntry->juggleFirst = loadHitField(hitEntry["Juggle1st"], "Juggle1st");
+    pEntry->juggleAdd = loadHitField(hitEntry["JuggleAdd"], "JuggleAdd");
+    pEntry->juggleLimit = loadHitField(hitEntry["JuggleLimit"], "JuggleLimit");
+    pEntry->hitStun = loadHitField(hitEntry["HitStun"], "HitStun");
+    pEntry->moveDestX = loadHitField(hitEntry["MoveDest"]["x"], "MoveDest");
+    pEntry->moveDestY = loadHitField(hitEntry["MoveDest"]["y"], "MoveDest");
+    pEntry->moveTime = loadHitField(hitEntry["MoveTime"], "MoveTime");
+    pEntry->curveTargetID = loadHitField(hitEntry["CurveTgtID"], "CurveTgtID");
+    pEntry->curveOwnID = loadHitField(hitEntry["CurveOwnID"], "CurveOwnID");
+    pEntry->dmgValue = loadHitField(hitEntry["DmgValue"], "DmgValue");
+    pEntry->recoverableDamage = loadHitField(hitEntry["DmgRecover"], "DmgRecover");
+    pEntry->focusGainOwn = loadHitField(hitEntry["FocusOwn"], "FocusOwn");
+    pEntry->focusGainTarget = loadHitField(hitEntry["FocusTgt"], "FocusTgt");
+    pEntry->superGainOwn = loadHitField(hitEntry["SuperOwn"], "SuperOwn");
+    pEntry->superGainTarget = loadHitField(hitEntry["SuperTgt"], "SuperTgt");
+    pEntry->parryGain = loadHitField(hitEntry["DriveNorm"], "DriveNorm");
+    pEntry->perfectParryGain = loadHitField(hitEntry["DriveJust"], "DriveJust");
     if (pEntry->parryGain == 65535) {
         pEntry->parryGain = 10000;
     }
     if (pEntry->perfectParryGain == 65535) {
         pEntry->perfectParryGain = 10000;
     }
-    pEntry->superGainTarget = (*pHitEntryJson)["SuperTgt"];
-    pEntry->dmgType = (*pHitEntryJson)["DmgType"];
-    pEntry->dmgKind = (*pHitEntryJson)["DmgKind"];
-    pEntry->dmgPower = (*pHitEntryJson)["DmgPower"];
-    pEntry->moveType = (*pHitEntryJson)["MoveType"];
-    pEntry->floorTime = (*pHitEntryJson)["FloorTime"];
-    pEntry->downTime = (*pHitEntryJson)["DownTime"];
-    pEntry->boundDest = (*pHitEntryJson)["BoundDest"];
-    pEntry->throwRelease = (*pHitEntryJson)["ThrowRelease"];
-    pEntry->jimenBound = (*pHitEntryJson)["_jimen_bound"];
-    pEntry->kabeBound = (*pHitEntryJson)["_kabe_bound"];
-    pEntry->kabeTataki = (*pHitEntryJson)["_kabe_tataki"];
-    pEntry->bombBurst = pHitEntryJson->value("_bomb_burst", false);
-    pEntry->attr0 = (*pHitEntryJson)["Attr0"];
-    pEntry->attr1 = (*pHitEntryJson)["Attr1"];
-    pEntry->attr2 = (*pHitEntryJson)["Attr2"];
-    pEntry->attr3 = (*pHitEntryJson)["Attr3"];
-    pEntry->ext0 = (*pHitEntryJson)["Ext0"];
-    pEntry->hitStopOwner = (*pHitEntryJson)["HitStopOwner"];
-    pEntry->hitStopTarget = (*pHitEntryJson)["HitStopTarget"];
-    pEntry->hitmark = (*pHitEntryJson)["Hitmark"];
-    pEntry->floorDestX = (*pHitEntryJson)["FloorDest"]["x"];
-    pEntry->floorDestY = (*pHitEntryJson)["FloorDest"]["y"];
-    pEntry->wallTime = (*pHitEntryJson)["WallTime"];
-    pEntry->wallStop = (*pHitEntryJson)["WallStop"];
-    pEntry->wallDestX = (*pHitEntryJson)["WallDest"]["x"];
-    pEntry->wallDestY = (*pHitEntryJson)["WallDest"]["y"];
+    pEntry->dmgType = loadHitField(hitEntry["DmgType"], "DmgType");
+    pEntry->dmgKind = loadHitField(hitEntry["DmgKind"], "DmgKind");
+    pEntry->dmgPower = loadHitField(hitEntry["DmgPower"], "DmgPower");
+    pEntry->moveType = loadHitField(hitEntry["MoveType"], "MoveType");
+    pEntry->floorTime = loadHitField(hitEntry["FloorTime"], "FloorTime");
+    pEntry->downTime = loadHitField(hitEntry["DownTime"], "DownTime");
+    pEntry->boundDest = loadHitField(hitEntry["BoundDest"], "BoundDest");
+    pEntry->throwRelease = loadHitField(hitEntry["ThrowRelease"], "ThrowRelease");
+    pEntry->jimenBound = hitEntry["_jimen_bound"].get<bool>();
+    pEntry->kabeBound = hitEntry["_kabe_bound"].get<bool>();
+    pEntry->kabeTataki = hitEntry["_kabe_tataki"].get<bool>();
+    pEntry->bombBurst = hitEntry.value("_bomb_burst", false);
+    pEntry->attr0 = loadHitField(hitEntry["Attr0"], "Attr0");
+    pEntry->attr1 = loadHitField(hitEntry["Attr1"], "Attr1");
+    pEntry->attr2 = loadHitField(hitEntry["Attr2"], "Attr2");
+    pEntry->attr3 = loadHitField(hitEntry["Attr3"], "Attr3");
+    pEntry->ext0 = loadHitField(hitEntry["Ext0"], "Ext0");
+    pEntry->hitStopOwner = loadHitField(hitEntry["HitStopOwner"], "HitStopOwner");
+    pEntry->hitStopTarget = loadHitField(hitEntry["HitStopTarget"], "HitStopTarget");
+    pEntry->hitmark = loadHitField(hitEntry["Hitmark"], "Hitmark");
+    pEntry->floorDestX = loadHitField(hitEntry["FloorDest"]["x"], "FloorDest");
+    pEntry->floorDestY = loadHitField(hitEntry["FloorDest"]["y"], "FloorDest");
+    pEntry->wallTime = loadHitField(hitEntry["WallTime"], "WallTime");
+    pEntry->wallStop = loadHitField(hitEntry["WallStop"], "WallStop");
+    pEntry->wallDestX = loadHitField(hitEntry["WallDest"]["x"], "WallDest");
+    pEntry->wallDestY = loadHitField(hitEntry["WallDest"]["y"], "WallDest");
 }
 
-void loadHits(nlohmann::json* pHitJson, std::vector<HitData>* pOutputVector)
+static uint16_t poolHitEntry(const HitEntry& entry, std::vector<HitEntry>* pEntryPool, std::map<HitEntry, uint16_t>& poolIndexByEntry)
+{
+    auto it = poolIndexByEntry.find(entry);
+    if (it != poolIndexByEntry.end()) {
+        return it->second;
+    }
+    // indices are 16 bit, a pool that can't address its next entry fails the load
+    if (pEntryPool->size() > UINT16_MAX) {
+        throw std::out_of_range("hit entry pool full at " + std::to_string(pEntryPool->size()) + " entries");
+    }
+    uint16_t index = pEntryPool->size();
+    pEntryPool->push_back(entry);
+    poolIndexByEntry[entry] = index;
+    return index;
+}
+
+void loadHits(nlohmann::json* pHitJson, std::vector<HitData>* pOutputVector, std::vector<HitEntry>* pEntryPool)
 {
     if (!pHitJson) {
         return;
     }
 
+    std::map<HitEntry, uint16_t> poolIndexByEntry;
+
     for (auto& [hitID, hitData] : pHitJson->items()) {
         HitData newHit;
         newHit.id = std::stoi(hitID);
 
+        // slots missing from the data are zeroed
+        HitEntry common[5] = {};
+        HitEntry param[20] = {};
+
         if (hitData.contains("common")) {
             for (auto& [slotID, slotData] : hitData["common"].items()) {
                 int slot = std::stoi(slotID);
                 if (slot >= 0 && slot < 5) {
-                    loadHitEntry(&slotData, &newHit.common[slot]);
+                    loadHitEntry(&slotData, &common[slot]);
                 }
             }
         }
@@ -1013,13 +1086,24 @@ void loadHits(nlohmann::json* pHitJson, std::vector<HitData>* pOutputVector)
             for (auto& [slotID, slotData] : hitData["param"].items()) {
                 int slot = std::stoi(slotID);
                 if (slot >= 0 && slot < 20) {
-                    loadHitEntry(&slotData, &newHit.param[slot]);
+                    loadHitEntry(&slotData, &param[slot]);
                 }
             }
         }
 
+        for (int i = 0; i < 5; i++) {
+            newHit.commonIndex[i] = poolHitEntry(common[i], pEntryPool, poolIndexByEntry);
+        }
+        for (int i = 0; i < 20; i++) {
+            newHit.paramIndex[i] = poolHitEntry(param[i], pEntryPool, poolIndexByEntry);
+        }
+
         pOutputVector->push_back(newHit);
     }
+
+    for (auto& hit : *pOutputVector) {
+        hit.pEntryPool = pEntryPool->data();
+    }
 }
 
 int countAtemis(nlohmann::json* pAtemiJson)
@@ -1115,7 +1199,6 @@ void loadActionsFromMoves(nlohmann::json* pMovesJson, CharacterData* pRet, std::
 
         newAction.actionID = (*pFab)["ActionID"];
         newAction.styleID = key.value("_PL_StyleID", 0);
-        newAction.name = keyID;
 
         newAction.activeFrame = (*pFab)["ActionFrame"]["MainFrame"];
         newAction.recoveryStartFrame = (*pFab)["ActionFrame"]["FollowFrame"];
@@ -1164,135 +1247,155 @@ void loadActionsFromMoves(nlohmann::json* pMovesJson, CharacterData* pRet, std::
             }
         }
 
+        size_t first = pRet->hurtBoxKeyArena.size();
         if (key.contains("DamageCollisionKey")) {
-            newAction.hurtBoxKeys.reserve(key["DamageCollisionKey"].size() - 1);
-            loadHurtBoxKeys(&key["DamageCollisionKey"], &newAction.hurtBoxKeys, rectsByIDs, atemiByID);
+            loadHurtBoxKeys(&key["DamageCollisionKey"], &pRet->hurtBoxKeyArena, &pRet->rectRefArena, rectsByIDs, atemiByID);
         }
+        newAction.hurtBoxKeys = arenaSpanSince(pRet->hurtBoxKeyArena, first);
 
+        first = pRet->pushBoxKeyArena.size();
         if (key.contains("PushCollisionKey")) {
-            newAction.pushBoxKeys.reserve(key["PushCollisionKey"].size() - 1);
-            loadPushBoxKeys(&key["PushCollisionKey"], &newAction.pushBoxKeys, rectsByIDs);
+            loadPushBoxKeys(&key["PushCollisionKey"], &pRet->pushBoxKeyArena, rectsByIDs);
         }
+        newAction.pushBoxKeys = arenaSpanSince(pRet->pushBoxKeyArena, first);
 
-        size_t hitBoxKeyCount = 0;
-        if (key.contains("AttackCollisionKey")) {
-            hitBoxKeyCount += key["AttackCollisionKey"].size() - 1;
-        }
+        first = pRet->hitBoxKeyArena.size();
         if (key.contains("OtherCollisionKey")) {
-            hitBoxKeyCount += key["OtherCollisionKey"].size() - 1;
-        }
-        newAction.hitBoxKeys.reserve(hitBoxKeyCount);
-
-        if (key.contains("OtherCollisionKey")) {
-            loadHitBoxKeys(&key["OtherCollisionKey"], &newAction.hitBoxKeys, rectsByIDs, true, hitByID);
+            loadHitBoxKeys(&key["OtherCollisionKey"], &pRet->hitBoxKeyArena, &pRet->rectRefArena, rectsByIDs, true, hitByID);
         }
         if (key.contains("AttackCollisionKey")) {
-            loadHitBoxKeys(&key["AttackCollisionKey"], &newAction.hitBoxKeys, rectsByIDs, false, hitByID);
+            loadHitBoxKeys(&key["AttackCollisionKey"], &pRet->hitBoxKeyArena, &pRet->rectRefArena, rectsByIDs, false, hitByID);
         }
+        newAction.hitBoxKeys = arenaSpanSince(pRet->hitBoxKeyArena, first);
 
+        first = pRet->uniqueBoxKeyArena.size();
         if (key.contains("UniqueCollisionKey")) {
-            newAction.uniqueBoxKeys.reserve(key["UniqueCollisionKey"].size() - 1);
-            loadUniqueBoxKeys(&key["UniqueCollisionKey"], &newAction.uniqueBoxKeys, rectsByIDs);
-        }
-
-        size_t steerKeyCount = 0;
-        if (key.contains("SteerKey")) {
-            steerKeyCount += key["SteerKey"].size() - 1;
-        }
-        if (key.contains("DriveSteerKey")) {
-            steerKeyCount += key["DriveSteerKey"].size() - 1;
+            loadUniqueBoxKeys(&key["UniqueCollisionKey"], &pRet->uniqueBoxKeyArena, &pRet->uniqueBoxOpArena, &pRet->rectRefArena, rectsByIDs);
         }
-        newAction.steerKeys.reserve(steerKeyCount);
+        newAction.uniqueBoxKeys = arenaSpanSince(pRet->uniqueBoxKeyArena, first);
 
+        first = pRet->steerKeyArena.size();
         if (key.contains("SteerKey")) {
-            loadSteerKeys(&key["SteerKey"], &newAction.steerKeys, false);
+            loadSteerKeys(&key["SteerKey"], &pRet->steerKeyArena, false);
         }
         if (key.contains("DriveSteerKey")) {
-            loadSteerKeys(&key["DriveSteerKey"], &newAction.steerKeys, true);
-        }
-
-        size_t placeKeyCount = 0;
-        if (key.contains("PlaceKey")) {
-            placeKeyCount += key["PlaceKey"].size() - 1;
+            loadSteerKeys(&key["DriveSteerKey"], &pRet->steerKeyArena, true);
         }
-        if (key.contains("BGPlaceKey")) {
-            placeKeyCount += key["BGPlaceKey"].size() - 1;
-        }
-        newAction.placeKeys.reserve(placeKeyCount);
+        newAction.steerKeys = arenaSpanSince(pRet->steerKeyArena, first);
 
+        first = pRet->placeKeyArena.size();
         if (key.contains("PlaceKey")) {
-            loadPlaceKeys(&key["PlaceKey"], &newAction.placeKeys, false);
+            loadPlaceKeys(&key["PlaceKey"], &pRet->placeKeyArena, &pRet->placeKeyPosArena, false);
         }
         if (key.contains("BGPlaceKey")) {
-            loadPlaceKeys(&key["BGPlaceKey"], &newAction.placeKeys, true);
-        }
-
-        size_t switchKeyCount = 0;
-        if (key.contains("SwitchKey")) {
-            switchKeyCount += key["SwitchKey"].size() - 1;
-        }
-        if (key.contains("ExtSwitchKey")) {
-            switchKeyCount += key["ExtSwitchKey"].size() - 1;
+            loadPlaceKeys(&key["BGPlaceKey"], &pRet->placeKeyArena, &pRet->placeKeyPosArena, true);
         }
-        newAction.switchKeys.reserve(switchKeyCount);
+        newAction.placeKeys = arenaSpanSince(pRet->placeKeyArena, first);
 
+        first = pRet->switchKeyArena.size();
         if (key.contains("SwitchKey")) {
-            loadSwitchKeys(&key["SwitchKey"], &newAction.switchKeys);
+            loadSwitchKeys(&key["SwitchKey"], &pRet->switchKeyArena);
         }
         if (key.contains("ExtSwitchKey")) {
-            loadSwitchKeys(&key["ExtSwitchKey"], &newAction.switchKeys);
+            loadSwitchKeys(&key["ExtSwitchKey"], &pRet->switchKeyArena);
         }
+        newAction.switchKeys = arenaSpanSince(pRet->switchKeyArena, first);
 
+        first = pRet->eventKeyArena.size();
         if (key.contains("EventKey")) {
-            newAction.eventKeys.reserve(key["EventKey"].size() - 1);
-            loadEventKeys(&key["EventKey"], &newAction.eventKeys);
+            loadEventKeys(&key["EventKey"], &pRet->eventKeyArena);
         }
+        newAction.eventKeys = arenaSpanSince(pRet->eventKeyArena, first);
 
+        first = pRet->worldKeyArena.size();
         if (key.contains("WorldKey")) {
-            newAction.worldKeys.reserve(key["WorldKey"].size() - 1);
-            loadWorldKeys(&key["WorldKey"], &newAction.worldKeys);
+            loadWorldKeys(&key["WorldKey"], &pRet->worldKeyArena);
         }
+        newAction.worldKeys = arenaSpanSince(pRet->worldKeyArena, first);
 
+        first = pRet->lockKeyArena.size();
         if (key.contains("LockKey")) {
-            newAction.lockKeys.reserve(key["LockKey"].size() - 1);
-            loadLockKeys(&key["LockKey"], &newAction.lockKeys, hitByID);
+            loadLockKeys(&key["LockKey"], &pRet->lockKeyArena, hitByID);
         }
+        newAction.lockKeys = arenaSpanSince(pRet->lockKeyArena, first);
 
+        first = pRet->branchKeyArena.size();
         if (key.contains("BranchKey")) {
-            newAction.branchKeys.reserve(key["BranchKey"].size() - 1);
-            loadBranchKeys(&key["BranchKey"], &newAction.branchKeys);
+            loadBranchKeys(&key["BranchKey"], &pRet->branchKeyArena, &pRet->branchTypeNames);
         }
+        newAction.branchKeys = arenaSpanSince(pRet->branchKeyArena, first);
 
+        first = pRet->shotKeyArena.size();
         if (key.contains("ShotKey")) {
-            newAction.shotKeys.reserve(key["ShotKey"].size() - 1);
-            loadShotKeys(&key["ShotKey"], &newAction.shotKeys);
+            loadShotKeys(&key["ShotKey"], &pRet->shotKeyArena);
         }
+        newAction.shotKeys = arenaSpanSince(pRet->shotKeyArena, first);
 
+        first = pRet->triggerKeyArena.size();
         if (key.contains("TriggerKey")) {
-            newAction.triggerKeys.reserve(key["TriggerKey"].size() - 1);
-            loadTriggerKeys(&key["TriggerKey"], &newAction.triggerKeys, triggerGroupByID);
+            loadTriggerKeys(&key["TriggerKey"], &pRet->triggerKeyArena, triggerGroupByID);
         }
+        newAction.triggerKeys = arenaSpanSince(pRet->triggerKeyArena, first);
 
+        first = pRet->statusKeyArena.size();
         if (key.contains("StatusKey")) {
-            newAction.statusKeys.reserve(key["StatusKey"].size() - 1);
-            loadStatusKeys(&key["StatusKey"], &newAction.statusKeys);
+            loadStatusKeys(&key["StatusKey"], &pRet->statusKeyArena);
         }
+        newAction.statusKeys = arenaSpanSince(pRet->statusKeyArena, first);
 
         pRet->actions.push_back(newAction);
+        pRet->actionNames.push_back({keyID, ""});
+    }
+}
+
+void ResolveKeyArenas(CharacterData *pCharData)
+{
+    for (auto& action : pCharData->actions) {
+        resolveKeySpan(action.hurtBoxKeys, pCharData->hurtBoxKeyArena);
+        resolveKeySpan(action.pushBoxKeys, pCharData->pushBoxKeyArena);
+        resolveKeySpan(action.hitBoxKeys, pCharData->hitBoxKeyArena);
+        resolveKeySpan(action.uniqueBoxKeys, pCharData->uniqueBoxKeyArena);
+        resolveKeySpan(action.steerKeys, pCharData->steerKeyArena);
+        resolveKeySpan(action.placeKeys, pCharData->placeKeyArena);
+        resolveKeySpan(action.switchKeys, pCharData->switchKeyArena);
+        resolveKeySpan(action.eventKeys, pCharData->eventKeyArena);
+        resolveKeySpan(action.worldKeys, pCharData->worldKeyArena);
+        resolveKeySpan(action.lockKeys, pCharData->lockKeyArena);
+        resolveKeySpan(action.branchKeys, pCharData->branchKeyArena);
+        resolveKeySpan(action.shotKeys, pCharData->shotKeyArena);
+        resolveKeySpan(action.triggerKeys, pCharData->triggerKeyArena);
+        resolveKeySpan(action.statusKeys, pCharData->statusKeyArena);
+    }
+    for (auto& k : pCharData->hurtBoxKeyArena) {
+        resolveKeySpan(k.headRects, pCharData->rectRefArena);
+        resolveKeySpan(k.bodyRects, pCharData->rectRefArena);
+        resolveKeySpan(k.legRects, pCharData->rectRefArena);
+        resolveKeySpan(k.throwRects, pCharData->rectRefArena);
+    }
+    for (auto& k : pCharData->hitBoxKeyArena) {
+        resolveKeySpan(k.rects, pCharData->rectRefArena);
+    }
+    for (auto& k : pCharData->uniqueBoxKeyArena) {
+        resolveKeySpan(k.ops, pCharData->uniqueBoxOpArena);
+        resolveKeySpan(k.rects, pCharData->rectRefArena);
+    }
+    for (auto& k : pCharData->placeKeyArena) {
+        resolveKeySpan(k.posList, pCharData->placeKeyPosArena);
     }
 }
 
 void ProcessDynamicCharData(CharacterData *pCharData)
 {
     bool foundWallJump = false;
-    for (auto & action : pCharData->actions) {
-        std::string strNiceName = action.name;
+    for (size_t i = 0; i < pCharData->actions.size(); i++) {
+        Action &action = pCharData->actions[i];
+        std::string strNiceName = pCharData->actionNames[i].name;
         for (auto sub : {"BAS_", "ATK_", "SPA_", "_START"}) {
             std::string::size_type pos;
             while ((pos = strNiceName.find(sub)) != std::string::npos)
             strNiceName.erase(pos, strlen(sub));
         }
-        action.niceNameDyn = strNiceName;
+        pCharData->actionNames[i].niceNameDyn = strNiceName;
         if (action.actionID == 47 && !action.common) {
             foundWallJump = true;
         }
@@ -1304,30 +1407,29 @@ void ProcessDynamicCharData(CharacterData *pCharData)
     }
 }
 
-CharacterData *loadCharacter(std::string charName, int charVersion)
+static CharacterData *loadCharacterUncached(const std::string &charName, int charVersion, std::vector<std::string> &usedFiles)
 {
-    std::string charSpec = charName + std::to_string(charVersion);
-    std::string cookedPath = "data/cooked/" + charSpec + ".bin";
+    std::string cookedPath = "data/cooked/" + charName + std::to_string(charVersion) + ".bin";
     if (std::filesystem::exists(cookedPath)) {
-        if (mapCharDataLoader.find(charSpec) == mapCharDataLoader.end()) {
-            mapCharDataLoader[charSpec] = loadCookedCharacter(cookedPath, charVersion);
+        CharacterData *pCooked = loadCookedCharacter(cookedPath, charVersion);
+        if (pCooked) {
+            return pCooked;
         }
-        return mapCharDataLoader[charSpec];
     }
 
-    nlohmann::json *pMovesDictJson = loadCharFile(charName, charVersion, "moves");
-    nlohmann::json *pRectsJson = loadCharFile(charName, charVersion, "rects");
-    nlohmann::json *pTriggerGroupsJson = loadCharFile(charName, charVersion, "trigger_groups");
-    nlohmann::json *pTriggersJson = loadCharFile(charName, charVersion, "triggers");
-    nlohmann::json *pCommandsJson = loadCharFile(charName, charVersion, "commands");
-    nlohmann::json *pChargeJson = loadCharFile(charName, charVersion, "charge");
-    nlohmann::json *pHitJson = loadCharFile(charName, charVersion, "hit");
-    nlohmann::json *pAtemiJson = loadCharFile(charName, charVersion, "atemi");
-    nlohmann::json *pCharInfoJson = loadCharFile(charName, charVersion, "charinfo");
+    std::shared_ptr<nlohmann::json> pMovesDictJson = loadCharFile(charName, charVersion, "moves", &usedFiles);
+    std::shared_ptr<nlohmann::json> pRectsJson = loadCharFile(charName, charVersion, "rects", &usedFiles);
+    std::shared_ptr<nlohmann::json> pTriggerGroupsJson = loadCharFile(charName, charVersion, "trigger_groups", &usedFiles);
+    std::shared_ptr<nlohmann::json> pTriggersJson = loadCharFile(charName, charVersion, "triggers", &usedFiles);
+    std::shared_ptr<nlohmann::json> pCommandsJson = loadCharFile(charName, charVersion, "commands", &usedFiles);
+    std::shared_ptr<nlohmann::json> pChargeJson = loadCharFile(charName, charVersion, "charge", &usedFiles);
+    std::shared_ptr<nlohmann::json> pHitJson = loadCharFile(charName, charVersion, "hit", &usedFiles);
+    std::shared_ptr<nlohmann::json> pAtemiJson = loadCharFile(charName, charVersion, "atemi", &usedFiles);
+    std::shared_ptr<nlohmann::json> pCharInfoJson = loadCharFile(charName, charVersion, "charinfo", &usedFiles);
 
-    nlohmann::json *pCommonMovesJson = loadCharFile("common", charVersion, "moves");
-    nlohmann::json *pCommonRectsJson = loadCharFile("common", charVersion, "rects");
-    nlohmann::json *pCommonAtemiJson = loadCharFile("common", charVersion, "atemi");
+    std::shared_ptr<nlohmann::json> pCommonMovesJson = loadCharFile("common", charVersion, "moves", &usedFiles);
+    std::shared_ptr<nlohmann::json> pCommonRectsJson = loadCharFile("common", charVersion, "rects", &usedFiles);
+    std::shared_ptr<nlohmann::json> pCommonAtemiJson = loadCharFile("common", charVersion, "atemi", &usedFiles);
 
     CharacterData *pRet = new CharacterData;
 
@@ -1341,20 +1443,20 @@ CharacterData *loadCharacter(std::string charName, int charVersion)
         pRet->flags = (*pCharInfoJson)["PlData"]["Attribute"];
     }
 
-    loadStyles(pCharInfoJson, &pRet->styles);
+    loadStyles(pCharInfoJson.get(), &pRet->styles);
 
-    loadCharges(pChargeJson, pRet);
-    loadCommands(pCommandsJson, pRet);
-    loadTriggers(pTriggersJson, pRet);
-    loadTriggerGroups(pTriggerGroupsJson, pRet);
+    loadCharges(pChargeJson.get(), pRet);
+    loadCommands(pCommandsJson.get(), pRet);
+    loadTriggers(pTriggersJson.get(), pRet);
+    loadTriggerGroups(pTriggerGroupsJson.get(), pRet);
 
     for (auto& triggerGroup : pRet->triggerGroups) {
         pRet->triggerGroupByID[triggerGroup.id] = &triggerGroup;
     }
 
-    pRet->rects.reserve(countRects(pCommonRectsJson) + countRects(pRectsJson));
-    loadRects(pCommonRectsJson, &pRet->rects);
-    loadRects(pRectsJson, &pRet->rects);
+    pRet->rects.reserve(countRects(pCommonRectsJson.get()) + countRects(pRectsJson.get()));
+    loadRects(pCommonRectsJson.get(), &pRet->rects);
+    loadRects(pRectsJson.get(), &pRet->rects);
 
     for (auto& rect : pRet->rects) {
         pRet->rectsByIDs[std::make_pair(rect.listID, rect.id)] = &rect;
@@ -1373,17 +1475,17 @@ CharacterData *loadCharacter(std::string charName, int charVersion)
 
 
     std::map<int, ProjectileData> uniqueProjectiles;
-    loadProjectileDatas(pMovesDictJson, &uniqueProjectiles);
-    loadProjectileDatas(pCommonMovesJson, &uniqueProjectiles);
+    loadProjectileDatas(pMovesDictJson.get(), &uniqueProjectiles);
+    loadProjectileDatas(pCommonMovesJson.get(), &uniqueProjectiles);
 
     pRet->projectileDatas.reserve(uniqueProjectiles.size());
     for (auto& [id, projData] : uniqueProjectiles) {
         pRet->projectileDatas.push_back(projData);
     }
 
-    pRet->atemis.reserve(countAtemis(pAtemiJson) + countAtemis(pCommonAtemiJson));
-    loadAtemis(pCommonAtemiJson, &pRet->atemis);
-    loadAtemis(pAtemiJson, &pRet->atemis);
+    pRet->atemis.reserve(countAtemis(pAtemiJson.get()) + countAtemis(pCommonAtemiJson.get()));
+    loadAtemis(pCommonAtemiJson.get(), &pRet->atemis);
+    loadAtemis(pAtemiJson.get(), &pRet->atemis);
 
     for (auto& atemi : pRet->atemis) {
         pRet->atemiByID[atemi.id] = &atemi;
@@ -1392,27 +1494,235 @@ CharacterData *loadCharacter(std::string charName, int charVersion)
     if (pHitJson) {
         pRet->hits.reserve(pHitJson->size());
     }
-    loadHits(pHitJson, &pRet->hits);
+    loadHits(pHitJson.get(), &pRet->hits, &pRet->hitEntryPool);
 
     for (auto& hit : pRet->hits) {
         pRet->hitByID[hit.id] = &hit;
     }
 
-    loadActionsFromMoves(pCommonMovesJson, pRet, pRet->rectsByIDs, pRet->atemiByID, pRet->hitByID, pRet->triggerGroupByID);
+    loadActionsFromMoves(pCommonMovesJson.get(), pRet, pRet->rectsByIDs, pRet->atemiByID, pRet->hitByID, pRet->triggerGroupByID);
     for (auto& action : pRet->actions) {
         action.common = true;
     }
-    loadActionsFromMoves(pMovesDictJson, pRet, pRet->rectsByIDs, pRet->atemiByID, pRet->hitByID, pRet->triggerGroupByID);
+    loadActionsFromMoves(pMovesDictJson.get(), pRet, pRet->rectsByIDs, pRet->atemiByID, pRet->hitByID, pRet->triggerGroupByID);
 
     for (auto& action : pRet->actions) {
         pRet->actionsByID[ActionRef(action.actionID, action.styleID)] = &action;
     }
 
+    ResolveKeyArenas(pRet);
     ProcessDynamicCharData(pRet);
 
     return pRet;
 }
 
+static std::shared_ptr<CharDataCacheEntry> getCharDataCacheEntry(const std::string &charSpec, bool create)
+{
+    std::scoped_lock lock(mutexCharDataLoader);
+    auto it = mapCharDataLoader.find(charSpec);
+    if (it != mapCharDataLoader.end()) {
+        return it->second;
+    }
+    if (!create) {
+        return nullptr;
+    }
+    auto pEntry = std::make_shared<CharDataCacheEntry>();
+    mapCharDataLoader[charSpec] = pEntry;
+    return pEntry;
+}
+
+std::shared_ptr<CharacterData> loadCharacter(const std::string &charName, int charVersion)
+{
+    std::string charSpec = charName + std::to_string(charVersion);
+    std::shared_ptr<CharDataCacheEntry> pEntry = getCharDataCacheEntry(charSpec, true);
+
+    // if the load throws, the flag stays unset and the next caller retries -
+    // the entry remembers the failure so pollers can stop waiting on it
+    std::call_once(pEntry->loadOnce, [&]() {
+        std::vector<std::string> usedFiles;
+        try {
+            pEntry->pData.reset(loadCharacterUncached(charName, charVersion, usedFiles));
+        } catch (...) {
+            pEntry->failed = true;
+            throw;
+        }
+
+        // nothing needs the character's own json once the data is built,
+        // only the common files get shared with other characters' loads
+        std::vector<std::string> ownFiles;
+        for (std::string &fileName : usedFiles) {
+            if (fileName.starts_with("common")) {
+                pEntry->commonFiles.push_back(std::move(fileName));
+            } else {
+                ownFiles.push_back(std::move(fileName));
+            }
+        }
+        {
+            std::scoped_lock lock(mutexCharFileLoader);
+            for (const std::string &fileName : ownFiles) {
+                mapCharFileLoader.erase(fileName);
+            }
+        }
+        pEntry->failed = false;
+        pEntry->loaded = true;
+    });
+
+    return pEntry->pData;
+}
+
+bool preloadCharacter(const std::string &charName, int charVersion)
+{
+    return loadCharacter(charName, charVersion) != nullptr;
+}
+
+bool isCharacterLoaded(const std::string &charName, int charVersion)
+{
+    std::shared_ptr<CharDataCacheEntry> pEntry = getCharDataCacheEntry(charName + std::to_string(charVersion), false);
+    return pEntry && pEntry->loaded;
+}
+
+bool isCharacterLoadFailed(const std::string &charName, int charVersion)
+{
+    std::shared_ptr<CharDataCacheEntry> pEntry = getCharDataCacheEntry(charName + std::to_string(charVersion), false);
+    return pEntry && pEntry->failed;
+}
+
+void evictCharacter(const std::string &charName, int charVersion)
+{
+    // sims that already hold the data keep it alive until they let go
+    std::vector<std::string> unusedCommonFiles;
+    {
+        std::scoped_lock lock(mutexCharDataLoader);
+        auto it = mapCharDataLoader.find(charName + std::to_string(charVersion));
+        if (it == mapCharDataLoader.end()) {
+            return;
+        }
+        if (it->second->loaded) {
+            unusedCommonFiles = it->second->commonFiles;
+        }
+        mapCharDataLoader.erase(it);
+
+        for (auto &[charSpec, pEntry] : mapCharDataLoader) {
+            if (!pEntry->loaded) {
+                continue;
+            }
+            std::erase_if(unusedCommonFiles, [&](const std::string &fileName) {
+                return std::find(pEntry->commonFiles.begin(), pEntry->commonFiles.end(), fileName) != pEntry->commonFiles.end();
+            });
+        }
+    }
+
+    std::scoped_lock lock(mutexCharFileLoader);
+    for (const std::string &fileName : unusedCommonFiles) {
+        mapCharFileLoader.erase(fileName);
+    }
+}
+
+void evictAllCharacters(void)
+{
+    {
+        std::scoped_lock lock(mutexCharDataLoader);
+        mapCharDataLoader.clear();
+    }
+    std::scoped_lock lock(mutexCharFileLoader);
+    mapCharFileLoader.clear();
+}
+
+// background preloading - a few workers pull char specs off a queue and run
+// them through loadCharacter so the cache is warm by the time a guy needs it
+struct CharacterPreloader {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<std::string, int>> queue;
+    std::unordered_set<std::string> pendingSpecs;
+    std::vector<std::thread> workers;
+    CharacterPreloadProgress progress;
+    bool stopping = false;
+
+    void WorkerLoop(void)
+    {
+        while (true) {
+            std::pair<std::string, int> request;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (stopping) {
+                    return;
+                }
+                request = queue.front();
+                queue.pop_front();
+                progress.loading = request.first + std::to_string(request.second);
+            }
+
+            try {
+                loadCharacter(request.first, request.second);
+            } catch (const std::exception &e) {
+                log("failed to preload " + request.first + std::to_string(request.second) + ": " + e.what());
+            }
+
+            std::scoped_lock lock(mutex);
+            pendingSpecs.erase(request.first + std::to_string(request.second));
+            progress.completed++;
+            if (pendingSpecs.empty()) {
+                progress.loading.clear();
+            }
+        }
+    }
+
+    ~CharacterPreloader()
+    {
+        {
+            std::scoped_lock lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+};
+
+static CharacterPreloader charPreloader;
+
+void requestCharacterPreload(const std::string &charName, int charVersion)
+{
+    // a failed load would just fail again, callers polling every frame
+    // shouldn't keep queueing it - evicting the character allows a retry
+    if (isCharacterLoaded(charName, charVersion) || isCharacterLoadFailed(charName, charVersion)) {
+        return;
+    }
+
+    std::string charSpec = charName + std::to_string(charVersion);
+    {
+        std::scoped_lock lock(charPreloader.mutex);
+        if (!charPreloader.pendingSpecs.insert(charSpec).second) {
+            return;
+        }
+        if (charPreloader.progress.completed == charPreloader.progress.requested) {
+            // previous batch is done, start counting a new one
+            charPreloader.progress.requested = 0;
+            charPreloader.progress.completed = 0;
+        }
+        charPreloader.progress.requested++;
+        charPreloader.queue.push_back({charName, charVersion});
+
+        if (charPreloader.workers.empty()) {
+            unsigned int workerCount = std::clamp(std::thread::hardware_concurrency(), 2u, 8u) - 1;
+            for (unsigned int i = 0; i < workerCount; i++) {
+                charPreloader.workers.emplace_back(&CharacterPreloader::WorkerLoop, &charPreloader);
+            }
+        }
+    }
+    charPreloader.cv.notify_one();
+}
+
+CharacterPreloadProgress getCharacterPreloadProgress(void)
+{
+    std::scoped_lock lock(charPreloader.mutex);
+    return charPreloader.progress;
+}
+
+static void writeU16(std::ofstream &f, uint16_t v) { f.write((char*)&v, 2); }
 static void writeU32(std::ofstream &f, uint32_t v) { f.write((char*)&v, 4); }
 static void writeU64(std::ofstream &f, uint64_t v) { f.write((char*)&v, 8); }
 static void writeI32(std::ofstream &f, int32_t v) { f.write((char*)&v, 4); }
@@ -1424,6 +1734,7 @@ static void writeString(std::ofstream &f, const std::string &s) {
     f.write(s.data(), s.size());
 }
 
+static uint16_t readU16(std::ifstream &f) { uint16_t v; f.read((char*)&v, 2); return v; }
 static uint32_t readU32(std::ifstream &f) { uint32_t v; f.read((char*)&v, 4); return v; }
 static uint64_t readU64(std::ifstream &f) { uint64_t v; f.read((char*)&v, 8); return v; }
 static int32_t readI32(std::ifstream &f) { int32_t v; f.read((char*)&v, 4); return v; }
@@ -1456,33 +1767,15 @@ static int32_t rectPtrToIndex(Rect* ptr, const std::vector<Rect>& rects) {
     return ptrToIndex(ptr, rects);
 }
 
-static int32_t hitEntryPtrToIndex(HitEntry* ptr, const std::vector<HitData>& hits) {
-    if (!ptr) return -1;
-    for (size_t i = 0; i < hits.size(); i++) {
-        for (int j = 0; j < 5; j++) {
-            if (&hits[i].common[j] == ptr) return (int32_t)(i * 25 + j);
-        }
-        for (int j = 0; j < 20; j++) {
-            if (&hits[i].param[j] == ptr) return (int32_t)(i * 25 + 5 + j);
-        }
-    }
-    return -1;
-}
-
-static HitEntry* indexToHitEntryPtr(int32_t idx, std::vector<HitData>& hits) {
-    if (idx < 0) return nullptr;
-    int hitIdx = idx / 25;
-    int slot = idx % 25;
-    if (hitIdx >= (int)hits.size()) return nullptr;
-    if (slot < 5) return &hits[hitIdx].common[slot];
-    return &hits[hitIdx].param[slot - 5];
-}
+// bump whenever the cooked layout changes, stale files get ignored
+static const uint32_t cookedFormatVersion = 4;
 
 bool cookCharacter(CharacterData* pData, const std::string& path)
 {
     std::ofstream f(path, std::ios::binary);
     if (!f) return false;
 
+    writeU32(f, cookedFormatVersion);
     writeString(f, pData->charName);
     writeI32(f, pData->charID);
     writeI32(f, pData->vitality);
@@ -1661,11 +1954,16 @@ bool cookCharacter(CharacterData* pData, const std::string& path)
         writeI32(f, e.wallDestY);
     };
 
+    writeU32(f, pData->hitEntryPool.size());
+    for (auto& entry : pData->hitEntryPool) {
+        writeHitEntry(entry);
+    }
+
     writeU32(f, pData->hits.size());
     for (auto& hit : pData->hits) {
         writeI32(f, hit.id);
-        for (int i = 0; i < 5; i++) writeHitEntry(hit.common[i]);
-        for (int i = 0; i < 20; i++) writeHitEntry(hit.param[i]);
+        for (int i = 0; i < 5; i++) writeU16(f, hit.commonIndex[i]);
+        for (int i = 0; i < 20; i++) writeU16(f, hit.paramIndex[i]);
     }
 
     writeU32(f, pData->styles.size());
@@ -1692,194 +1990,222 @@ bool cookCharacter(CharacterData* pData, const std::string& path)
         writeFixed(f, k.offsetY);
     };
 
-    auto writeRectPtrVec = [&](const std::vector<Rect*>& rects) {
-        writeU32(f, rects.size());
-        for (auto* r : rects) writeI32(f, rectPtrToIndex(r, pData->rects));
+    auto writeSpan = [&](const auto& span) {
+        writeU32(f, span.first);
+        writeU32(f, span.count);
     };
 
+    writeU32(f, pData->rectRefArena.size());
+    for (auto* r : pData->rectRefArena) writeI32(f, rectPtrToIndex(r, pData->rects));
+
+    writeU32(f, pData->uniqueBoxOpArena.size());
+    for (auto& op : pData->uniqueBoxOpArena) {
+        writeI32(f, op.op);
+        writeI32(f, op.opParam0);
+        writeI32(f, op.opParam1);
+        writeI32(f, op.opParam2);
+        writeI32(f, op.opParam3);
+        writeI32(f, op.opParam4);
+    }
+
+    writeU32(f, pData->placeKeyPosArena.size());
+    for (auto& pos : pData->placeKeyPosArena) {
+        writeI32(f, pos.frame);
+        writeFixed(f, pos.offset);
+    }
+
+    writeU32(f, pData->branchTypeNames.size());
+    for (auto& typeName : pData->branchTypeNames) {
+        writeString(f, typeName);
+    }
+
+    writeU32(f, pData->hurtBoxKeyArena.size());
+    for (auto& k : pData->hurtBoxKeyArena) {
+        writeBoxKeyBase(k);
+        writeBool(f, k.isArmor);
+        writeBool(f, k.isAtemi);
+        writeI32(f, ptrToIndex(k.pAtemiData, pData->atemis));
+        writeI32(f, k.immunity);
+        writeI32(f, k.flags);
+        writeSpan(k.headRects);
+        writeSpan(k.bodyRects);
+        writeSpan(k.legRects);
+        writeSpan(k.throwRects);
+    }
+
+    writeU32(f, pData->pushBoxKeyArena.size());
+    for (auto& k : pData->pushBoxKeyArena) {
+        writeBoxKeyBase(k);
+        writeI32(f, rectPtrToIndex(k.rect, pData->rects));
+    }
+
+    writeU32(f, pData->hitBoxKeyArena.size());
+    for (auto& k : pData->hitBoxKeyArena) {
+        writeBoxKeyBase(k);
+        writeI32(f, (int32_t)k.type);
+        writeI32(f, (int32_t)k.flags);
+        writeI32(f, ptrToIndex(k.pHitData, pData->hits));
+        writeBool(f, k.hasValidStyle);
+        writeI32(f, k.validStyle);
+        writeBool(f, k.hasHitID);
+        writeI32(f, k.hitID);
+        writeSpan(k.rects);
+    }
+
+    writeU32(f, pData->uniqueBoxKeyArena.size());
+    for (auto& k : pData->uniqueBoxKeyArena) {
+        writeBoxKeyBase(k);
+        writeI32(f, k.checkMask);
+        writeBool(f, k.uniquePitcher);
+        writeBool(f, k.applyOpToTarget);
+        writeSpan(k.ops);
+        writeSpan(k.rects);
+    }
+
+    writeU32(f, pData->steerKeyArena.size());
+    for (auto& k : pData->steerKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.operationType);
+        writeI32(f, k.valueType);
+        writeFixed(f, k.fixValue);
+        writeFixed(f, k.targetOffsetX);
+        writeFixed(f, k.targetOffsetY);
+        writeI32(f, k.shotCategory);
+        writeI32(f, k.targetType);
+        writeI32(f, k.calcValueFrame);
+        writeI32(f, k.multiValueType);
+        writeI32(f, k.param);
+        writeBool(f, k.isDrive);
+    }
+
+    writeU32(f, pData->placeKeyArena.size());
+    for (auto& k : pData->placeKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.optionFlag);
+        writeFixed(f, k.ratio);
+        writeI32(f, k.axis);
+        writeBool(f, k.bgOnly);
+        writeSpan(k.posList);
+    }
+
+    writeU32(f, pData->switchKeyArena.size());
+    for (auto& k : pData->switchKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.systemFlag);
+        writeI32(f, k.operationFlag);
+        writeI32(f, k.validStyle);
+    }
+
+    writeU32(f, pData->eventKeyArena.size());
+    for (auto& k : pData->eventKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.validStyle);
+        writeI32(f, k.type);
+        writeI32(f, k.id);
+        writeI64(f, k.param01);
+        writeI64(f, k.param02);
+        writeI64(f, k.param03);
+        writeI64(f, k.param04);
+        writeI64(f, k.param05);
+    }
+
+    writeU32(f, pData->worldKeyArena.size());
+    for (auto& k : pData->worldKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.type);
+        writeI32(f, k.flags);
+    }
+
+    writeU32(f, pData->lockKeyArena.size());
+    for (auto& k : pData->lockKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.type);
+        writeI32(f, k.param01);
+        writeI32(f, k.param02);
+        writeI32(f, k.param03);
+        writeI32(f, ptrToIndex(k.pHitEntry, pData->hitEntryPool));
+    }
+
+    writeU32(f, pData->branchKeyArena.size());
+    for (auto& k : pData->branchKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.type);
+        writeI64(f, k.param00);
+        writeI64(f, k.param01);
+        writeI64(f, k.param02);
+        writeI64(f, k.param03);
+        writeI64(f, k.param04);
+        writeI32(f, k.branchAction);
+        writeI32(f, k.branchFrame);
+        writeBool(f, k.keepFrame);
+        writeBool(f, k.keepPlace);
+        writeI32(f, k.typeNameIndex);
+    }
+
+    writeU32(f, pData->shotKeyArena.size());
+    for (auto& k : pData->shotKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.validStyle);
+        writeI32(f, k.operation);
+        writeI32(f, k.flags);
+        writeFixed(f, k.posOffsetX);
+        writeFixed(f, k.posOffsetY);
+        writeI32(f, k.actionId);
+        writeI32(f, k.styleIdx);
+    }
+
+    writeU32(f, pData->triggerKeyArena.size());
+    for (auto& k : pData->triggerKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.validStyle);
+        writeI32(f, k.other);
+        writeI32(f, k.condition);
+        writeI32(f, k.state);
+        writeI32(f, ptrToIndex(k.pTriggerGroup, pData->triggerGroups));
+    }
+
+    writeU32(f, pData->statusKeyArena.size());
+    for (auto& k : pData->statusKeyArena) {
+        writeI32(f, k.startFrame);
+        writeI32(f, k.endFrame);
+        writeI32(f, k.landingAdjust);
+        writeI32(f, k.poseStatus);
+        writeI32(f, k.actionStatus);
+        writeI32(f, k.jumpStatus);
+        writeI32(f, k.side);
+    }
+
     writeU32(f, pData->actions.size());
-    for (auto& action : pData->actions) {
+    for (size_t ai = 0; ai < pData->actions.size(); ai++) {
+        auto& action = pData->actions[ai];
         writeI32(f, action.actionID);
         writeI32(f, action.styleID);
-        writeString(f, action.name);
+        writeString(f, pData->actionNames[ai].name);
         writeBool(f, action.common);
 
-        writeU32(f, action.hurtBoxKeys.size());
-        for (auto& k : action.hurtBoxKeys) {
-            writeBoxKeyBase(k);
-            writeBool(f, k.isArmor);
-            writeBool(f, k.isAtemi);
-            writeI32(f, ptrToIndex(k.pAtemiData, pData->atemis));
-            writeI32(f, k.immunity);
-            writeI32(f, k.flags);
-            writeRectPtrVec(k.headRects);
-            writeRectPtrVec(k.bodyRects);
-            writeRectPtrVec(k.legRects);
-            writeRectPtrVec(k.throwRects);
-        }
-
-        writeU32(f, action.pushBoxKeys.size());
-        for (auto& k : action.pushBoxKeys) {
-            writeBoxKeyBase(k);
-            writeI32(f, rectPtrToIndex(k.rect, pData->rects));
-        }
-
-        writeU32(f, action.hitBoxKeys.size());
-        for (auto& k : action.hitBoxKeys) {
-            writeBoxKeyBase(k);
-            writeI32(f, (int32_t)k.type);
-            writeI32(f, (int32_t)k.flags);
-            writeI32(f, ptrToIndex(k.pHitData, pData->hits));
-            writeBool(f, k.hasValidStyle);
-            writeI32(f, k.validStyle);
-            writeBool(f, k.hasHitID);
-            writeI32(f, k.hitID);
-            writeRectPtrVec(k.rects);
-        }
-
-        writeU32(f, action.uniqueBoxKeys.size());
-        for (auto& k : action.uniqueBoxKeys) {
-            writeBoxKeyBase(k);
-            writeI32(f, k.checkMask);
-            writeBool(f, k.uniquePitcher);
-            writeBool(f, k.applyOpToTarget);
-            writeU32(f, k.ops.size());
-            for (auto& op : k.ops) {
-                writeI32(f, op.op);
-                writeI32(f, op.opParam0);
-                writeI32(f, op.opParam1);
-                writeI32(f, op.opParam2);
-                writeI32(f, op.opParam3);
-                writeI32(f, op.opParam4);
-            }
-            writeRectPtrVec(k.rects);
-        }
-
-        writeU32(f, action.steerKeys.size());
-        for (auto& k : action.steerKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.operationType);
-            writeI32(f, k.valueType);
-            writeFixed(f, k.fixValue);
-            writeFixed(f, k.targetOffsetX);
-            writeFixed(f, k.targetOffsetY);
-            writeI32(f, k.shotCategory);
-            writeI32(f, k.targetType);
-            writeI32(f, k.calcValueFrame);
-            writeI32(f, k.multiValueType);
-            writeI32(f, k.param);
-            writeBool(f, k.isDrive);
-        }
-
-        writeU32(f, action.placeKeys.size());
-        for (auto& k : action.placeKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.optionFlag);
-            writeFixed(f, k.ratio);
-            writeI32(f, k.axis);
-            writeBool(f, k.bgOnly);
-            writeU32(f, k.posList.size());
-            for (auto& pos : k.posList) {
-                writeI32(f, pos.frame);
-                writeFixed(f, pos.offset);
-            }
-        }
-
-        writeU32(f, action.switchKeys.size());
-        for (auto& k : action.switchKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.systemFlag);
-            writeI32(f, k.operationFlag);
-            writeI32(f, k.validStyle);
-        }
-
-        writeU32(f, action.eventKeys.size());
-        for (auto& k : action.eventKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.validStyle);
-            writeI32(f, k.type);
-            writeI32(f, k.id);
-            writeI64(f, k.param01);
-            writeI64(f, k.param02);
-            writeI64(f, k.param03);
-            writeI64(f, k.param04);
-            writeI64(f, k.param05);
-        }
-
-        writeU32(f, action.worldKeys.size());
-        for (auto& k : action.worldKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.type);
-            writeI32(f, k.flags);
-        }
-
-        writeU32(f, action.lockKeys.size());
-        for (auto& k : action.lockKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.type);
-            writeI32(f, k.param01);
-            writeI32(f, k.param02);
-            writeI32(f, k.param03);
-            writeI32(f, hitEntryPtrToIndex(k.pHitEntry, pData->hits));
-        }
-
-        writeU32(f, action.branchKeys.size());
-        for (auto& k : action.branchKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.type);
-            writeI64(f, k.param00);
-            writeI64(f, k.param01);
-            writeI64(f, k.param02);
-            writeI64(f, k.param03);
-            writeI64(f, k.param04);
-            writeI32(f, k.branchAction);
-            writeI32(f, k.branchFrame);
-            writeBool(f, k.keepFrame);
-            writeBool(f, k.keepPlace);
-            writeString(f, k.typeName);
-        }
-
-        writeU32(f, action.shotKeys.size());
-        for (auto& k : action.shotKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.validStyle);
-            writeI32(f, k.operation);
-            writeI32(f, k.flags);
-            writeFixed(f, k.posOffsetX);
-            writeFixed(f, k.posOffsetY);
-            writeI32(f, k.actionId);
-            writeI32(f, k.styleIdx);
-        }
-
-        writeU32(f, action.triggerKeys.size());
-        for (auto& k : action.triggerKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.validStyle);
-            writeI32(f, k.other);
-            writeI32(f, k.condition);
-            writeI32(f, k.state);
-            writeI32(f, ptrToIndex(k.pTriggerGroup, pData->triggerGroups));
-        }
-
-        writeU32(f, action.statusKeys.size());
-        for (auto& k : action.statusKeys) {
-            writeI32(f, k.startFrame);
-            writeI32(f, k.endFrame);
-            writeI32(f, k.landingAdjust);
-            writeI32(f, k.poseStatus);
-            writeI32(f, k.actionStatus);
-            writeI32(f, k.jumpStatus);
-            writeI32(f, k.side);
-        }
+        writeSpan(action.hurtBoxKeys);
+        writeSpan(action.pushBoxKeys);
+        writeSpan(action.hitBoxKeys);
+        writeSpan(action.uniqueBoxKeys);
+        writeSpan(action.steerKeys);
+        writeSpan(action.placeKeys);
+        writeSpan(action.switchKeys);
+        writeSpan(action.eventKeys);
+        writeSpan(action.worldKeys);
+        writeSpan(action.lockKeys);
+        writeSpan(action.branchKeys);
+        writeSpan(action.shotKeys);
+        writeSpan(action.triggerKeys);
+        writeSpan(action.statusKeys);
 
         writeI32(f, action.activeFrame);
         writeI32(f, action.recoveryStartFrame);
@@ -1912,6 +2238,7 @@ CharacterData* loadCookedCharacter(const std::string& path, int charVersion)
 {
     std::ifstream f(path, std::ios::binary);
     if (!f) return nullptr;
+    if (readU32(f) != cookedFormatVersion) return nullptr;
 
     CharacterData* pRet = new CharacterData;
 
@@ -2121,12 +2448,18 @@ CharacterData* loadCookedCharacter(const std::string& path, int charVersion)
         e.wallDestY = readI32(f);
     };
 
+    pRet->hitEntryPool.resize(readU32(f));
+    for (auto& entry : pRet->hitEntryPool) {
+        readHitEntry(entry);
+    }
+
     uint32_t hitCount = readU32(f);
     pRet->hits.resize(hitCount);
     for (auto& hit : pRet->hits) {
         hit.id = readI32(f);
-        for (int i = 0; i < 5; i++) readHitEntry(hit.common[i]);
-        for (int i = 0; i < 20; i++) readHitEntry(hit.param[i]);
+        for (int i = 0; i < 5; i++) hit.commonIndex[i] = readU16(f);
+        for (int i = 0; i < 20; i++) hit.paramIndex[i] = readU16(f);
+        hit.pEntryPool = pRet->hitEntryPool.data();
     }
 
     for (auto& hit : pRet->hits) {
@@ -2158,221 +2491,226 @@ CharacterData* loadCookedCharacter(const std::string& path, int charVersion)
         k.offsetY = readFixed(f);
     };
 
-    auto readRectPtrVec = [&](std::vector<Rect*>& rects) {
-        uint32_t count = readU32(f);
-        rects.resize(count);
-        for (auto& r : rects) r = indexToPtr(readI32(f), pRet->rects);
+    auto readSpan = [&](auto& span) {
+        span.first = readU32(f);
+        span.count = readU32(f);
     };
 
+    pRet->rectRefArena.resize(readU32(f));
+    for (auto& r : pRet->rectRefArena) r = indexToPtr(readI32(f), pRet->rects);
+
+    pRet->uniqueBoxOpArena.resize(readU32(f));
+    for (auto& op : pRet->uniqueBoxOpArena) {
+        op.op = readI32(f);
+        op.opParam0 = readI32(f);
+        op.opParam1 = readI32(f);
+        op.opParam2 = readI32(f);
+        op.opParam3 = readI32(f);
+        op.opParam4 = readI32(f);
+    }
+
+    pRet->placeKeyPosArena.resize(readU32(f));
+    for (auto& pos : pRet->placeKeyPosArena) {
+        pos.frame = readI32(f);
+        pos.offset = readFixed(f);
+    }
+
+    pRet->branchTypeNames.resize(readU32(f));
+    for (auto& typeName : pRet->branchTypeNames) {
+        typeName = readString(f);
+    }
+
+    pRet->hurtBoxKeyArena.resize(readU32(f));
+    for (auto& k : pRet->hurtBoxKeyArena) {
+        readBoxKeyBase(k);
+        k.isArmor = readBool(f);
+        k.isAtemi = readBool(f);
+        k.pAtemiData = indexToPtr(readI32(f), pRet->atemis);
+        k.immunity = readI32(f);
+        k.flags = readI32(f);
+        readSpan(k.headRects);
+        readSpan(k.bodyRects);
+        readSpan(k.legRects);
+        readSpan(k.throwRects);
+    }
+
+    pRet->pushBoxKeyArena.resize(readU32(f));
+    for (auto& k : pRet->pushBoxKeyArena) {
+        readBoxKeyBase(k);
+        k.rect = indexToPtr(readI32(f), pRet->rects);
+    }
+
+    pRet->hitBoxKeyArena.resize(readU32(f));
+    for (auto& k : pRet->hitBoxKeyArena) {
+        readBoxKeyBase(k);
+        k.type = (hitBoxType)readI32(f);
+        k.flags = (hitBoxFlags)readI32(f);
+        k.pHitData = indexToPtr(readI32(f), pRet->hits);
+        k.hasValidStyle = readBool(f);
+        k.validStyle = readI32(f);
+        k.hasHitID = readBool(f);
+        k.hitID = readI32(f);
+        readSpan(k.rects);
+    }
+
+    pRet->uniqueBoxKeyArena.resize(readU32(f));
+    for (auto& k : pRet->uniqueBoxKeyArena) {
+        readBoxKeyBase(k);
+        k.checkMask = readI32(f);
+        k.uniquePitcher = readBool(f);
+        k.applyOpToTarget = readBool(f);
+        readSpan(k.ops);
+        readSpan(k.rects);
+    }
+
+    pRet->steerKeyArena.resize(readU32(f));
+    for (auto& k : pRet->steerKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.operationType = readI32(f);
+        k.valueType = readI32(f);
+        k.fixValue = readFixed(f);
+        k.targetOffsetX = readFixed(f);
+        k.targetOffsetY = readFixed(f);
+        k.shotCategory = readI32(f);
+        k.targetType = readI32(f);
+        k.calcValueFrame = readI32(f);
+        k.multiValueType = readI32(f);
+        k.param = readI32(f);
+        k.isDrive = readBool(f);
+    }
+
+    pRet->placeKeyArena.resize(readU32(f));
+    for (auto& k : pRet->placeKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.optionFlag = readI32(f);
+        k.ratio = readFixed(f);
+        k.axis = readI32(f);
+        k.bgOnly = readBool(f);
+        readSpan(k.posList);
+    }
+
+    pRet->switchKeyArena.resize(readU32(f));
+    for (auto& k : pRet->switchKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.systemFlag = readI32(f);
+        k.operationFlag = readI32(f);
+        k.validStyle = readI32(f);
+    }
+
+    pRet->eventKeyArena.resize(readU32(f));
+    for (auto& k : pRet->eventKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.validStyle = readI32(f);
+        k.type = readI32(f);
+        k.id = readI32(f);
+        k.param01 = readI64(f);
+        k.param02 = readI64(f);
+        k.param03 = readI64(f);
+        k.param04 = readI64(f);
+        k.param05 = readI64(f);
+    }
+
+    pRet->worldKeyArena.resize(readU32(f));
+    for (auto& k : pRet->worldKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.type = readI32(f);
+        k.flags = readI32(f);
+    }
+
+    pRet->lockKeyArena.resize(readU32(f));
+    for (auto& k : pRet->lockKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.type = readI32(f);
+        k.param01 = readI32(f);
+        k.param02 = readI32(f);
+        k.param03 = readI32(f);
+        k.pHitEntry = indexToPtr(readI32(f), pRet->hitEntryPool);
+    }
+
+    pRet->branchKeyArena.resize(readU32(f));
+    for (auto& k : pRet->branchKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.type = readI32(f);
+        k.param00 = readI64(f);
+        k.param01 = readI64(f);
+        k.param02 = readI64(f);
+        k.param03 = readI64(f);
+        k.param04 = readI64(f);
+        k.branchAction = readI32(f);
+        k.branchFrame = readI32(f);
+        k.keepFrame = readBool(f);
+        k.keepPlace = readBool(f);
+        k.typeNameIndex = readI32(f);
+    }
+
+    pRet->shotKeyArena.resize(readU32(f));
+    for (auto& k : pRet->shotKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.validStyle = readI32(f);
+        k.operation = readI32(f);
+        k.flags = readI32(f);
+        k.posOffsetX = readFixed(f);
+        k.posOffsetY = readFixed(f);
+        k.actionId = readI32(f);
+        k.styleIdx = readI32(f);
+    }
+
+    pRet->triggerKeyArena.resize(readU32(f));
+    for (auto& k : pRet->triggerKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.validStyle = readI32(f);
+        k.other = readI32(f);
+        k.condition = readI32(f);
+        k.state = readI32(f);
+        k.pTriggerGroup = indexToPtr(readI32(f), pRet->triggerGroups);
+    }
+
+    pRet->statusKeyArena.resize(readU32(f));
+    for (auto& k : pRet->statusKeyArena) {
+        k.startFrame = readI32(f);
+        k.endFrame = readI32(f);
+        k.landingAdjust = readI32(f);
+        k.poseStatus = readI32(f);
+        k.actionStatus = readI32(f);
+        k.jumpStatus = readI32(f);
+        k.side = readI32(f);
+    }
+
     uint32_t actionCount = readU32(f);
     pRet->actions.resize(actionCount);
+    pRet->actionNames.resize(actionCount);
     std::vector<int32_t> actionProjIndices(actionCount);
-    std::vector<std::vector<int32_t>> actionLockKeyHitEntryIndices(actionCount);
-    std::vector<std::vector<int32_t>> actionTriggerKeyGroupIndices(actionCount);
 
     for (size_t ai = 0; ai < actionCount; ai++) {
         auto& action = pRet->actions[ai];
         action.actionID = readI32(f);
         action.styleID = readI32(f);
-        action.name = readString(f);
+        pRet->actionNames[ai].name = readString(f);
         action.common = readBool(f);
 
-        uint32_t hurtBoxKeyCount = readU32(f);
-        action.hurtBoxKeys.resize(hurtBoxKeyCount);
-        for (auto& k : action.hurtBoxKeys) {
-            readBoxKeyBase(k);
-            k.isArmor = readBool(f);
-            k.isAtemi = readBool(f);
-            k.pAtemiData = indexToPtr(readI32(f), pRet->atemis);
-            k.immunity = readI32(f);
-            k.flags = readI32(f);
-            readRectPtrVec(k.headRects);
-            readRectPtrVec(k.bodyRects);
-            readRectPtrVec(k.legRects);
-            readRectPtrVec(k.throwRects);
-        }
-
-        uint32_t pushBoxKeyCount = readU32(f);
-        action.pushBoxKeys.resize(pushBoxKeyCount);
-        for (auto& k : action.pushBoxKeys) {
-            readBoxKeyBase(k);
-            k.rect = indexToPtr(readI32(f), pRet->rects);
-        }
-
-        uint32_t hitBoxKeyCount = readU32(f);
-        action.hitBoxKeys.resize(hitBoxKeyCount);
-        for (auto& k : action.hitBoxKeys) {
-            readBoxKeyBase(k);
-            k.type = (hitBoxType)readI32(f);
-            k.flags = (hitBoxFlags)readI32(f);
-            k.pHitData = indexToPtr(readI32(f), pRet->hits);
-            k.hasValidStyle = readBool(f);
-            k.validStyle = readI32(f);
-            k.hasHitID = readBool(f);
-            k.hitID = readI32(f);
-            readRectPtrVec(k.rects);
-        }
-
-        uint32_t uniqueBoxKeyCount = readU32(f);
-        action.uniqueBoxKeys.resize(uniqueBoxKeyCount);
-        for (auto& k : action.uniqueBoxKeys) {
-            readBoxKeyBase(k);
-            k.checkMask = readI32(f);
-            k.uniquePitcher = readBool(f);
-            k.applyOpToTarget = readBool(f);
-            uint32_t opCount = readU32(f);
-            k.ops.resize(opCount);
-            for (auto& op : k.ops) {
-                op.op = readI32(f);
-                op.opParam0 = readI32(f);
-                op.opParam1 = readI32(f);
-                op.opParam2 = readI32(f);
-                op.opParam3 = readI32(f);
-                op.opParam4 = readI32(f);
-            }
-            readRectPtrVec(k.rects);
-        }
-
-        uint32_t steerKeyCount = readU32(f);
-        action.steerKeys.resize(steerKeyCount);
-        for (auto& k : action.steerKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.operationType = readI32(f);
-            k.valueType = readI32(f);
-            k.fixValue = readFixed(f);
-            k.targetOffsetX = readFixed(f);
-            k.targetOffsetY = readFixed(f);
-            k.shotCategory = readI32(f);
-            k.targetType = readI32(f);
-            k.calcValueFrame = readI32(f);
-            k.multiValueType = readI32(f);
-            k.param = readI32(f);
-            k.isDrive = readBool(f);
-        }
-
-        uint32_t placeKeyCount = readU32(f);
-        action.placeKeys.resize(placeKeyCount);
-        for (auto& k : action.placeKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.optionFlag = readI32(f);
-            k.ratio = readFixed(f);
-            k.axis = readI32(f);
-            k.bgOnly = readBool(f);
-            uint32_t posCount = readU32(f);
-            k.posList.resize(posCount);
-            for (auto& pos : k.posList) {
-                pos.frame = readI32(f);
-                pos.offset = readFixed(f);
-            }
-        }
-
-        uint32_t switchKeyCount = readU32(f);
-        action.switchKeys.resize(switchKeyCount);
-        for (auto& k : action.switchKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.systemFlag = readI32(f);
-            k.operationFlag = readI32(f);
-            k.validStyle = readI32(f);
-        }
-
-        uint32_t eventKeyCount = readU32(f);
-        action.eventKeys.resize(eventKeyCount);
-        for (auto& k : action.eventKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.validStyle = readI32(f);
-            k.type = readI32(f);
-            k.id = readI32(f);
-            k.param01 = readI64(f);
-            k.param02 = readI64(f);
-            k.param03 = readI64(f);
-            k.param04 = readI64(f);
-            k.param05 = readI64(f);
-        }
-
-        uint32_t worldKeyCount = readU32(f);
-        action.worldKeys.resize(worldKeyCount);
-        for (auto& k : action.worldKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.type = readI32(f);
-            k.flags = readI32(f);
-        }
-
-        uint32_t lockKeyCount = readU32(f);
-        action.lockKeys.resize(lockKeyCount);
-        actionLockKeyHitEntryIndices[ai].resize(lockKeyCount);
-        for (size_t li = 0; li < lockKeyCount; li++) {
-            auto& k = action.lockKeys[li];
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.type = readI32(f);
-            k.param01 = readI32(f);
-            k.param02 = readI32(f);
-            k.param03 = readI32(f);
-            actionLockKeyHitEntryIndices[ai][li] = readI32(f);
-        }
-
-        uint32_t branchKeyCount = readU32(f);
-        action.branchKeys.resize(branchKeyCount);
-        for (auto& k : action.branchKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.type = readI32(f);
-            k.param00 = readI64(f);
-            k.param01 = readI64(f);
-            k.param02 = readI64(f);
-            k.param03 = readI64(f);
-            k.param04 = readI64(f);
-            k.branchAction = readI32(f);
-            k.branchFrame = readI32(f);
-            k.keepFrame = readBool(f);
-            k.keepPlace = readBool(f);
-            k.typeName = readString(f);
-        }
-
-        uint32_t shotKeyCount = readU32(f);
-        action.shotKeys.resize(shotKeyCount);
-        for (auto& k : action.shotKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.validStyle = readI32(f);
-            k.operation = readI32(f);
-            k.flags = readI32(f);
-            k.posOffsetX = readFixed(f);
-            k.posOffsetY = readFixed(f);
-            k.actionId = readI32(f);
-            k.styleIdx = readI32(f);
-        }
-
-        uint32_t triggerKeyCount = readU32(f);
-        action.triggerKeys.resize(triggerKeyCount);
-        actionTriggerKeyGroupIndices[ai].resize(triggerKeyCount);
-        for (size_t ti = 0; ti < triggerKeyCount; ti++) {
-            auto& k = action.triggerKeys[ti];
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.validStyle = readI32(f);
-            k.other = readI32(f);
-            k.condition = readI32(f);
-            k.state = readI32(f);
-            actionTriggerKeyGroupIndices[ai][ti] = readI32(f);
-        }
-
-        uint32_t statusKeyCount = readU32(f);
-        action.statusKeys.resize(statusKeyCount);
-        for (auto& k : action.statusKeys) {
-            k.startFrame = readI32(f);
-            k.endFrame = readI32(f);
-            k.landingAdjust = readI32(f);
-            k.poseStatus = readI32(f);
-            k.actionStatus = readI32(f);
-            k.jumpStatus = readI32(f);
-            k.side = readI32(f);
-        }
+        readSpan(action.hurtBoxKeys);
+        readSpan(action.pushBoxKeys);
+        readSpan(action.hitBoxKeys);
+        readSpan(action.uniqueBoxKeys);
+        readSpan(action.steerKeys);
+        readSpan(action.placeKeys);
+        readSpan(action.switchKeys);
+        readSpan(action.eventKeys);
+        readSpan(action.worldKeys);
+        readSpan(action.lockKeys);
+        readSpan(action.branchKeys);
+        readSpan(action.shotKeys);
+        readSpan(action.triggerKeys);
+        readSpan(action.statusKeys);
 
         action.activeFrame = readI32(f);
         action.recoveryStartFrame = readI32(f);
@@ -2395,18 +2733,14 @@ CharacterData* loadCookedCharacter(const std::string& path, int charVersion)
 
     for (size_t ai = 0; ai < actionCount; ai++) {
         pRet->actions[ai].pProjectileData = indexToPtr(actionProjIndices[ai], pRet->projectileDatas);
-        for (size_t li = 0; li < pRet->actions[ai].lockKeys.size(); li++) {
-            pRet->actions[ai].lockKeys[li].pHitEntry = indexToHitEntryPtr(actionLockKeyHitEntryIndices[ai][li], pRet->hits);
-        }
-        for (size_t ti = 0; ti < pRet->actions[ai].triggerKeys.size(); ti++) {
-            pRet->actions[ai].triggerKeys[ti].pTriggerGroup = indexToPtr(actionTriggerKeyGroupIndices[ai][ti], pRet->triggerGroups);
-        }
     }
 
     for (auto& action : pRet->actions) {
         pRet->actionsByID[ActionRef(action.actionID, action.styleID)] = &action;
     }
 
+    ResolveKeyArenas(pRet);
+
     uint32_t moveListCount = readU32(f);
     pRet->vecMoveList.resize(moveListCount);
     for (auto& str : pRet->vecMoveList) {
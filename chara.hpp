@@ -1,7 +1,9 @@
 #pragma once
 
+#include <compare>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "json.hpp"
@@ -162,57 +164,67 @@ struct AtemiData {
     int superRatio;
 };
 
+// every field is 32 bits like in the game data, so nothing gets truncated on
+// the way in - the pool dedup is where the memory savings come from
 struct HitEntry {
-    int comboAdd;
-    int juggleFirst;
-    int juggleAdd;
-    int juggleLimit;
-    int hitStun;
-    int moveDestX;
-    int moveDestY;
-    int moveTime;
-    int curveOwnID;
-    int curveTargetID;
-    int dmgValue;
-    int recoverableDamage;
-    int focusGainOwn;
-    int focusGainTarget;
-    int superGainOwn;
-    int superGainTarget;
-    int parryGain;
-    int perfectParryGain;
-    int dmgType;
-    int dmgKind;
-    int dmgPower;
-    int moveType;
-    int floorTime;
-    int downTime;
-    int boundDest;
-    int throwRelease;
-    bool jimenBound;
-    bool kabeBound;
-    bool kabeTataki;
-    bool bombBurst;
-    int attr0;
-    int attr1;
-    int attr2;
-    int attr3;
-    int ext0;
-    int hitStopOwner;
-    int hitStopTarget;
-    int hitmark;
-    int floorDestX;
-    int floorDestY;
-    int wallTime;
-    int wallStop;
-    int wallDestX;
-    int wallDestY;
-};
-
+    int32_t dmgValue;
+    int32_t recoverableDamage;
+    int32_t focusGainOwn;
+    int32_t focusGainTarget;
+    int32_t superGainOwn;
+    int32_t superGainTarget;
+    int32_t parryGain;
+    int32_t perfectParryGain;
+    int32_t moveDestX;
+    int32_t moveDestY;
+    int32_t floorDestX;
+    int32_t floorDestY;
+    int32_t wallDestX;
+    int32_t wallDestY;
+    int32_t attr0;
+    int32_t attr1;
+    int32_t attr2;
+    int32_t attr3;
+    int32_t ext0;
+    int32_t comboAdd;
+    int32_t juggleFirst;
+    int32_t juggleAdd;
+    int32_t juggleLimit;
+    int32_t hitStun;
+    int32_t moveTime;
+    int32_t curveOwnID;
+    int32_t curveTargetID;
+    int32_t dmgType;
+    int32_t dmgKind;
+    int32_t dmgPower;
+    int32_t moveType;
+    int32_t floorTime;
+    int32_t downTime;
+    int32_t boundDest;
+    int32_t throwRelease;
+    int32_t hitStopOwner;
+    int32_t hitStopTarget;
+    int32_t hitmark;
+    int32_t wallTime;
+    int32_t wallStop;
+    bool jimenBound : 1;
+    bool kabeBound : 1;
+    bool kabeTataki : 1;
+    bool bombBurst : 1;
+
+    auto operator<=>(const HitEntry &other) const = default;
+};
+
+// entries are deduplicated into CharacterData::hitEntryPool, most slots of
+// most hits are identical so this is a fraction of storing them inline
 struct HitData {
     int id;
-    HitEntry common[5];
-    HitEntry param[20];
+    uint16_t commonIndex[5];
+    uint16_t paramIndex[20];
+    HitEntry *pEntryPool = nullptr;
+
+    inline HitEntry *common(int slot) const { return &pEntryPool[commonIndex[slot]]; }
+    inline HitEntry *param(int slot) const { return &pEntryPool[paramIndex[slot]]; }
 };
 
 struct UniqueBoxOp {
@@ -253,10 +265,10 @@ struct HurtBoxKey : BoxKey {
     int immunity;
     int flags;
 
-    std::vector<Rect *> headRects;
-    std::vector<Rect *> bodyRects;
-    std::vector<Rect *> legRects;
-    std::vector<Rect *> throwRects;
+    KeySpan<Rect *> headRects;
+    KeySpan<Rect *> bodyRects;
+    KeySpan<Rect *> legRects;
+    KeySpan<Rect *> throwRects;
 };
 
 struct PushBoxKey : BoxKey {
@@ -278,7 +290,7 @@ struct HitBoxKey : BoxKey {
     bool hasHitID = false;
     int hitID;
 
-    std::vector<Rect *> rects;
+    KeySpan<Rect *> rects;
 };
 
 struct UniqueBoxKey : BoxKey {
@@ -288,8 +300,8 @@ struct UniqueBoxKey : BoxKey {
     bool uniquePitcher = false;
     bool applyOpToTarget = false;
 
-    std::vector<UniqueBoxOp> ops;
-    std::vector<Rect *> rects;
+    KeySpan<UniqueBoxOp> ops;
+    KeySpan<Rect *> rects;
 };
 
 struct SteerKey : Key {
@@ -316,7 +328,7 @@ struct PlaceKey : Key {
     Fixed ratio = Fixed(0);
     int axis;
     bool bgOnly = false;
-    std::vector<PlaceKeyPos> posList;
+    KeySpan<PlaceKeyPos> posList;
 };
 
 struct SwitchKey : Key {
@@ -360,7 +372,7 @@ struct BranchKey : Key {
     int branchFrame;
     bool keepFrame;
     bool keepPlace;
-    std::string typeName;
+    int typeNameIndex = -1; // into CharacterData::branchTypeNames, only for logging
 };
 
 struct ShotKey : Key {
@@ -428,27 +440,31 @@ struct StyleData {
     int gaugeGainRatio = 100;
 };
 
+struct ActionNames {
+    std::string name;
+    std::string niceNameDyn;
+};
+
 struct Action {
     int actionID;
     int styleID;
-    std::string name;
-    std::string niceNameDyn;
     bool common = false;
 
-    std::vector<HurtBoxKey> hurtBoxKeys;
-    std::vector<PushBoxKey> pushBoxKeys;
-    std::vector<HitBoxKey> hitBoxKeys;
-    std::vector<UniqueBoxKey> uniqueBoxKeys;
-    std::vector<SteerKey> steerKeys;
-    std::vector<PlaceKey> placeKeys;
-    std::vector<SwitchKey> switchKeys;
-    std::vector<EventKey> eventKeys;
-    std::vector<WorldKey> worldKeys;
-    std::vector<LockKey> lockKeys;
-    std::vector<BranchKey> branchKeys;
-    std::vector<ShotKey> shotKeys;
-    std::vector<TriggerKey> triggerKeys;
-    std::vector<StatusKey> statusKeys;
+    // keys live in the per-type arenas in CharacterData
+    KeySpan<HurtBoxKey> hurtBoxKeys;
+    KeySpan<PushBoxKey> pushBoxKeys;
+    KeySpan<HitBoxKey> hitBoxKeys;
+    KeySpan<UniqueBoxKey> uniqueBoxKeys;
+    KeySpan<SteerKey> steerKeys;
+    KeySpan<PlaceKey> placeKeys;
+    KeySpan<SwitchKey> switchKeys;
+    KeySpan<EventKey> eventKeys;
+    KeySpan<WorldKey> worldKeys;
+    KeySpan<LockKey> lockKeys;
+    KeySpan<BranchKey> branchKeys;
+    KeySpan<ShotKey> shotKeys;
+    KeySpan<TriggerKey> triggerKeys;
+    KeySpan<StatusKey> statusKeys;
 
     int activeFrame;
     int recoveryStartFrame;
@@ -489,9 +505,36 @@ struct CharacterData {
     std::vector<ProjectileData> projectileDatas;
     std::vector<AtemiData> atemis;
     std::vector<HitData> hits;
+    std::vector<HitEntry> hitEntryPool;
     std::vector<StyleData> styles;
     std::vector<Action> actions;
 
+    // every action's keys of one type back to back, so walking the keys of the
+    // current action every frame stays inside one contiguous run
+    std::vector<HurtBoxKey> hurtBoxKeyArena;
+    std::vector<PushBoxKey> pushBoxKeyArena;
+    std::vector<HitBoxKey> hitBoxKeyArena;
+    std::vector<UniqueBoxKey> uniqueBoxKeyArena;
+    std::vector<SteerKey> steerKeyArena;
+    std::vector<PlaceKey> placeKeyArena;
+    std::vector<SwitchKey> switchKeyArena;
+    std::vector<EventKey> eventKeyArena;
+    std::vector<WorldKey> worldKeyArena;
+    std::vector<LockKey> lockKeyArena;
+    std::vector<BranchKey> branchKeyArena;
+    std::vector<ShotKey> shotKeyArena;
+    std::vector<TriggerKey> triggerKeyArena;
+    std::vector<StatusKey> statusKeyArena;
+    std::vector<Rect *> rectRefArena;
+    std::vector<UniqueBoxOp> uniqueBoxOpArena;
+    std::vector<PlaceKeyPos> placeKeyPosArena;
+
+    // cold, parallel to actions
+    std::vector<ActionNames> actionNames;
+    std::vector<std::string> branchTypeNames;
+
+    const ActionNames &getActionNames(const Action *pAction) const { return actionNames[pAction - actions.data()]; }
+
     std::map<int, TriggerGroup*> triggerGroupByID;
     std::map<std::pair<int, int>, Rect*> rectsByIDs;
     std::map<ActionRef, Action*> actionsByID;
@@ -499,8 +542,30 @@ struct CharacterData {
     std::map<int, HitData*> hitByID;
 
     std::vector<const char *> vecMoveList;
+
+    ~CharacterData() {
+        for (const char *moveName : vecMoveList) {
+            free((void *)moveName);
+        }
+    }
+};
+
+// cached, loads at most once per process - safe to call from any thread
+std::shared_ptr<CharacterData> loadCharacter(const std::string &charName, int charVersion);
+bool preloadCharacter(const std::string &charName, int charVersion);
+bool isCharacterLoaded(const std::string &charName, int charVersion);
+bool isCharacterLoadFailed(const std::string &charName, int charVersion);
+void evictCharacter(const std::string &charName, int charVersion);
+void evictAllCharacters(void);
+
+struct CharacterPreloadProgress {
+    int requested = 0;
+    int completed = 0;
+    std::string loading;
 };
 
-CharacterData *loadCharacter(std::string charName, int charVersion);
+// queues a load on the background workers, returns right away
+void requestCharacterPreload(const std::string &charName, int charVersion);
+CharacterPreloadProgress getCharacterPreloadProgress(void);
 bool cookCharacter(CharacterData* pData, const std::string& path);
 CharacterData* loadCookedCharacter(const std::string& path, int charVersion);
@@ -0,0 +1,589 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "chardiff.hpp"
+#include "chara.hpp"
+#include "main.hpp"
+
+// only the fields the loaders keep get compared, which already leaves out most
+// of what diff_moves.sh prunes (voice, vfx, wind, bone keys, joint and IK
+// params) - ids and BG place keys are skipped explicitly below
+
+class CharDiffer {
+public:
+    CharDiffer(const std::string &charName, std::vector<CharDiffEntry> &entries)
+        : charName(charName), entries(entries) {}
+
+    std::string moveName;
+
+    void add(const std::string &field, const std::string &was, const std::string &now)
+    {
+        entries.push_back({charName, moveName, field, was, now});
+    }
+
+    template<typename T>
+    void field(const std::string &name, T was, T now)
+    {
+        if (was != now) {
+            add(name, valueString(was), valueString(now));
+        }
+    }
+
+private:
+    std::string charName;
+    std::vector<CharDiffEntry> &entries;
+
+    template<typename T>
+    static std::string valueString(T value) { return std::to_string(value); }
+    static std::string valueString(bool value) { return value ? "true" : "false"; }
+    static std::string valueString(Fixed value) { return std::to_string(value.data / 65536.0); }
+};
+
+#define DIFF_FIELD(name, member) d.field(prefix + name, l.member, r.member)
+
+static std::string hitSlotName(int slot)
+{
+    std::string ret;
+    if ((slot & punish_counter) == punish_counter) {
+        ret += "punish counter ";
+    } else if (slot & counter) {
+        ret += "counter ";
+    } else if (slot & special) {
+        ret += "burnout ";
+    }
+    if ((slot & otg) == otg) {
+        ret += "otg ";
+    } else if (slot & crouch) {
+        ret += "crouch ";
+    } else if (slot & air) {
+        ret += "air ";
+    }
+    ret += (slot & block) ? "block" : "hit";
+    return ret;
+}
+
+static void diffHitEntry(CharDiffer &d, const std::string &prefix, const HitEntry &l, const HitEntry &r)
+{
+    if (l == r) {
+        return;
+    }
+    DIFF_FIELD("ComboAdd", comboAdd);
+    DIFF_FIELD("Juggle1st", juggleFirst);
+    DIFF_FIELD("JuggleAdd", juggleAdd);
+    DIFF_FIELD("JuggleLimit", juggleLimit);
+    DIFF_FIELD("HitStun", hitStun);
+    DIFF_FIELD("MoveDest.x", moveDestX);
+    DIFF_FIELD("MoveDest.y", moveDestY);
+    DIFF_FIELD("MoveTime", moveTime);
+    DIFF_FIELD("CurveTgtID", curveTargetID);
+    DIFF_FIELD("CurveOwnID", curveOwnID);
+    DIFF_FIELD("DmgValue", dmgValue);
+    DIFF_FIELD("DmgRecover", recoverableDamage);
+    DIFF_FIELD("FocusOwn", focusGainOwn);
+    DIFF_FIELD("FocusTgt", focusGainTarget);
+    DIFF_FIELD("SuperOwn", superGainOwn);
+    DIFF_FIELD("SuperTgt", superGainTarget);
+    DIFF_FIELD("DriveNorm", parryGain);
+    DIFF_FIELD("DriveJust", perfectParryGain);
+    DIFF_FIELD("DmgType", dmgType);
+    DIFF_FIELD("DmgKind", dmgKind);
+    DIFF_FIELD("DmgPower", dmgPower);
+    DIFF_FIELD("MoveType", moveType);
+    DIFF_FIELD("FloorTime", floorTime);
+    DIFF_FIELD("DownTime", downTime);
+    DIFF_FIELD("BoundDest", boundDest);
+    DIFF_FIELD("ThrowRelease", throwRelease);
+    d.field<bool>(prefix + "_jimen_bound", l.jimenBound, r.jimenBound);
+    d.field<bool>(prefix + "_kabe_bound", l.kabeBound, r.kabeBound);
+    d.field<bool>(prefix + "_kabe_tataki", l.kabeTataki, r.kabeTataki);
+    d.field<bool>(prefix + "_bomb_burst", l.bombBurst, r.bombBurst);
+    DIFF_FIELD("Attr0", attr0);
+    DIFF_FIELD("Attr1", attr1);
+    DIFF_FIELD("Attr2", attr2);
+    DIFF_FIELD("Attr3", attr3);
+    DIFF_FIELD("Ext0", ext0);
+    DIFF_FIELD("HitStopOwner", hitStopOwner);
+    DIFF_FIELD("HitStopTarget", hitStopTarget);
+    DIFF_FIELD("Hitmark", hitmark);
+    DIFF_FIELD("FloorDest.x", floorDestX);
+    DIFF_FIELD("FloorDest.y", floorDestY);
+    DIFF_FIELD("WallTime", wallTime);
+    DIFF_FIELD("WallStop", wallStop);
+    DIFF_FIELD("WallDest.x", wallDestX);
+    DIFF_FIELD("WallDest.y", wallDestY);
+}
+
+static void diffHitData(CharDiffer &d, const std::string &prefix, const HitData *pLeft, const HitData *pRight)
+{
+    if (!pLeft || !pRight) {
+        if (pLeft != pRight) {
+            d.add(prefix + "HitID", pLeft ? std::to_string(pLeft->id) : "none", pRight ? std::to_string(pRight->id) : "none");
+        }
+        return;
+    }
+    for (int i = 0; i < 5; i++) {
+        diffHitEntry(d, prefix + "common " + std::to_string(i) + " ", *pLeft->common(i), *pRight->common(i));
+    }
+    for (int i = 0; i < 20; i++) {
+        diffHitEntry(d, prefix + "on " + hitSlotName(i) + " ", *pLeft->param(i), *pRight->param(i));
+    }
+}
+
+static void diffRect(CharDiffer &d, const std::string &prefix, const Rect *pLeft, const Rect *pRight)
+{
+    if (!pLeft || !pRight) {
+        return;
+    }
+    const Rect &l = *pLeft;
+    const Rect &r = *pRight;
+    DIFF_FIELD("x", xOrig);
+    DIFF_FIELD("y", yOrig);
+    DIFF_FIELD("w", xRadius);
+    DIFF_FIELD("h", yRadius);
+}
+
+static void diffRects(CharDiffer &d, const std::string &prefix, const KeySpan<Rect *> &left, const KeySpan<Rect *> &right)
+{
+    d.field<int>(prefix + "count", left.size(), right.size());
+    for (uint32_t i = 0; i < std::min(left.size(), right.size()); i++) {
+        diffRect(d, prefix + std::to_string(i) + " ", left[i], right[i]);
+    }
+}
+
+template<typename T, typename F>
+static void diffKeys(CharDiffer &d, const std::string &prefix, const KeySpan<T> &left, const KeySpan<T> &right, F diffKey)
+{
+    d.field<int>(prefix + " count", left.size(), right.size());
+    for (uint32_t i = 0; i < std::min(left.size(), right.size()); i++) {
+        std::string keyPrefix = prefix + " " + std::to_string(i) + " ";
+        const T &l = left[i];
+        const T &r = right[i];
+        d.field(keyPrefix + "_StartFrame", l.startFrame, r.startFrame);
+        d.field(keyPrefix + "_EndFrame", l.endFrame, r.endFrame);
+        diffKey(keyPrefix, l, r);
+    }
+}
+
+static void diffBoxKey(CharDiffer &d, const std::string &prefix, const BoxKey &l, const BoxKey &r)
+{
+    DIFF_FIELD("_Condition", condition);
+    DIFF_FIELD("OffsetX", offsetX);
+    DIFF_FIELD("OffsetY", offsetY);
+}
+
+static void diffTrigger(CharDiffer &d, const std::string &prefix, const Trigger &l, const Trigger &r)
+{
+    DIFF_FIELD("action_id", actionID);
+    DIFF_FIELD("_ValidStyle", validStyles);
+    d.field(prefix + "command_no", l.pCommandClassic ? l.pCommandClassic->id : -1, r.pCommandClassic ? r.pCommandClassic->id : -1);
+    DIFF_FIELD("ok_key_flags", okKeyFlags);
+    DIFF_FIELD("ok_key_cond_flags", okCondFlags);
+    DIFF_FIELD("ng_key_flags", ngKeyFlags);
+    DIFF_FIELD("dc_exc_flags", dcExcFlags);
+    DIFF_FIELD("dc_inc_flags", dcIncFlags);
+    DIFF_FIELD("precede_time", precedingTime);
+    DIFF_FIELD("_UseUniqueParam", useUniqueParam);
+    DIFF_FIELD("_AdvanceCombo", advanceCombo);
+    DIFF_FIELD("cond_param_id", condParamID);
+    DIFF_FIELD("cond_param_ope", condParamOp);
+    DIFF_FIELD("cond_param_value", condParamValue);
+    DIFF_FIELD("limit_shot_num", limitShotCount);
+    DIFF_FIELD("limit_shot_category", limitShotCategory);
+    DIFF_FIELD("air_action_num", airActionCountLimit);
+    DIFF_FIELD("cond_vital_ope", vitalOp);
+    DIFF_FIELD("cond_vital_ratio", vitalRatio);
+    DIFF_FIELD("cond_range", rangeCondition);
+    DIFF_FIELD("cond_range_param", rangeParam);
+    DIFF_FIELD("state_condition", stateCondition);
+    DIFF_FIELD("needs_focus", needsFocus);
+    DIFF_FIELD("focus_consume", focusCost);
+    DIFF_FIELD("needs_gauge", needsGauge);
+    DIFF_FIELD("gauge_consume", gaugeCost);
+    DIFF_FIELD("combo_inst", comboInst);
+    DIFF_FIELD("combo_sa_scaling", comboSuperScaling);
+    DIFF_FIELD("flags", flags);
+}
+
+static void diffCommand(CharDiffer &d, const std::string &commandPrefix, const Command &left, const Command &right)
+{
+    d.field<int>(commandPrefix + "variant count", left.variants.size(), right.variants.size());
+    for (size_t v = 0; v < std::min(left.variants.size(), right.variants.size()); v++) {
+        std::string variantPrefix = commandPrefix + "variant " + std::to_string(v) + " ";
+        const CommandVariant &lv = left.variants[v];
+        const CommandVariant &rv = right.variants[v];
+        d.field(variantPrefix + "total_max_frame", lv.totalMaxFrames, rv.totalMaxFrames);
+        d.field<int>(variantPrefix + "input count", lv.inputs.size(), rv.inputs.size());
+        for (size_t i = 0; i < std::min(lv.inputs.size(), rv.inputs.size()); i++) {
+            std::string prefix = variantPrefix + "input " + std::to_string(i) + " ";
+            const CommandInput &l = lv.inputs[i];
+            const CommandInput &r = rv.inputs[i];
+            d.field<int>(prefix + "type", l.type, r.type);
+            DIFF_FIELD("frame_num", numFrames);
+            DIFF_FIELD("ok_key_flags", okKeyFlags);
+            DIFF_FIELD("ok_cond_flags", okCondFlags);
+            DIFF_FIELD("ng_key_flags", ngKeyFlags);
+            DIFF_FIELD("ng_cond_flags", ngCondFlags);
+            DIFF_FIELD("fail_key_flags", failKeyFlags);
+            DIFF_FIELD("fail_cond_flags", failCondFlags);
+            DIFF_FIELD("point", rotatePointsNeeded);
+            if (l.pCharge && r.pCharge) {
+                d.field(prefix + "charge_frame", l.pCharge->chargeFrames, r.pCharge->chargeFrames);
+                d.field(prefix + "keep_frame", l.pCharge->keepFrames, r.pCharge->keepFrames);
+            }
+        }
+    }
+}
+
+static void diffAction(CharDiffer &d, const Action &l, const Action &r)
+{
+    std::string prefix;
+
+    if (l.actionFrameDuration != r.actionFrameDuration) {
+        d.add("frames", std::to_string(l.actionFrameDuration), std::to_string(r.actionFrameDuration));
+    }
+    if (l.activeFrame != r.activeFrame || l.recoveryStartFrame != r.recoveryStartFrame) {
+        d.add("active", std::to_string(l.activeFrame) + "-" + std::to_string(l.recoveryStartFrame),
+              std::to_string(r.activeFrame) + "-" + std::to_string(r.recoveryStartFrame));
+    }
+    DIFF_FIELD("MarginFrame", recoveryEndFrame);
+    DIFF_FIELD("_LoopStart", loopPoint);
+    DIFF_FIELD("_LoopCount", loopCount);
+    DIFF_FIELD("_StartScaling", startScale);
+    DIFF_FIELD("ComboScaling", comboScale);
+    DIFF_FIELD("InstScaling", instantScale);
+    DIFF_FIELD("ActionFlags", actionFlags);
+    DIFF_FIELD("KindFlag", inheritKindFlag);
+    DIFF_FIELD("_HitID", inheritHitID);
+    DIFF_FIELD("Accelerate.x", inheritAccelX);
+    DIFF_FIELD("Accelerate.y", inheritAccelY);
+    DIFF_FIELD("Velocity.x", inheritVelX);
+    DIFF_FIELD("Velocity.y", inheritVelY);
+
+    if (l.pProjectileData && r.pProjectileData) {
+        const ProjectileData &lp = *l.pProjectileData;
+        const ProjectileData &rp = *r.pProjectileData;
+        std::string pp = "PROJ ";
+        d.field(pp + "HitCount", lp.hitCount, rp.hitCount);
+        d.field(pp + "HitStopExtend", lp.extraHitStop, rp.extraHitStop);
+        d.field(pp + "HitFlagToParent", lp.hitFlagToParent, rp.hitFlagToParent);
+        d.field(pp + "HitStopToParent", lp.hitStopToParent, rp.hitStopToParent);
+        d.field(pp + "RangeB", lp.rangeB, rp.rangeB);
+        d.field(pp + "WallBox.x", lp.wallBoxForward, rp.wallBoxForward);
+        d.field(pp + "WallBox.y", lp.wallBoxBack, rp.wallBoxBack);
+        d.field(pp + "AirborneFlag", lp.airborne, rp.airborne);
+        d.field(pp + "Flags", lp.flags, rp.flags);
+        d.field(pp + "FlagsExt", lp.flagsExt, rp.flagsExt);
+        d.field(pp + "Category", lp.category, rp.category);
+        d.field(pp + "ClashPriority", lp.clashPriority, rp.clashPriority);
+        d.field(pp + "NoPush", lp.noPush, rp.noPush);
+        d.field(pp + "LifeTime", lp.lifeTime, rp.lifeTime);
+        d.field(pp + "HitSpan", lp.hitSpan, rp.hitSpan);
+        d.field(pp + "HitDisableMovement", lp.hitDisableMovementFrames, rp.hitDisableMovementFrames);
+        d.field(pp + "HitStopOverride", lp.hitStopOverride, rp.hitStopOverride);
+    } else if (l.pProjectileData != r.pProjectileData) {
+        d.add("PROJ", l.pProjectileData ? "present" : "missing", r.pProjectileData ? "present" : "missing");
+    }
+
+    // hits keep the 'hit N' numbering of the old script, N being the hitbox key
+    diffKeys(d, "hit", l.hitBoxKeys, r.hitBoxKeys, [&d](const std::string &prefix, const HitBoxKey &l, const HitBoxKey &r) {
+        diffBoxKey(d, prefix, l, r);
+        d.field<int>(prefix + "CollisionType", l.type, r.type);
+        d.field<int>(prefix + "_Attribute", l.flags, r.flags);
+        DIFF_FIELD("_ValidStyle", validStyle);
+        DIFF_FIELD("HitID", hitID);
+        diffRects(d, prefix + "rect ", l.rects, r.rects);
+        diffHitData(d, prefix, l.pHitData, r.pHitData);
+    });
+    diffKeys(d, "hurtbox", l.hurtBoxKeys, r.hurtBoxKeys, [&d](const std::string &prefix, const HurtBoxKey &l, const HurtBoxKey &r) {
+        diffBoxKey(d, prefix, l, r);
+        DIFF_FIELD("armor", isArmor);
+        DIFF_FIELD("atemi", isAtemi);
+        DIFF_FIELD("_Immune", immunity);
+        DIFF_FIELD("TypeFlag", flags);
+        diffRects(d, prefix + "head ", l.headRects, r.headRects);
+        diffRects(d, prefix + "body ", l.bodyRects, r.bodyRects);
+        diffRects(d, prefix + "leg ", l.legRects, r.legRects);
+        diffRects(d, prefix + "throw ", l.throwRects, r.throwRects);
+    });
+    diffKeys(d, "pushbox", l.pushBoxKeys, r.pushBoxKeys, [&d](const std::string &prefix, const PushBoxKey &l, const PushBoxKey &r) {
+        diffBoxKey(d, prefix, l, r);
+        diffRect(d, prefix + "rect ", l.rect, r.rect);
+    });
+    diffKeys(d, "uniquebox", l.uniqueBoxKeys, r.uniqueBoxKeys, [&d](const std::string &prefix, const UniqueBoxKey &l, const UniqueBoxKey &r) {
+        diffBoxKey(d, prefix, l, r);
+        DIFF_FIELD("CheckMask", checkMask);
+        DIFF_FIELD("_UniquePitcher", uniquePitcher);
+        DIFF_FIELD("_ApplyTarget", applyOpToTarget);
+        d.field<int>(prefix + "op count", l.ops.size(), r.ops.size());
+        diffRects(d, prefix + "rect ", l.rects, r.rects);
+    });
+    diffKeys(d, "steer", l.steerKeys, r.steerKeys, [&d](const std::string &prefix, const SteerKey &l, const SteerKey &r) {
+        DIFF_FIELD("OperationType", operationType);
+        DIFF_FIELD("ValueType", valueType);
+        DIFF_FIELD("FixValue", fixValue);
+        DIFF_FIELD("FixTargetOffset.x", targetOffsetX);
+        DIFF_FIELD("FixTargetOffset.y", targetOffsetY);
+        DIFF_FIELD("ShotCategory", shotCategory);
+        DIFF_FIELD("TargetType", targetType);
+        DIFF_FIELD("CalcValueFrame", calcValueFrame);
+        DIFF_FIELD("MultiValueType", multiValueType);
+        DIFF_FIELD("Param", param);
+        DIFF_FIELD("_IsDrive", isDrive);
+    });
+    // BG place keys are camera only and pruned like the old script did
+    auto notBG = [](const KeySpan<PlaceKey> &keys) {
+        int count = 0;
+        for (const PlaceKey &key : keys) {
+            if (!key.bgOnly) count++;
+        }
+        return count;
+    };
+    d.field(prefix + "place count", notBG(l.placeKeys), notBG(r.placeKeys));
+    if (notBG(l.placeKeys) == notBG(r.placeKeys)) {
+        uint32_t li = 0, ri = 0;
+        int index = 0;
+        while (li < l.placeKeys.size() && ri < r.placeKeys.size()) {
+            if (l.placeKeys[li].bgOnly) { li++; continue; }
+            if (r.placeKeys[ri].bgOnly) { ri++; continue; }
+            const PlaceKey &lk = l.placeKeys[li++];
+            const PlaceKey &rk = r.placeKeys[ri++];
+            std::string pp = "place " + std::to_string(index++) + " ";
+            d.field(pp + "_StartFrame", lk.startFrame, rk.startFrame);
+            d.field(pp + "_EndFrame", lk.endFrame, rk.endFrame);
+            d.field(pp + "OptionFlag", lk.optionFlag, rk.optionFlag);
+            d.field(pp + "Ratio", lk.ratio, rk.ratio);
+            d.field(pp + "Axis", lk.axis, rk.axis);
+            d.field<int>(pp + "pos count", lk.posList.size(), rk.posList.size());
+            for (uint32_t i = 0; i < std::min(lk.posList.size(), rk.posList.size()); i++) {
+                d.field(pp + "pos " + std::to_string(i) + " offset", lk.posList[i].offset, rk.posList[i].offset);
+            }
+        }
+    }
+    diffKeys(d, "switch", l.switchKeys, r.switchKeys, [&d](const std::string &prefix, const SwitchKey &l, const SwitchKey &r) {
+        DIFF_FIELD("SystemFlag", systemFlag);
+        DIFF_FIELD("OperationFlag", operationFlag);
+        DIFF_FIELD("_ValidStyle", validStyle);
+    });
+    diffKeys(d, "event", l.eventKeys, r.eventKeys, [&d](const std::string &prefix, const EventKey &l, const EventKey &r) {
+        DIFF_FIELD("_ValidStyle", validStyle);
+        DIFF_FIELD("Type", type);
+        DIFF_FIELD("ID", id);
+        DIFF_FIELD("Param01", param01);
+        DIFF_FIELD("Param02", param02);
+        DIFF_FIELD("Param03", param03);
+        DIFF_FIELD("Param04", param04);
+        DIFF_FIELD("Param05", param05);
+    });
+    diffKeys(d, "world", l.worldKeys, r.worldKeys, [&d](const std::string &prefix, const WorldKey &l, const WorldKey &r) {
+        DIFF_FIELD("Type", type);
+        DIFF_FIELD("_Flags", flags);
+    });
+    diffKeys(d, "lock", l.lockKeys, r.lockKeys, [&d](const std::string &prefix, const LockKey &l, const LockKey &r) {
+        DIFF_FIELD("Type", type);
+        DIFF_FIELD("Param01", param01);
+        DIFF_FIELD("Param02", param02);
+        DIFF_FIELD("Param03", param03);
+        if (l.pHitEntry && r.pHitEntry) {
+            diffHitEntry(d, prefix, *l.pHitEntry, *r.pHitEntry);
+        }
+    });
+    diffKeys(d, "branch", l.branchKeys, r.branchKeys, [&d](const std::string &prefix, const BranchKey &l, const BranchKey &r) {
+        DIFF_FIELD("Type", type);
+        DIFF_FIELD("Param00", param00);
+        DIFF_FIELD("Param01", param01);
+        DIFF_FIELD("Param02", param02);
+        DIFF_FIELD("Param03", param03);
+        DIFF_FIELD("Param04", param04);
+        DIFF_FIELD("Action", branchAction);
+        DIFF_FIELD("ActionFrame", branchFrame);
+        DIFF_FIELD("KeepFrame", keepFrame);
+        DIFF_FIELD("KeepPlace", keepPlace);
+    });
+    diffKeys(d, "shot", l.shotKeys, r.shotKeys, [&d](const std::string &prefix, const ShotKey &l, const ShotKey &r) {
+        DIFF_FIELD("_ValidStyle", validStyle);
+        DIFF_FIELD("Operation", operation);
+        DIFF_FIELD("Flags", flags);
+        DIFF_FIELD("PosOffset.x", posOffsetX);
+        DIFF_FIELD("PosOffset.y", posOffsetY);
+        DIFF_FIELD("ActionId", actionId);
+        DIFF_FIELD("StyleIdx", styleIdx);
+    });
+    diffKeys(d, "trigger", l.triggerKeys, r.triggerKeys, [&d](const std::string &prefix, const TriggerKey &l, const TriggerKey &r) {
+        DIFF_FIELD("_ValidStyle", validStyle);
+        DIFF_FIELD("_Other", other);
+        DIFF_FIELD("_Condition", condition);
+        DIFF_FIELD("_State", state);
+        d.field(prefix + "TriggerGroup", l.pTriggerGroup ? l.pTriggerGroup->id : -1, r.pTriggerGroup ? r.pTriggerGroup->id : -1);
+    });
+    diffKeys(d, "status", l.statusKeys, r.statusKeys, [&d](const std::string &prefix, const StatusKey &l, const StatusKey &r) {
+        DIFF_FIELD("LandingAdjust", landingAdjust);
+        DIFF_FIELD("PoseStatus", poseStatus);
+        DIFF_FIELD("ActionStatus", actionStatus);
+        DIFF_FIELD("JumpStatus", jumpStatus);
+        DIFF_FIELD("Side", side);
+    });
+}
+
+// common and character moves can share key names, so common ones get a prefix,
+// and any name that's still taken gets numbered in load order rather than
+// overwriting the earlier action
+static std::map<std::string, const Action *> actionsByName(const CharacterData &data)
+{
+    std::map<std::string, const Action *> ret;
+    for (const Action &action : data.actions) {
+        std::string name = data.getActionNames(&action).name;
+        if (action.common) {
+            name = "common " + name;
+        }
+        std::string uniqueName = name;
+        for (int i = 2; ret.find(uniqueName) != ret.end(); i++) {
+            uniqueName = name + " #" + std::to_string(i);
+        }
+        ret[uniqueName] = &action;
+    }
+    return ret;
+}
+
+std::vector<CharDiffEntry> diffCharacterVersions(const std::string &charName, int oldVersion, int newVersion)
+{
+    std::vector<CharDiffEntry> entries;
+    std::shared_ptr<CharacterData> pLeft = loadCharacter(charName, oldVersion);
+    std::shared_ptr<CharacterData> pRight = loadCharacter(charName, newVersion);
+    CharDiffer d(charName, entries);
+
+    if (!pLeft || !pRight) {
+        d.add("data", pLeft ? "present" : "missing", pRight ? "present" : "missing");
+        return entries;
+    }
+
+    // actions are matched by key name, ids shift between versions
+    std::map<std::string, const Action *> rightActions = actionsByName(*pRight);
+    std::map<std::string, const Action *> leftActions = actionsByName(*pLeft);
+
+    for (auto &[name, pAction] : leftActions) {
+        d.moveName = name;
+        auto it = rightActions.find(name);
+        if (it == rightActions.end()) {
+            d.add("action", "present", "missing");
+            continue;
+        }
+        diffAction(d, *pAction, *it->second);
+    }
+    for (auto &[name, pAction] : rightActions) {
+        if (leftActions.find(name) == leftActions.end()) {
+            d.moveName = name;
+            d.add("action", "missing", "present");
+        }
+    }
+
+    d.moveName.clear();
+
+    std::map<int, const Trigger *> rightTriggers;
+    for (const Trigger &trigger : pRight->triggers) {
+        rightTriggers[trigger.id] = &trigger;
+    }
+    for (const Trigger &trigger : pLeft->triggers) {
+        std::string prefix = "trigger " + std::to_string(trigger.id) + " ";
+        auto it = rightTriggers.find(trigger.id);
+        if (it == rightTriggers.end()) {
+            d.add(prefix + "trigger", "present", "missing");
+            continue;
+        }
+        diffTrigger(d, prefix, trigger, *it->second);
+        rightTriggers.erase(it);
+    }
+    for (auto &[id, pTrigger] : rightTriggers) {
+        d.add("trigger " + std::to_string(id) + " trigger", "missing", "present");
+    }
+
+    std::map<int, const Command *> rightCommands;
+    for (const Command &command : pRight->commands) {
+        rightCommands[command.id] = &command;
+    }
+    for (const Command &command : pLeft->commands) {
+        std::string prefix = "command " + std::to_string(command.id) + " ";
+        auto it = rightCommands.find(command.id);
+        if (it == rightCommands.end()) {
+            d.add(prefix + "command", "present", "missing");
+            continue;
+        }
+        diffCommand(d, prefix, command, *it->second);
+        rightCommands.erase(it);
+    }
+    for (auto &[id, pCommand] : rightCommands) {
+        d.add("command " + std::to_string(id) + " command", "missing", "present");
+    }
+
+    return entries;
+}
+
+std::vector<CharDiffEntry> diffVersions(const std::vector<std::string> &charList, int oldVersion, int newVersion)
+{
+    if (charList.empty()) {
+        return {};
+    }
+
+    std::vector<std::vector<CharDiffEntry>> charEntries(charList.size());
+    std::atomic<size_t> nextChar = 0;
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = nextChar++) < charList.size()) {
+            charEntries[i] = diffCharacterVersions(charList[i], oldVersion, newVersion);
+            // the diff only needs each version once, don't keep 60 characters around
+            evictCharacter(charList[i], oldVersion);
+            evictCharacter(charList[i], newVersion);
+        }
+    };
+
+    size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, charList.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+
+    // output stays in roster order no matter which worker finished first
+    std::vector<CharDiffEntry> entries;
+    for (auto &charDiff : charEntries) {
+        entries.insert(entries.end(), charDiff.begin(), charDiff.end());
+    }
+    return entries;
+}
+
+std::string formatCharDiffEntry(const CharDiffEntry &entry)
+{
+    std::string ret = entry.charName;
+    if (!entry.moveName.empty()) {
+        ret += " " + entry.moveName;
+    }
+    if (entry.field == "frames") {
+        return ret + " was " + entry.was + " frames now " + entry.now;
+    }
+    if (entry.field == "active") {
+        return ret + " was active from " + entry.was + " now active from " + entry.now;
+    }
+    return ret + " " + entry.field + " was " + entry.was + ", now " + entry.now;
+}
+
+nlohmann::json charDiffEntriesToJson(const std::vector<CharDiffEntry> &entries)
+{
+    nlohmann::json ret = nlohmann::json::array();
+    for (const CharDiffEntry &entry : entries) {
+        nlohmann::json jsonEntry;
+        jsonEntry["char"] = entry.charName;
+        if (!entry.moveName.empty()) {
+            jsonEntry["move"] = entry.moveName;
+        }
+        jsonEntry["field"] = entry.field;
+        jsonEntry["was"] = entry.was;
+        jsonEntry["now"] = entry.now;
+        ret.push_back(jsonEntry);
+    }
+    return ret;
+}
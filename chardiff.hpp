@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+struct CharDiffEntry {
+    std::string charName;
+    std::string moveName; // empty for character wide data like triggers and commands
+    std::string field;
+    std::string was;
+    std::string now;
+};
+
+// loads both versions through the character cache and compares actions, hits,
+// triggers and commands - one worker per character
+std::vector<CharDiffEntry> diffCharacterVersions(const std::string &charName, int oldVersion, int newVersion);
+std::vector<CharDiffEntry> diffVersions(const std::vector<std::string> &charList, int oldVersion, int newVersion);
+
+std::string formatCharDiffEntry(const CharDiffEntry &entry);
+nlohmann::json charDiffEntriesToJson(const std::vector<CharDiffEntry> &entries);
@@ -0,0 +1,30 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "main.hpp"
+#include "batch.hpp"
+
+// headless entry point for batch servers, only links psychodrive_core
+int main(int argc, char **argv)
+{
+    srand(time(NULL));
+    makeCharEntries();
+
+    int exitCode = 0;
+    if (runBatchCommand(argc, argv, exitCode)) {
+        return exitCode;
+    }
+
+    fprintf(stderr, "usage: %s <command> [args]\n", argv[0]);
+    fprintf(stderr, "  run_dump <dump> [version] [--profile]\n");
+    fprintf(stderr, "  check_allocs <dump> [version]\n");
+    fprintf(stderr, "  run_tests <dumpdir> <results.json>\n");
+    fprintf(stderr, "  run_replay <replay> [version] [--profile]\n");
+    fprintf(stderr, "  run_replays <dir|listfile> [version]\n");
+    fprintf(stderr, "  index_replay <replay> [version] [checkpoint interval]\n");
+    fprintf(stderr, "  convert_dump <in> <out>\n");
+    fprintf(stderr, "  diff_versions <old> <new> [all|char,char...] [json]\n");
+    fprintf(stderr, "  cook <char[version]> <out>\n");
+    fprintf(stderr, "  printversions\n");
+    return 1;
+}
@@ -12,7 +12,7 @@
 #include "comboutils.hpp"
 #include "combogen.hpp"
 #include "main.hpp"
-#include "ui.hpp"
+#include "input.hpp"
 
 void ComboWorker::Start(bool isFirst) {
     idle = false;
@@ -447,12 +447,14 @@ void ComboFinder::Start(Simulation *pStartSim)
 
     lightsActionIDs.clear();
     if (!doLights) {
-        for (auto& [key, action] : startSnapshot.simGuys[0]->getCharData()->actionsByID) {
+        CharacterData *pCharData = startSnapshot.simGuys[0]->getCharData();
+        for (auto& [key, action] : pCharData->actionsByID) {
             if (!action) continue;
-            if (action->name.find("5LP") != std::string::npos ||
-                action->name.find("5LK") != std::string::npos ||
-                action->name.find("2LP") != std::string::npos ||
-                action->name.find("2LK") != std::string::npos)
+            const std::string &name = pCharData->getActionNames(action).name;
+            if (name.find("5LP") != std::string::npos ||
+                name.find("5LK") != std::string::npos ||
+                name.find("2LP") != std::string::npos ||
+                name.find("2LK") != std::string::npos)
             {
                 lightsActionIDs.insert(key.actionID());
             }
@@ -705,16 +707,3 @@ void ComboFinder::Update(void)
         stoppedPending = true;
     }
 }
-
-void ComboFinder::Render(void)
-{
-    if (!running) {
-        return;
-    }
-
-    for (auto worker : workerPool) {
-        std::scoped_lock lockWorkerRenderSnapshot(worker->mutexRenderSnapshot);
-        worker->simRenderSnapshot.Render(1.0 / (workerPool.size() / 3.0) , false);
-        worker->wantsRenderSnapshot = true;
-    }
-}
\ No newline at end of file
@@ -86,7 +86,7 @@ void initChargeChecker(CharacterData *pCharData)
         for (auto &it : mapActionNeedCharge) {
             if (it.second.contains(charge.id)) {
                 if (pCharData->actionsByID.contains({it.first, 0})) {
-                    fprintf(stderr, "%s ", pCharData->actionsByID[{it.first, 0}]->niceNameDyn.c_str());
+                    fprintf(stderr, "%s ", pCharData->getActionNames(pCharData->actionsByID[{it.first, 0}]).niceNameDyn.c_str());
                 } else {
                     fprintf(stderr, "%i ", it.first);
                 }
@@ -97,7 +97,7 @@ void initChargeChecker(CharacterData *pCharData)
         for (auto &it : mapActionBreakCharge) {
             if (it.second.contains(charge.id)) {
                 if (pCharData->actionsByID.contains({it.first, 0})) {
-                    fprintf(stderr, "%s ", pCharData->actionsByID[{it.first, 0}]->niceNameDyn.c_str());
+                    fprintf(stderr, "%s ", pCharData->getActionNames(pCharData->actionsByID[{it.first, 0}]).niceNameDyn.c_str());
                 } else {
                     fprintf(stderr, "%i ", it.first);
                 }
@@ -0,0 +1,225 @@
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "main.hpp"
+
+// everything here is shared between the ui and the headless tools, nothing
+// in this file can touch SDL, GL or imgui
+
+EGameMode gameMode = Training;
+
+std::atomic<bool> forceCounter = false;
+std::atomic<bool> forcePunishCounter = false;
+
+bool viewerLogTransitions = false;
+bool viewerLogTriggers = false;
+bool viewerLogUnknowns = true;
+bool viewerLogHits = false;
+bool viewerLogBranches = false;
+bool viewerLogResources = false;
+
+struct charEntry {
+    int charID;
+    const char *name;
+    const char *niceName;
+};
+
+std::vector<charEntry> charEntries;
+std::vector<const char *> charNames;
+std::vector<const char *> charNiceNames;
+
+void makeCharEntries(void)
+{
+    charEntries.push_back({1, "ryu", "Ryu"});
+    charEntries.push_back({2, "luke", "Luke"});
+    charEntries.push_back({3, "kimberly", "Kimberly"});
+    charEntries.push_back({4, "chunli", "Chun-Li"});
+    charEntries.push_back({5, "manon", "Manon"});
+    charEntries.push_back({6, "zangief", "Zangief"});
+    charEntries.push_back({7, "jp", "JP"});
+    charEntries.push_back({8, "dhalsim", "Dhalsim"});
+    charEntries.push_back({9, "cammy", "Cammy"});
+    charEntries.push_back({10, "ken", "Ken"});
+    charEntries.push_back({11, "deejay", "Dee Jay"});
+    charEntries.push_back({12, "lily", "Lily"});
+    charEntries.push_back({13, "aki", "A.K.I."});
+    charEntries.push_back({14, "rashid", "Rashid"});
+    charEntries.push_back({15, "blanka", "Blanka"});
+    charEntries.push_back({16, "juri", "Juri"});
+    charEntries.push_back({17, "marisa", "Marisa"});
+    charEntries.push_back({18, "guile", "Guile"});
+    charEntries.push_back({19, "ed", "Ed"});
+    charEntries.push_back({20, "honda", "E. Honda"});
+    charEntries.push_back({21, "jamie", "Jamie"});
+    charEntries.push_back({22, "akuma", "Akuma"});
+    charEntries.push_back({25, "sagat", "Sagat"});
+    charEntries.push_back({26, "dictator", "M. Bison"});
+    charEntries.push_back({27, "terry", "Terry"});
+    charEntries.push_back({28, "mai", "Mai"});
+    charEntries.push_back({29, "elena", "Elena"});
+    charEntries.push_back({30, "viper", "C. Viper"});
+    charEntries.push_back({31, "alex", "Alex"});
+    charEntries.push_back({32, "ingrid", "Ingrid"});
+
+    for (charEntry &entry : charEntries ) {
+        charNames.push_back(entry.name);
+        charNiceNames.push_back(entry.niceName);
+    }
+}
+
+const char *getCharNameFromID(int charID)
+{
+    for (charEntry &entry : charEntries ) {
+        if (entry.charID == charID) {
+            return entry.name;
+        }
+    }
+
+    return nullptr;
+}
+
+const char *getCharNiceNameFromID(int charID)
+{
+    for (charEntry &entry : charEntries ) {
+        if (entry.charID == charID) {
+            return entry.niceName;
+        }
+    }
+
+    return nullptr;
+}
+
+int getCharIDFromName(const char *charName)
+{
+    for (charEntry &entry : charEntries) {
+        if (strcmp(entry.name, charName) == 0) {
+            return entry.charID;
+        }
+    }
+
+    return 0;
+}
+
+const char* charVersions[] = {
+    "19 - S1 February Update",
+    "20 - S2 Akuma Update",
+    "21 - S2 Hotfix 1",
+    "22 - S2 Hotfix 2",
+    "23 - S2 M. Bison Update",
+    "24 - S2 Terry Update",
+    "25 - S2 December Update",
+    "26 - S2 Mai Update",
+    "30 - S3 Elena Update + Hotfix 1",
+    "31 - S3 Hotfix 2",
+    "32 - S3 Hotfix 3",
+    "33 - S3 Hotfix 4",
+    "34 - S3 Sagat Update",
+    "35 - S3 Sagat Hotfix 1",
+    "36 - S3 Viper Update",
+    "37 - S3 Viper Hotfix 1",
+    "38 - S3 Viper Hotfix 2",
+    "39 - S3 December Update",
+    "40 - S3 Alex Update",
+    "41 - S3 Alex Hotfix",
+    "42 - S3 Ingrid Update",
+};
+const int charVersionCount = sizeof(charVersions) / sizeof(charVersions[0]);
+
+int simVersionFromGameVersion(int gameVersion, int64_t time)
+{
+    static const struct { int game; int64_t time; int sim; } table[] = {
+        { 0,                 0, 19 },
+        { 10005000,          0, 21 }, // no 20 replays as that was hotfixed same day
+        { 10005000, 1717286400, 22 }, // hotfix 2 dropped like a week after
+        { 10006000,          0, 23 },
+        { 10007000,          0, 24 },
+        { 10008000,          0, 25 },
+        { 10009000,          0, 26 },
+        { 20002010,          0, 41 },
+        { 20003000,          0, 42 },
+    };
+    int ret = table[0].sim;
+    for (const auto &row : table) {
+        if (gameVersion > row.game || (gameVersion == row.game && time >= row.time)) {
+            ret = row.sim;
+        } else {
+            break;
+        }
+    }
+    return ret;
+}
+
+void writeFile(const std::string &fileName, std::string contents)
+{
+    std::ofstream ofs(fileName.c_str(), std::ios::out | std::ios::trunc);
+    if (ofs.is_open()) {
+        ofs.write(contents.c_str(), contents.size());
+    }
+}
+
+std::string readFile(const std::string &fileName)
+{
+    std::ifstream ifs(fileName.c_str(), std::ios::in | std::ios::ate);
+
+    std::ifstream::pos_type fileSize = ifs.tellg();
+    if (fileSize < 0)                             
+        return std::string();                     
+
+    ifs.seekg(0, std::ios::beg);
+
+    std::vector<char> bytes(fileSize);
+    ifs.read(&bytes[0], fileSize);
+
+    return std::string(&bytes[0], fileSize);
+}
+
+nlohmann::json parse_json_file(const std::string &fileName)
+{
+    std::string fileText = readFile(fileName);
+    if (fileText == "") return nullptr;
+    return nlohmann::json::parse(fileText);
+}
+
+
+std::string to_string_leading_zeroes(unsigned int number, unsigned int length)
+{
+    
+     std::string num_str = std::to_string(number);
+    
+    if(num_str.length() >= length) return num_str;
+    
+     std::string leading_zeros(length - num_str.length(), '0');
+    
+    return leading_zeros + num_str;
+}
+
+static void (*pLogHandler)(std::string logLine) = nullptr;
+
+void setLogHandler(void (*pHandler)(std::string logLine))
+{
+    pLogHandler = pHandler;
+}
+
+void log(std::string logLine)
+{
+    if (pLogHandler) {
+        pLogHandler(logLine);
+    }
+}
+
+void extractCharVersion(char *cmdLine, std::string &charName, int &version)
+{
+    uint32_t i = 0;
+    while (i < strlen(cmdLine)) {
+        if (cmdLine[i] >= '0' && cmdLine[i] <= '9') {
+            version = atoi(&cmdLine[i]);
+            cmdLine[i] = 0;
+            break;
+        }
+        i++;
+    }
+    charName = cmdLine;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+// bump allocator for whatever only lives during one frame of the sim - box
+// lists, pending hits, trigger bookkeeping. nothing gets freed until Reset(),
+// which rewinds to the start. if a frame didn't fit, the overflow blocks get
+// folded into one block big enough for it on the next reset, so once the sim
+// has seen its busiest frame it stops touching the heap
+class FrameArena : public std::pmr::memory_resource {
+public:
+    // the block only gets allocated once something runs a frame, sims that
+    // just hold a state (history, snapshots) never need it
+    explicit FrameArena(size_t initialSize = 64 * 1024) : blockSize(initialSize) {}
+    // a copied sim gets its own empty arena, there's nothing live in it to share
+    FrameArena(const FrameArena &other) : FrameArena(other.blockSize) {}
+    FrameArena &operator=(const FrameArena &) { return *this; }
+
+    void Reset() {
+        if (overflowBytes) {
+            blockSize = (blockSize + overflowBytes) * 2;
+            block = std::make_unique<uint8_t[]>(blockSize);
+            overflowBlocks.clear();
+            overflowBytes = 0;
+            growCount++;
+        }
+        used = 0;
+    }
+
+    size_t capacity() const { return blockSize; }
+    // how many times Reset() had to grow the block, stays put in steady state
+    int growCount = 0;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        if (!block) {
+            block = std::make_unique<uint8_t[]>(blockSize);
+        }
+        uintptr_t base = (uintptr_t)block.get();
+        size_t start = ((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if (start + bytes <= blockSize) {
+            used = start + bytes;
+            return block.get() + start;
+        }
+        // didn't fit this frame, limp along on the heap until the next reset
+        size_t size = bytes + alignment;
+        overflowBlocks.push_back(std::make_unique<uint8_t[]>(size));
+        overflowBytes += size;
+        uintptr_t overflowBase = (uintptr_t)overflowBlocks.back().get();
+        return (void *)((overflowBase + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    std::unique_ptr<uint8_t[]> block;
+    size_t blockSize = 0;
+    size_t used = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> overflowBlocks;
+    size_t overflowBytes = 0;
+};
+
+// containers for frame scratch, pass them the sim's arena (or nothing for the
+// regular heap, like the UI does)
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+template<typename T>
+using FrameSet = std::pmr::set<T>;
+template<typename T>
+using FrameUnorderedSet = std::pmr::unordered_set<T>;
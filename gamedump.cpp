@@ -0,0 +1,264 @@
+#include <bit>
+#include <fstream>
+#include <limits>
+
+#include "gamedump.hpp"
+#include "main.hpp"
+
+static const uint32_t gameDumpMagic = 0x44474450; // 'PDGD'
+static const uint32_t gameDumpFormatVersion = 1;
+
+struct GameDumpFieldDesc {
+    const char *name;
+    bool isFixed;
+};
+
+static const GameDumpFieldDesc frameFieldDescs[eDumpFrameFieldCount] = {
+    {"playTimer", false},
+    {"playTimerMS", false},
+    {"stageTimer", false},
+    {"randomL", false},
+};
+
+static const GameDumpFieldDesc playerFieldDescs[eDumpPlayerFieldCount] = {
+    {"charID", false},
+    {"posX", true},
+    {"posY", true},
+    {"velX", true},
+    {"velY", true},
+    {"accelX", true},
+    {"accelY", true},
+    {"hitVelX", true},
+    {"hitAccelX", true},
+    {"actionID", false},
+    {"actionFrame", false},
+    {"comboCount", false},
+    {"bitValue", false},
+    {"hp", false},
+    {"hitStop", false},
+    {"hitStun", false},
+    {"pose", false},
+    {"driveGauge", false},
+    {"superGauge", false},
+    {"driveCooldown", false},
+    {"currentInput", false},
+};
+
+static bool decodeDumpValue(nlohmann::json &value, const GameDumpFieldDesc &desc, int32_t &out)
+{
+    int64_t ret;
+    if (desc.isFixed) {
+        ret = Fixed(value.get<double>()).data;
+    } else {
+        ret = value.get<int64_t>();
+    }
+    // randomL is an unsigned 32 bit seed, keep the bits
+    if (ret < std::numeric_limits<int32_t>::min() || ret > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    out = (int32_t)ret;
+    return true;
+}
+
+bool loadGameDumpFromJson(nlohmann::json &dumpJson, GameDump &dump)
+{
+    dump = GameDump();
+    if (!dumpJson.is_array() || dumpJson.size() == 0) {
+        return false;
+    }
+
+    dump.frameCount = dumpJson.size();
+
+    // a column is in the dump if the first frame has it, every other frame has to agree
+    nlohmann::json &firstFrame = dumpJson[0];
+    for (int field = 0; field < eDumpFrameFieldCount; field++) {
+        if (firstFrame.contains(frameFieldDescs[field].name)) {
+            dump.frameFieldMask |= 1 << field;
+            dump.frameColumns[field].resize(dump.frameCount);
+        }
+    }
+    for (int player = 0; player < 2; player++) {
+        for (int field = 0; field < eDumpPlayerFieldCount; field++) {
+            if (firstFrame["players"][player].contains(playerFieldDescs[field].name)) {
+                dump.playerFieldMask[player] |= 1 << field;
+                dump.playerColumns[player][field].resize(dump.frameCount);
+            }
+        }
+    }
+
+    for (int frame = 0; frame < dump.frameCount; frame++) {
+        nlohmann::json &frameJson = dumpJson[frame];
+        for (int field = 0; field < eDumpFrameFieldCount; field++) {
+            const GameDumpFieldDesc &desc = frameFieldDescs[field];
+            bool present = frameJson.contains(desc.name);
+            if (present != dump.has((GameDumpFrameField)field)) {
+                log("dump field " + std::string(desc.name) + " not present on every frame");
+                return false;
+            }
+            if (present && !decodeDumpValue(frameJson[desc.name], desc, dump.frameColumns[field][frame])) {
+                log("dump field " + std::string(desc.name) + " out of range at frame " + std::to_string(frame));
+                return false;
+            }
+        }
+        for (int player = 0; player < 2; player++) {
+            nlohmann::json &playerJson = frameJson["players"][player];
+            for (int field = 0; field < eDumpPlayerFieldCount; field++) {
+                const GameDumpFieldDesc &desc = playerFieldDescs[field];
+                bool present = playerJson.contains(desc.name);
+                if (present != dump.has(player, (GameDumpPlayerField)field)) {
+                    log("dump field " + std::string(desc.name) + " not present on every frame");
+                    return false;
+                }
+                if (present && !decodeDumpValue(playerJson[desc.name], desc, dump.playerColumns[player][field][frame])) {
+                    log("dump field " + std::string(desc.name) + " out of range at frame " + std::to_string(frame));
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static void writeColumn(std::ofstream &f, const std::vector<int32_t> &column)
+{
+    f.write((const char *)column.data(), column.size() * sizeof(int32_t));
+}
+
+static bool readColumn(std::ifstream &f, std::vector<int32_t> &column, int frameCount)
+{
+    column.resize(frameCount);
+    f.read((char *)column.data(), frameCount * sizeof(int32_t));
+    return (bool)f;
+}
+
+bool writeBinaryGameDump(const GameDump &dump, const std::string &path)
+{
+    std::ofstream f(path, std::ios::binary);
+    if (!f) return false;
+
+    uint32_t header[] = { gameDumpMagic, gameDumpFormatVersion, (uint32_t)dump.frameCount,
+                          dump.frameFieldMask, dump.playerFieldMask[0], dump.playerFieldMask[1] };
+    f.write((const char *)header, sizeof(header));
+
+    for (int field = 0; field < eDumpFrameFieldCount; field++) {
+        if (dump.has((GameDumpFrameField)field)) {
+            writeColumn(f, dump.frameColumns[field]);
+        }
+    }
+    for (int player = 0; player < 2; player++) {
+        for (int field = 0; field < eDumpPlayerFieldCount; field++) {
+            if (dump.has(player, (GameDumpPlayerField)field)) {
+                writeColumn(f, dump.playerColumns[player][field]);
+            }
+        }
+    }
+
+    return (bool)f;
+}
+
+static bool loadBinaryGameDump(const std::string &path, GameDump &dump)
+{
+    dump = GameDump();
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+
+    uint32_t header[6];
+    f.read((char *)header, sizeof(header));
+    if (!f || header[0] != gameDumpMagic || header[1] != gameDumpFormatVersion) {
+        return false;
+    }
+
+    // everything the header claims has to be in the file before anything
+    // gets sized off it, a corrupt header is just a dump that fails to load
+    const uint32_t frameFieldBits = (1u << eDumpFrameFieldCount) - 1;
+    const uint32_t playerFieldBits = (1u << eDumpPlayerFieldCount) - 1;
+    if (header[2] == 0 || header[2] > (uint32_t)std::numeric_limits<int>::max() ||
+        (header[3] & ~frameFieldBits) || (header[4] & ~playerFieldBits) || (header[5] & ~playerFieldBits)) {
+        log("bad binary dump header in " + path);
+        return false;
+    }
+    uint64_t columnCount = std::popcount(header[3]) + std::popcount(header[4]) + std::popcount(header[5]);
+    std::streamoff dataStart = f.tellg();
+    f.seekg(0, std::ios::end);
+    uint64_t remainingBytes = f.tellg() - dataStart;
+    f.seekg(dataStart);
+    if (!f || columnCount * header[2] * sizeof(int32_t) > remainingBytes) {
+        log("binary dump " + path + " is shorter than its header says");
+        return false;
+    }
+
+    dump.frameCount = header[2];
+    dump.frameFieldMask = header[3];
+    dump.playerFieldMask[0] = header[4];
+    dump.playerFieldMask[1] = header[5];
+
+    for (int field = 0; field < eDumpFrameFieldCount; field++) {
+        if (dump.has((GameDumpFrameField)field) && !readColumn(f, dump.frameColumns[field], dump.frameCount)) {
+            return false;
+        }
+    }
+    for (int player = 0; player < 2; player++) {
+        for (int field = 0; field < eDumpPlayerFieldCount; field++) {
+            if (dump.has(player, (GameDumpPlayerField)field) && !readColumn(f, dump.playerColumns[player][field], dump.frameCount)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void decodeGameDumpFrames(const GameDump &dump, std::vector<DumpFrame> &frames)
+{
+    frames.resize(dump.frameCount);
+    for (int frame = 0; frame < dump.frameCount; frame++) {
+        DumpFrame &out = frames[frame];
+        out.playTimer = dump.get(frame, eDumpPlayTimer, 99);
+        out.playTimerMS = dump.get(frame, eDumpPlayTimerMS, 60);
+        out.stageTimer = dump.get(frame, eDumpStageTimer);
+        out.randomL = dump.get(frame, eDumpRandomL);
+        for (int player = 0; player < 2; player++) {
+            DumpPlayerFrame &outPlayer = out.players[player];
+            outPlayer.posX = dump.get(frame, player, eDumpPosX);
+            outPlayer.posY = dump.get(frame, player, eDumpPosY);
+            outPlayer.velX = dump.get(frame, player, eDumpVelX);
+            outPlayer.velY = dump.get(frame, player, eDumpVelY);
+            outPlayer.accelX = dump.get(frame, player, eDumpAccelX);
+            outPlayer.accelY = dump.get(frame, player, eDumpAccelY);
+            outPlayer.hitVelX = dump.get(frame, player, eDumpHitVelX);
+            outPlayer.hitAccelX = dump.get(frame, player, eDumpHitAccelX);
+            outPlayer.actionID = dump.get(frame, player, eDumpActionID);
+            outPlayer.actionFrame = dump.get(frame, player, eDumpActionFrame);
+            outPlayer.comboCount = dump.get(frame, player, eDumpComboCount);
+            outPlayer.direction = (dump.get(frame, player, eDumpBitValue) & (1<<7)) ? 1 : -1;
+            outPlayer.hp = dump.get(frame, player, eDumpHP);
+            outPlayer.hitStop = dump.get(frame, player, eDumpHitStop);
+            outPlayer.driveGauge = dump.get(frame, player, eDumpDriveGauge);
+            outPlayer.superGauge = dump.get(frame, player, eDumpSuperGauge);
+            outPlayer.driveCooldown = dump.get(frame, player, eDumpDriveCooldown);
+            outPlayer.currentInput = dump.get(frame, player, eDumpCurrentInput);
+        }
+    }
+}
+
+bool isBinaryGameDump(const std::string &path)
+{
+    std::ifstream f(path, std::ios::binary);
+    uint32_t magic = 0;
+    f.read((char *)&magic, sizeof(magic));
+    return f && magic == gameDumpMagic;
+}
+
+bool loadGameDump(const std::string &path, GameDump &dump)
+{
+    if (isBinaryGameDump(path)) {
+        return loadBinaryGameDump(path, dump);
+    }
+
+    nlohmann::json dumpJson = parse_json_file(path);
+    if (dumpJson == nullptr) {
+        return false;
+    }
+    return loadGameDumpFromJson(dumpJson, dump);
+}
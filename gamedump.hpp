@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "fixed.hpp"
+
+enum GameDumpFrameField {
+    eDumpPlayTimer = 0,
+    eDumpPlayTimerMS,
+    eDumpStageTimer,
+    eDumpRandomL,
+    eDumpFrameFieldCount
+};
+
+enum GameDumpPlayerField {
+    eDumpCharID = 0,
+    eDumpPosX,
+    eDumpPosY,
+    eDumpVelX,
+    eDumpVelY,
+    eDumpAccelX,
+    eDumpAccelY,
+    eDumpHitVelX,
+    eDumpHitAccelX,
+    eDumpActionID,
+    eDumpActionFrame,
+    eDumpComboCount,
+    eDumpBitValue,
+    eDumpHP,
+    eDumpHitStop,
+    eDumpHitStun,
+    eDumpPose,
+    eDumpDriveGauge,
+    eDumpSuperGauge,
+    eDumpDriveCooldown,
+    eDumpCurrentInput,
+    eDumpPlayerFieldCount
+};
+
+// one array per field instead of one object per frame - the binary form is
+// just the present columns back to back, fixed point fields hold Fixed::data
+struct GameDump {
+    int frameCount = 0;
+    uint32_t frameFieldMask = 0;
+    uint32_t playerFieldMask[2] = {0, 0};
+    std::vector<int32_t> frameColumns[eDumpFrameFieldCount];
+    std::vector<int32_t> playerColumns[2][eDumpPlayerFieldCount];
+
+    bool has(GameDumpFrameField field) const { return frameFieldMask & (1 << field); }
+    bool has(int player, GameDumpPlayerField field) const { return playerFieldMask[player] & (1 << field); }
+
+    int32_t get(int frame, GameDumpFrameField field, int32_t defaultValue = 0) const {
+        return has(field) ? frameColumns[field][frame] : defaultValue;
+    }
+    int32_t get(int frame, int player, GameDumpPlayerField field, int32_t defaultValue = 0) const {
+        return has(player, field) ? playerColumns[player][field][frame] : defaultValue;
+    }
+    Fixed getFixed(int frame, int player, GameDumpPlayerField field) const {
+        Fixed ret;
+        ret.data = get(frame, player, field);
+        return ret;
+    }
+};
+
+// one frame of a dump decoded up front into what the per frame comparison
+// reads, missing fields get the same defaults the json path used
+struct DumpPlayerFrame {
+    int64_t posX; // Fixed::data, same for the rest of the fixed point fields
+    int64_t posY;
+    int64_t velX;
+    int64_t velY;
+    int64_t accelX;
+    int64_t accelY;
+    int64_t hitVelX;
+    int64_t hitAccelX;
+    int32_t actionID;
+    int32_t actionFrame;
+    int32_t comboCount;
+    int32_t direction;
+    int32_t hp;
+    int32_t hitStop;
+    int32_t driveGauge;
+    int32_t superGauge;
+    int32_t driveCooldown;
+    int32_t currentInput;
+};
+
+struct DumpFrame {
+    int32_t playTimer;
+    int32_t playTimerMS;
+    int32_t stageTimer;
+    int32_t randomL;
+    DumpPlayerFrame players[2];
+};
+
+void decodeGameDumpFrames(const GameDump &dump, std::vector<DumpFrame> &frames);
+
+bool isBinaryGameDump(const std::string &path);
+bool loadGameDump(const std::string &path, GameDump &dump);
+bool loadGameDumpFromJson(nlohmann::json &dumpJson, GameDump &dump);
+bool writeBinaryGameDump(const GameDump &dump, const std::string &path);
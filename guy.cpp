@@ -14,8 +14,6 @@
 
 #include "guy.hpp"
 #include "main.hpp"
-#include "render.hpp"
-#include "ui.hpp"
 #include <string>
 
 #include <cmath>
@@ -172,7 +170,7 @@ void Guy::guyLog(bool doLog, std::string logLine)
     nc.lastLogFrame = pSim->frameCounter;
 }
 
-bool Guy::conditionOperator(int op, int operand, int threshold, std::string desc)
+bool Guy::conditionOperator(int op, int operand, int threshold, const char *desc)
 {
     switch (op) {
         case 0:
@@ -198,7 +196,7 @@ bool Guy::conditionOperator(int op, int operand, int threshold, std::string desc
         //     if  (operand & threshold) return true;
         //     break;
         default:
-            log(logUnknowns, "unhandled " + desc + " operator");
+            log(logUnknowns, "unhandled " + std::string(desc) + " operator");
             break;
     }
     return false;
@@ -260,7 +258,7 @@ std::string Guy::getActionName(int actionID)
 {
     Action *pAction = FindMove(actionID, styleInstall);
     if (pAction) {
-        return pAction->niceNameDyn;
+        return pCharData->getActionNames(pAction).niceNameDyn;
     }
     return "invalid";
 }
@@ -564,7 +562,7 @@ bool Guy::RunFrame(bool advancingTime)
         }
 
         if (pOpponent && pOpponent->pendingUnlockHit) {
-            HitEntry *pEntry = &pOpponent->pCharData->hitByID[pOpponent->pendingUnlockHit]->common[0];
+            HitEntry *pEntry = pOpponent->pCharData->hitByID[pOpponent->pendingUnlockHit]->common(0);
             if (pEntry->throwRelease == 1) {
                 // pOpponent->posX = pOpponent->posX + (pOpponent->posOffsetX * pOpponent->direction);
                 // pOpponent->posOffsetX = Fixed(0);
@@ -1473,7 +1471,7 @@ void Guy::DoTriggers(int fluffFrameBias)
         return;
     }
 
-    std::set<int> keptDeferredTriggerIDs;
+    FrameSet<int> keptDeferredTriggerIDs(frameMemory());
     bool hasTriggerKey = pCurrentAction && !pCurrentAction->triggerKeys.empty();
     if (hasTriggerKey || fluffFrames(fluffFrameBias))
     {
@@ -1599,8 +1597,7 @@ void Guy::DoTriggers(int fluffFrameBias)
             }
         }
 
-        // possibly need a fixed array here too if it shows up in mining profile
-        std::set<uint32_t> initialIsToConsume;
+        FrameSet<uint32_t> initialIsToConsume(frameMemory());
 
         std::sort(triggers, triggers + triggerCount, [](const TriggerCheckState& a, const TriggerCheckState& b) {
             return a.triggerID < b.triggerID;
@@ -1713,7 +1710,11 @@ void Guy::DoTriggers(int fluffFrameBias)
             log(logTriggers, "forgetting deferred trigger " + std::to_string(id));
         }
     }
-    dc.setDeferredTriggerIDs = keptDeferredTriggerIDs;
+    // usually nothing changed, don't churn the set's nodes for it
+    if (!std::equal(dc.setDeferredTriggerIDs.begin(), dc.setDeferredTriggerIDs.end(),
+                    keptDeferredTriggerIDs.begin(), keptDeferredTriggerIDs.end())) {
+        dc.setDeferredTriggerIDs = std::set<int>(keptDeferredTriggerIDs.begin(), keptDeferredTriggerIDs.end());
+    }
 }
 
 Box Guy::rectToBox(Rect *pRect, Fixed offsetX, Fixed offsetY, int dir)
@@ -1726,7 +1727,7 @@ Box Guy::rectToBox(Rect *pRect, Fixed offsetX, Fixed offsetY, int dir)
     return outBox;
 }
 
-void Guy::getPushBoxes(std::vector<Box> *pOutPushBoxes, std::vector<RenderBox> *pOutRenderBoxes)
+void Guy::getPushBoxes(FrameVector<Box> *pOutPushBoxes, std::vector<RenderBox> *pOutRenderBoxes)
 {
     if (!pCurrentAction) {
         return;
@@ -1757,7 +1758,7 @@ void Guy::getPushBoxes(std::vector<Box> *pOutPushBoxes, std::vector<RenderBox> *
     }
 }
 
-void Guy::getHurtBoxes(std::vector<HurtBox> *pOutHurtBoxes, std::vector<HurtBox> *pOutThrowBoxes, std::vector<RenderBox> *pOutRenderBoxes)
+void Guy::getHurtBoxes(FrameVector<HurtBox> *pOutHurtBoxes, FrameVector<HurtBox> *pOutThrowBoxes, std::vector<RenderBox> *pOutRenderBoxes)
 {
     if (!pCurrentAction) {
         return;
@@ -1884,7 +1885,7 @@ void Guy::getHurtBoxes(std::vector<HurtBox> *pOutHurtBoxes, std::vector<HurtBox>
     }
 }
 
-void Guy::getHitBoxes(std::vector<HitBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes, hitBoxType typeFilter, hitBoxType typeExclude)
+void Guy::getHitBoxes(FrameVector<HitBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes, hitBoxType typeFilter, hitBoxType typeExclude)
 {
     if (!pCurrentAction) {
         return;
@@ -1963,7 +1964,7 @@ void Guy::getHitBoxes(std::vector<HitBox> *pOutHitBoxes, std::vector<RenderBox>
     }
 }
 
-void Guy::getUniqueBoxes(std::vector<UniqueBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes)
+void Guy::getUniqueBoxes(FrameVector<UniqueBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes)
 {
     if (!pCurrentAction) {
         return;
@@ -1999,38 +2000,6 @@ void Guy::getUniqueBoxes(std::vector<UniqueBox> *pOutHitBoxes, std::vector<Rende
 }
 
 
-void Guy::Render(float a /* = 1.0f */, bool showDomain) {
-    Fixed fixedX = posX + (posOffsetX * direction);
-    Fixed fixedY = posY + posOffsetY;
-    float x = fixedX.f();
-    float y = fixedY.f();
-
-    std::vector<RenderBox> renderBoxes;
-    getHurtBoxes(nullptr, nullptr, &renderBoxes);
-    getPushBoxes(nullptr, &renderBoxes);
-    getHitBoxes(nullptr, &renderBoxes, hitBoxType::none, showDomain ? hitBoxType::none : hitBoxType::domain);
-    getUniqueBoxes(nullptr, &renderBoxes);
-
-    for (auto box : renderBoxes) {
-        drawHitBox(box.box,thickboxes?box.thickness:1,0.0,box.col,box.drive,box.parry,box.di,a);
-    }
-
-    if (renderPositionAnchors && a == 1.0f) {
-        float radius = 6.0;
-        float thickness = thickboxes?radius:1;
-        drawBox(x-radius/2,y-radius/2,radius,radius,thickness,0.0,charColorR,charColorG,charColorB,1.0);
-        // radius = 5.0;
-        // drawBox(x-radius/2,y-radius/2,radius,radius,thickness,1.0,1.0,1.0,0.2);
-
-        // meters
-        if (!isProjectile) {
-            drawBox(x - 35.0, y - 1.0, focus / float(maxFocus) * 30.0, 3.0, 1.0, 0.0, !burnout ? 0.20 : 0.7, !burnout ? 0.80 : 0.7, !burnout ? 0.0 : 0.7, 1.0);
-            drawBox(x + 5.0, y - 1.0, gauge / float(pCharData->gauge) * 30.0, 3.0, 1.0, 0.0, 0.0, 0.80, 0.80, 1.0);
-            drawBox(x - 35.0, y + 5.0, health / float(pCharData->vitality) * 70.0, 3.0, 1.0, 0.0, 0.9, health > 2500 ? 0.90 : 0.0, health > 2500 ? 0.90 : 0.0, 1.0);
-        }
-    }
-}
-
 int Guy::getFrameMeterColorIndex() {
     int ret = 0;
     bool a,b,c;
@@ -2043,7 +2012,7 @@ int Guy::getFrameMeterColorIndex() {
     if (counterState) {
         ret = 3;
     }
-    std::vector<HitBox> hitBoxes;
+    FrameVector<HitBox> hitBoxes(frameMemory());
     getHitBoxes(&hitBoxes);
     for (auto &hitBox : hitBoxes) {
         if (hitBox.type != proximity_guard) {
@@ -2101,8 +2070,8 @@ bool Guy::Push(Guy *pOtherGuy)
         // }
     }
 
-    std::vector<Box> pushBoxes;
-    std::vector<Box> otherPushBoxes;
+    FrameVector<Box> pushBoxes(frameMemory());
+    FrameVector<Box> otherPushBoxes(frameMemory());
     getPushBoxes(&pushBoxes);
     pOtherGuy->getPushBoxes(&otherPushBoxes);
 
@@ -2117,8 +2086,8 @@ bool Guy::Push(Guy *pOtherGuy)
                 if (isProjectile && pCurrentAction->pProjectileData && projHitCount > 0 &&
                     pOtherGuy->isProjectile && pOtherGuy->pCurrentAction->pProjectileData && pOtherGuy->projHitCount > 0) {
                     // projectile clash
-                    std::vector<HitBox> ownHitBoxes;
-                    std::vector<HitBox> otherHitBoxes;
+                    FrameVector<HitBox> ownHitBoxes(frameMemory());
+                    FrameVector<HitBox> otherHitBoxes(frameMemory());
                     getHitBoxes(&ownHitBoxes, nullptr, none, proximity_guard);
                     pOtherGuy->getHitBoxes(&otherHitBoxes, nullptr, none, proximity_guard);
 
@@ -2127,10 +2096,10 @@ bool Guy::Push(Guy *pOtherGuy)
                     int otherHitStop = 8;
 
                     if (ownHitBoxes.size()) {
-                        ownHitStop = ownHitBoxes.front().pHitData->common[0].hitStopOwner;
+                        ownHitStop = ownHitBoxes.front().pHitData->common(0)->hitStopOwner;
                     }
                     if (otherHitBoxes.size()) {
-                        otherHitStop = otherHitBoxes.front().pHitData->common[0].hitStopOwner;
+                        otherHitStop = otherHitBoxes.front().pHitData->common(0)->hitStopOwner;
                     }
                     int clashHitStop = std::max(ownHitStop, otherHitStop);
                     // todo what if both? even frame?
@@ -2613,7 +2582,7 @@ void Guy::DoReflect()
     deferredReflect = false;
 }
 
-void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
+void Guy::CheckHit(Guy *pOtherGuy, FrameVector<PendingHit> &pendingHitList)
 {
     if (parryFreeze || warudo || getHitStop() || (pOpponent && pOpponent->wallStopped && pOpponent->stunned)) return;
     if ( !pOtherGuy ) return;
@@ -2623,9 +2592,9 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
         CheckHit(minion, pendingHitList);
     }
 
-    std::vector<HitBox> hitBoxes;
-    std::vector<HurtBox> otherThrowBoxes;
-    std::vector<HurtBox> otherHurtBoxes;
+    FrameVector<HitBox> hitBoxes(frameMemory());
+    FrameVector<HurtBox> otherThrowBoxes(frameMemory());
+    FrameVector<HurtBox> otherHurtBoxes(frameMemory());
     bool hasEvaluatedThrowBoxes = false;
     bool hasEvaluatedHurtBoxes = false;
 
@@ -2705,10 +2674,10 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
         }
 
         if (isGrab) {
-            bool bIgnoreHitStun = hitbox.pHitData->common[0].attr2 & (1<<7);
+            bool bIgnoreHitStun = hitbox.pHitData->common(0)->attr2 & (1<<7);
             bool doGrab = (!pOtherGuy->getHitStun() || pOtherGuy->getHitStun() > 1000 || bIgnoreHitStun) && !pOtherGuy->throwProtectionFrames;
             if (doGrab) {
-                std::vector<HitBox> otherNullifyGrabBoxes;
+                FrameVector<HitBox> otherNullifyGrabBoxes(frameMemory());
                 bool grabNullified = false;
                 pOtherGuy->getHitBoxes(&otherNullifyGrabBoxes, nullptr, hitBoxType::nullify_grab);
                 for (auto const & nullifyGrabBox : otherNullifyGrabBoxes ) {
@@ -2824,7 +2793,7 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
             } else if (hitbox.type == screen_freeze) {
                 // those want other screen_freeze boxes
                 // those tend to come in 1s so probably not worth trying to recycle the vec?
-                std::vector<HitBox> otherFreezeBoxes;
+                FrameVector<HitBox> otherFreezeBoxes(frameMemory());
                 pOtherGuy->getHitBoxes(&otherFreezeBoxes, nullptr, hitBoxType::screen_freeze);
                 for (auto const & freezeBox : otherFreezeBoxes ) {
                     if (doBoxesHit(hitbox.box, freezeBox.box)) {
@@ -2841,18 +2810,18 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
                 }
             } else if (hitbox.type == clash) {
                 // those want other clash boxes
-                std::vector<HitBox> otherClashBoxes;
+                FrameVector<HitBox> otherClashBoxes(frameMemory());
                 pOtherGuy->getHitBoxes(&otherClashBoxes, nullptr, hitBoxType::clash);
                 for (auto const & clashBox : otherClashBoxes ) {
                     if (doBoxesHit(hitbox.box, clashBox.box)) {
                         // in reality there is one more frame of hitstop but movement mysteriously starts 1f before hitstop ends
                         // we do one frame less of hitstop and we hold here for 1f, which equates to the same thing (right???)
-                        ApplyHitEffect(&clashBox.pHitData->param[0], pOtherGuy, false, false, false, false, false, true);
-                        addHitStop(clashBox.pHitData->param[0].hitStopTarget+1);
+                        ApplyHitEffect(clashBox.pHitData->param(0), pOtherGuy, false, false, false, false, false, true);
+                        addHitStop(clashBox.pHitData->param(0)->hitStopTarget+1);
                         currentFrameFrac -= Fixed(1);
 
-                        pOtherGuy->ApplyHitEffect(&hitbox.pHitData->param[0], this, false, false, false, false, false, true);
-                        pOtherGuy->addHitStop(hitbox.pHitData->param[0].hitStopTarget+1);
+                        pOtherGuy->ApplyHitEffect(hitbox.pHitData->param(0), this, false, false, false, false, false, true);
+                        pOtherGuy->addHitStop(hitbox.pHitData->param(0)->hitStopTarget+1);
                         pOtherGuy->currentFrameFrac -= Fixed(1);
 
                         if (hitbox.hitID != -1) {
@@ -2866,7 +2835,7 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
                 }
             } else if (hitbox.type == destroy_projectile) {
                 if (pOtherGuy->isProjectile && pOtherGuy->pCurrentAction && pOtherGuy->pCurrentAction->pProjectileData) {
-                    std::vector<Box> otherPushBoxes;
+                    FrameVector<Box> otherPushBoxes(frameMemory());
                     pOtherGuy->getPushBoxes(&otherPushBoxes);
                     for (auto const & pushBox : otherPushBoxes) {
                         if (doBoxesHit(hitbox.box, pushBox)) {
@@ -2915,11 +2884,11 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
 
             bool otherGuyAirborne = pOtherGuy->getAirborne();
 
-            if (pOtherGuy->counterState || (forceCounter && pOtherGuy->comboHits == 0 && !pOtherGuy->wasHit)) {
+            if (pOtherGuy->counterState || ((forceCounter || pSim->forceCounter) && pOtherGuy->comboHits == 0 && !pOtherGuy->wasHit)) {
                 hitEntryFlag |= counter;
             }
             // the force from the UI doesn't do the right thing for multi hit moves like hands ATM
-            if (pOtherGuy->punishCounterState || (forcePunishCounter && pOtherGuy->comboHits == 0 && !pOtherGuy->wasHit)) {
+            if (pOtherGuy->punishCounterState || ((forcePunishCounter || pSim->forcePunishCounter) && pOtherGuy->comboHits == 0 && !pOtherGuy->wasHit)) {
                 hitEntryFlag |= punish_counter;
             }
 
@@ -3003,11 +2972,11 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
             HitData *pHitData = hitbox.pHitData;
 
             if (isGrab) {
-                pHitEntry = &pHitData->common[0];
+                pHitEntry = pHitData->common(0);
             } else if (parried) {
-                pHitEntry = &pHitData->common[4];
+                pHitEntry = pHitData->common(4);
             } else {
-                pHitEntry = &pHitData->param[hitEntryFlag];
+                pHitEntry = pHitData->param(hitEntryFlag);
             }
 
             // if bomb burst and found a bomb, use the next hit ID instead
@@ -3021,7 +2990,7 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
                 auto bombHitIt = pCharData->hitByID.find(nextHitID);
                 if (bombHitIt != pCharData->hitByID.end()) {
                     pHitData = bombHitIt->second;
-                    pHitEntry = &pHitData->param[hitEntryFlag];
+                    pHitEntry = pHitData->param(hitEntryFlag);
                 }
             }
 
@@ -3052,7 +3021,7 @@ void Guy::CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList)
     if (pendingUnlockHit) {
         // really we should save the lock target, etc.
         if (pOpponent) {
-            HitEntry *pEntry = &pCharData->hitByID[pendingUnlockHit]->common[0];
+            HitEntry *pEntry = pCharData->hitByID[pendingUnlockHit]->common(0);
             if (pendingUnlockHitDelayed || pEntry->floorTime == 0) {
                 pOpponent->ApplyHitEffectOnResources(pEntry, this, true, false);
                 pOpponent->ApplyHitEffect(pEntry, this, true, false, false, false);
@@ -3090,11 +3059,11 @@ AtemiData *Guy::findAtemi(int atemiID)
     return nullptr;
 }
 
-void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
+void ResolveHits(Simulation *pSim, FrameVector<PendingHit> &pendingHitList)
 {
-    std::unordered_set<Guy *> attackers;
-    std::unordered_set<Guy *> hitGuys;
-    std::unordered_set<Guy *> clampGuys;
+    FrameUnorderedSet<Guy *> attackers(&pSim->frameArena);
+    FrameUnorderedSet<Guy *> hitGuys(&pSim->frameArena);
+    FrameUnorderedSet<Guy *> clampGuys(&pSim->frameArena);
 
     for (auto &pendingHit : pendingHitList) {
         HitBox &hitBox = pendingHit.hitBox;
@@ -3236,7 +3205,7 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
         if (hitArmor || hitAtemi) {
             // undo conter/PC if hit armor
             hitEntryFlag = hitEntryFlag & ~(punish_counter|counter);
-            pHitEntry = &hitBox.pHitData->param[hitEntryFlag];
+            pHitEntry = hitBox.pHitData->param(hitEntryFlag);
         }
 
         if (hitArmor && !hitAtemi) {
@@ -3286,7 +3255,7 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
 
         if (hitArmor || hitAtemi) {
             // hitstop comes from block entry??
-            pHitEntry = &hitBox.pHitData->param[block];
+            pHitEntry = hitBox.pHitData->param(block);
         }
 
         int destX = pHitEntry->moveDestX;
@@ -3394,7 +3363,7 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
             if (pOtherGuy->focus < 0 && !otherGuyWasBurnout && hitEntryFlag & block) {
                 int newHitFlag = hitEntryFlag & ~block;
                 newHitFlag |= special;
-                pHitEntry = &hitBox.pHitData->param[newHitFlag];
+                pHitEntry = hitBox.pHitData->param(newHitFlag);
                 hitEntryFlag = newHitFlag;
                 justBurnedOutFromBlockedHit = true;
             }
@@ -3403,11 +3372,11 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
                 int newHitFlag = hitEntryFlag & ~special;
                 newHitFlag |= block;
                 clonedEntry = *pHitEntry;
-                clonedEntry.moveTime = hitBox.pHitData->param[newHitFlag].moveTime;
-                clonedEntry.moveDestX = hitBox.pHitData->param[newHitFlag].moveDestX;
+                clonedEntry.moveTime = hitBox.pHitData->param(newHitFlag)->moveTime;
+                clonedEntry.moveDestX = hitBox.pHitData->param(newHitFlag)->moveDestX;
                 if (justBurnedOutFromBlockedHit) {
                     // no hitstun penalty yet ?
-                    clonedEntry.hitStun = hitBox.pHitData->param[newHitFlag].hitStun;
+                    clonedEntry.hitStun = hitBox.pHitData->param(newHitFlag)->hitStun;
                 }
                 pHitEntry = &clonedEntry;
             }
@@ -3439,7 +3408,7 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
                 pOtherGuy->hitAccelX = halfHitAccel;
 
                 // find the parry gains in common[0], weird
-                pOtherGuy->focus += hitBox.pHitData->common[0].parryGain;
+                pOtherGuy->focus += hitBox.pHitData->common(0)->parryGain;
 
                 pOtherGuy->focusRegenCooldown = 20;
                 pOtherGuy->focusRegenCooldownFrozen = true;
@@ -3525,21 +3494,17 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
                 hitMarkerRadius = 45.0f;
             }
             int hitSeed = pGuy->pSim->frameCounter + int(hitMarkerOffsetX + hitMarkerOffsetY);
-            if (pGuy->pSim != &defaultSim) {
-                FrameEvent event;
-                event.type = FrameEvent::Hit;
-                event.hitEventData.targetID = pOtherGuy->getUniqueID();
-                event.hitEventData.x = hitMarkerOffsetX;
-                event.hitEventData.y = hitMarkerOffsetY;
-                event.hitEventData.radius = hitMarkerRadius;
-                event.hitEventData.hitType = hitMarkerType;
-                event.hitEventData.seed = hitSeed;
-                event.hitEventData.dirX = pGuy->direction.f();
-                event.hitEventData.dirY = 0.0f;
-                pGuy->pSim->getCurrentFrameEvents().push_back(event);
-            } else {
-                addHitMarker({hitMarkerOffsetX,hitMarkerOffsetY,hitMarkerRadius,pOtherGuy,hitMarkerType, 0, 10, hitSeed, pGuy->direction.f(), 0.0f});
-            }
+            FrameEvent event;
+            event.type = FrameEvent::Hit;
+            event.hitEventData.targetID = pOtherGuy->getUniqueID();
+            event.hitEventData.x = hitMarkerOffsetX;
+            event.hitEventData.y = hitMarkerOffsetY;
+            event.hitEventData.radius = hitMarkerRadius;
+            event.hitEventData.hitType = hitMarkerType;
+            event.hitEventData.seed = hitSeed;
+            event.hitEventData.dirX = pGuy->direction.f();
+            event.hitEventData.dirY = 0.0f;
+            pGuy->pSim->getCurrentFrameEvents().push_back(event);
         }
 
         if (pGuy->isProjectile && hitBox.type != direct_damage) {
@@ -3650,11 +3615,11 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
     }
 
     // do unique interactions now
-    std::unordered_set<Guy*> pitchers;
-    std::unordered_set<Guy*> catchers;
+    FrameUnorderedSet<Guy*> pitchers(&pSim->frameArena);
+    FrameUnorderedSet<Guy*> catchers(&pSim->frameArena);
 
     for (Guy *guy : pSim->everyone) {
-        std::vector<UniqueBox> uniqueBoxes;
+        FrameVector<UniqueBox> uniqueBoxes(&pSim->frameArena);
         guy->getUniqueBoxes(&uniqueBoxes);
         for (UniqueBox &box : uniqueBoxes) {
             if (box.uniquePitcher) {
@@ -3667,9 +3632,9 @@ void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList)
 
     for (Guy *pitcher : pitchers) {
         for (Guy *catcher : catchers) {
-            std::vector<UniqueBox> uniqueBoxesPitcher;
+            FrameVector<UniqueBox> uniqueBoxesPitcher(&pSim->frameArena);
             pitcher->getUniqueBoxes(&uniqueBoxesPitcher);
-            std::vector<UniqueBox> uniqueBoxesCatcher;
+            FrameVector<UniqueBox> uniqueBoxesCatcher(&pSim->frameArena);
             catcher->getUniqueBoxes(&uniqueBoxesCatcher);
 
             for (UniqueBox &pitcherBox : uniqueBoxesPitcher) {
@@ -5124,7 +5089,7 @@ void Guy::DoBranchKey(bool preHit)
                     // }
                     break;
                 default:
-                    log(logUnknowns, "unsupported branch id " + std::to_string(branchType) + " type " + branchKey.typeName);
+                    log(logUnknowns, "unsupported branch id " + std::to_string(branchType) + " type " + pCharData->branchTypeNames[branchKey.typeNameIndex]);
                     break;
         }
 
@@ -6856,7 +6821,7 @@ void Guy::DoLockKey(void)
                 log(logErrors, "weird!");
             }
             pendingUnlockHit = lockKey.param02;
-            HitEntry *pEntry = &pCharData->hitByID[lockKey.param02]->common[0];
+            HitEntry *pEntry = pCharData->hitByID[lockKey.param02]->common(0);
             pOpponent->throwRelease = pEntry->throwRelease;
             if (pEntry->throwRelease == 3) {
                 // pOpponent->ApplyHitEffectOnResources(pEntry, this, true, false);
@@ -7071,7 +7036,7 @@ void Guy::DoEventKey(Action *pAction, int frameID, Fixed prevPosOffset)
                             if (pOpponent) {
                                 // todo figure out which slot it is for real
                                 pOpponent->pendingUnlockHit = param1;
-                                HitEntry *pEntry = &pOpponent->pCharData->hitByID[param1]->common[0];
+                                HitEntry *pEntry = pOpponent->pCharData->hitByID[param1]->common(0);
                                 if (pEntry) {
                                     throwRelease = pEntry->throwRelease;
                                 }
@@ -7245,13 +7210,13 @@ void Guy::DoShotKey(Action *pAction, int frameID, bool preHit)
             }
 
             // spawn new guy
-            Guy *pNewGuy = new Guy(*this, posOffsetX, posOffsetY, shotKey.actionId, shotKey.styleIdx, true);
-            pNewGuy->setLogTransitions(simController.viewerLogTransitions);
-            pNewGuy->setLogTriggers(simController.viewerLogTriggers);
-            pNewGuy->setLogUnknowns(simController.viewerLogUnknowns);
-            pNewGuy->setLogHits(simController.viewerLogHits);
-            pNewGuy->setLogBranches(simController.viewerLogBranches);
-            pNewGuy->setLogResources(simController.viewerLogResources);
+            Guy *pNewGuy = new (pSim) Guy(*this, posOffsetX, posOffsetY, shotKey.actionId, shotKey.styleIdx, true);
+            pNewGuy->setLogTransitions(viewerLogTransitions);
+            pNewGuy->setLogTriggers(viewerLogTriggers);
+            pNewGuy->setLogUnknowns(viewerLogUnknowns);
+            pNewGuy->setLogHits(viewerLogHits);
+            pNewGuy->setLogBranches(viewerLogBranches);
+            pNewGuy->setLogResources(viewerLogResources);
             if (shotKey.flags & 4) {
                 pNewGuy->ignoreWarudo = true;
             }
@@ -7274,6 +7239,7 @@ void Guy::DoShotKey(Action *pAction, int frameID, bool preHit)
             } else {
                 dc.minions.push_back(pNewGuy);
             }
+            pSim->markRosterDirty();
             if (!preHit) {
                 pNewGuy->spawnedPostHit = true;
             }
@@ -7359,3 +7325,108 @@ void Guy::FixRefs(std::map<int,Guy*> &guysByID) {
         minion.FixRef(guysByID);
     }
 }
+
+void Guy::FixRefs(Simulation *pNewSim) {
+    pOpponent.FixRef(pNewSim);
+    pParent.FixRef(pNewSim);
+    pAttacker.FixRef(pNewSim);
+
+    for (GuyRef & minion : dc.minions) {
+        minion.FixRef(pNewSim);
+    }
+}
+
+void Guy::SaveState(StateBlob &blob)
+{
+    blob.writeString(pCharData->charName);
+    blob.write<int>(pCharData->charVersion);
+
+    // same region operator= copies, bitfields and all - pointers in there are
+    // meaningless outside this process and get written again as indices
+    uint32_t stateSize = reinterpret_cast<char*>(&dc) - reinterpret_cast<char*>(&uniqueID);
+    blob.write<uint32_t>(stateSize);
+    blob.writeBytes(&uniqueID, stateSize);
+
+    blob.write<int>(pCurrentAction ? pCurrentAction - pCharData->actions.data() : -1);
+    blob.write<int>(pLastTrigger ? pLastTrigger - pCharData->triggers.data() : -1);
+    blob.write<int>(currentArmor ? currentArmor - pCharData->atemis.data() : -1);
+
+    blob.write<uint32_t>(dc.minions.size());
+    for (GuyRef &minion : dc.minions) {
+        blob.write<int>(minion.guyID);
+    }
+    blob.write<uint32_t>(dc.setDeferredTriggerIDs.size());
+    for (int triggerID : dc.setDeferredTriggerIDs) {
+        blob.write<int>(triggerID);
+    }
+    blob.write<uint32_t>(dc.frameTriggers.size());
+    for (const ActionRef &trigger : dc.frameTriggers) {
+        blob.write<int>(trigger.actionID());
+        blob.write<int>(trigger.styleID());
+    }
+    blob.write<uint32_t>(dc.inputBuffer.size());
+    for (size_t i = 0; i < dc.inputBuffer.size(); i++) {
+        blob.write<uint32_t>(dc.inputBuffer[i]);
+    }
+}
+
+bool Guy::LoadState(StateBlob &blob, Simulation *pNewSim)
+{
+    std::string charName = blob.readString();
+    int charVersion = blob.read<int>();
+    if (blob.overrun) {
+        return false;
+    }
+    CharacterData *pNewCharData = pNewSim->AcquireCharacterData(charName, charVersion);
+    if (!pNewCharData) {
+        return false;
+    }
+
+    uint32_t stateSize = reinterpret_cast<char*>(&dc) - reinterpret_cast<char*>(&uniqueID);
+    if (blob.read<uint32_t>() != stateSize || !blob.readBytes(&uniqueID, stateSize)) {
+        return false;
+    }
+    pCharData = pNewCharData;
+    pSim = pNewSim;
+
+    int actionIndex = blob.read<int>();
+    int triggerIndex = blob.read<int>();
+    int armorIndex = blob.read<int>();
+    if (actionIndex >= (int)pCharData->actions.size() || triggerIndex >= (int)pCharData->triggers.size() ||
+        armorIndex >= (int)pCharData->atemis.size()) {
+        return false;
+    }
+    pCurrentAction = actionIndex >= 0 ? &pCharData->actions[actionIndex] : nullptr;
+    pLastTrigger = triggerIndex >= 0 ? &pCharData->triggers[triggerIndex] : nullptr;
+    currentArmor = armorIndex >= 0 ? &pCharData->atemis[armorIndex] : nullptr;
+
+    dc.minions.clear();
+    uint32_t count = blob.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !blob.overrun; i++) {
+        GuyRef minion;
+        minion.guyID = blob.read<int>();
+        dc.minions.push_back(minion);
+    }
+    dc.setDeferredTriggerIDs.clear();
+    count = blob.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !blob.overrun; i++) {
+        dc.setDeferredTriggerIDs.insert(blob.read<int>());
+    }
+    dc.frameTriggers.clear();
+    count = blob.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !blob.overrun; i++) {
+        int actionID = blob.read<int>();
+        int styleID = blob.read<int>();
+        dc.frameTriggers.insert(ActionRef(actionID, styleID));
+    }
+    dc.inputBuffer.clear();
+    count = blob.read<uint32_t>();
+    if (count > dc.inputBuffer.capacity()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count && !blob.overrun; i++) {
+        dc.inputBuffer.push_back(blob.read<uint32_t>());
+    }
+
+    return !blob.overrun;
+}
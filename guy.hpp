@@ -7,7 +7,6 @@
 #include <set>
 
 #include "main.hpp"
-#include "render.hpp"
 #include "input.hpp"
 #include "fixed.hpp"
 #include "simulation.hpp"
@@ -21,32 +20,40 @@ const Fixed maxScreenCenterDisplacement = Fixed(520);
 
 const int maxFocus = 60000;
 
-void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList);
+void ResolveHits(Simulation *pSim, FrameVector<PendingHit> &pendingHitList);
 
 class Guy;
 
+// a guy in its sim's pool - generation tells whether the slot still holds the
+// guy the ref was taken to, a freed slot keeps its memory so that's always safe
+// to check
 struct GuyRef {
     int guyID = -1;
+    uint32_t generation = 0;
     Guy *pGuy = nullptr;
     GuyRef(Guy* pGuy);
-    operator Guy*() const { return pGuy; }
-    Guy* operator->() const { return pGuy; }
+    // null if that guy has been deleted since
+    Guy *get() const;
+    operator Guy*() const { return get(); }
+    Guy* operator->() const { return get(); }
     GuyRef& operator=(Guy* rhs);
 
     GuyRef() = default;
     GuyRef(const GuyRef&) = default;
     GuyRef& operator=(const GuyRef&) = default;
 
-    bool operator==(Guy* rhs) { return this->pGuy == rhs; }
-    bool operator!=(Guy* rhs) { return this->pGuy != rhs; }
+    bool operator==(Guy* rhs) { return get() == rhs; }
+    bool operator!=(Guy* rhs) { return get() != rhs; }
     void FixRef(std::map<int,Guy*> &guysByID) {
         if (guyID != -1) {
             assert(guysByID.find(guyID) != guysByID.end());
-            pGuy = guysByID[guyID];
+            *this = guysByID[guyID];
         } else {
             pGuy = nullptr;
         }
     }
+    // for a copy from another sim's pool, same slot in ours
+    void FixRef(Simulation *pNewSim);
     // GuyRef operator=(std::nullptr_t rhs) {
     //     pGuy = nullptr;
     //     guyID = -1;
@@ -60,10 +67,18 @@ public:
     void setOpponent(Guy *pGuy) { pOpponent = pGuy; }
     void setAttacker(Guy *pGuy) { pAttacker = pGuy; }
     void setSim(Simulation *sim) { pSim = sim; }
+    // scratch for containers that don't outlive the frame, see FrameArena
+    std::pmr::memory_resource *frameMemory() {
+        return pSim ? static_cast<std::pmr::memory_resource *>(&pSim->frameArena) : std::pmr::get_default_resource();
+    }
     Guy *getAttacker() { return pAttacker; }
     Guy *getOpponent() { return pOpponent; }
     Guy *getParent() { return pParent; }
     void FixRefs(std::map<int,Guy*> &guysByID);
+    void FixRefs(Simulation *pNewSim);
+    // refs are left to FixRefs once every guy of the sim is loaded
+    void SaveState(StateBlob &blob);
+    bool LoadState(StateBlob &blob, Simulation *pSim);
 
     void Input(int input);
     bool RunFrame(bool advancingTime = true);
@@ -71,7 +86,7 @@ public:
     bool Push(Guy *pOtherGuy);
     void RunFramePostPush(void);
     bool WorldPhysics(bool onlyFloor = false, bool projBoundaries = false);
-    void CheckHit(Guy *pOtherGuy, std::vector<PendingHit> &pendingHitList);
+    void CheckHit(Guy *pOtherGuy, FrameVector<PendingHit> &pendingHitList);
     bool AdvanceFrame(bool advancingTime = true, bool endHitStopFrame = false, bool endWarudoFrame = false);
     std::string getActionName(int actionID);
 
@@ -266,10 +281,10 @@ public:
     int getProjHitCount() { return projHitCount; }
     int getLimitShotCategory() { return limitShotCategory; }
 
-    void getPushBoxes(std::vector<Box> *pOutPushBoxes, std::vector<RenderBox> *pOutRenderBoxes = nullptr);
-    void getHitBoxes(std::vector<HitBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes = nullptr, hitBoxType typeFilter = hitBoxType::none, hitBoxType typeExclude = hitBoxType::none);
-    void getUniqueBoxes(std::vector<UniqueBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes = nullptr);
-    void getHurtBoxes(std::vector<HurtBox> *pOutHurtBoxes, std::vector<HurtBox> *pOutThrowBoxes = nullptr, std::vector<RenderBox> *pOutRenderBoxes = nullptr);
+    void getPushBoxes(FrameVector<Box> *pOutPushBoxes, std::vector<RenderBox> *pOutRenderBoxes = nullptr);
+    void getHitBoxes(FrameVector<HitBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes = nullptr, hitBoxType typeFilter = hitBoxType::none, hitBoxType typeExclude = hitBoxType::none);
+    void getUniqueBoxes(FrameVector<UniqueBox> *pOutHitBoxes, std::vector<RenderBox> *pOutRenderBoxes = nullptr);
+    void getHurtBoxes(FrameVector<HurtBox> *pOutHurtBoxes, FrameVector<HurtBox> *pOutThrowBoxes = nullptr, std::vector<RenderBox> *pOutRenderBoxes = nullptr);
 
     int getCurrentAction() { return currentAction; }
     Action *getCurrentActionPtr() { return pCurrentAction; }
@@ -312,10 +327,9 @@ public:
         }
         dc.minions.clear();
 
-        std::vector<Guy*> *pGuyList = &guys;
-        if (pSim) {
-            pGuyList = &pSim->simGuys;
-        }
+        // every set up guy has a sim, a bare one has no list to leave
+        std::vector<Guy*> noGuys;
+        std::vector<Guy*> *pGuyList = pSim ? &pSim->simGuys : &noGuys;
 
 
         if (pParent) {
@@ -326,6 +340,9 @@ public:
             const auto it = std::remove(pGuyList->begin(), pGuyList->end(), this);
             pGuyList->erase(it, pGuyList->end());
         }
+        if (pSim) {
+            pSim->markRosterDirty();
+        }
 
         std::vector<Guy *> everyone;
         for (auto guy : *pGuyList) {
@@ -344,6 +361,14 @@ public:
         }
     }
 
+    // guys only live in their sim's pool, new (pSim) Guy(...)
+    static void *operator new(size_t size, Simulation *pSim) {
+        assert(size == sizeof(Guy));
+        return pSim->AllocGuySlot();
+    }
+    static void operator delete(void *pGuy) { Simulation::FreeGuySlot(pGuy); }
+    static void operator delete(void *pGuy, Simulation *) { Simulation::FreeGuySlot(pGuy); }
+
     Guy(void) {}
 
     Guy& operator=(const Guy& other) {
@@ -369,7 +394,7 @@ public:
         charColorG = color.g;
         charColorB = color.b;
 
-        pCharData = loadCharacter(charName, version);
+        pCharData = pSim->AcquireCharacterData(charName, version);
 
         Input(0);
     
@@ -559,7 +584,7 @@ private:
     bool wasOnRightWall(bool proj = false) { return getLastPosX(true) >= (proj ? projWallDistance : wallDistance); }
     bool wasOnWall(bool proj = false) { return wasOnLeftWall(proj) || wasOnRightWall(proj); }
 
-    bool conditionOperator(int op, int operand, int threshold, std::string desc);
+    bool conditionOperator(int op, int operand, int threshold, const char *desc);
 
     bool needsTurnaround(Fixed threshold = Fixed(0), Fixed directionOverride = Fixed(0)) {
         bool turnaround = false;
@@ -1194,13 +1219,35 @@ private:
         std::deque<std::string> logQueue;
     } nc;
 
-    friend void ResolveHits(Simulation *pSim, std::vector<PendingHit> &pendingHitList);
+    friend void ResolveHits(Simulation *pSim, FrameVector<PendingHit> &pendingHitList);
+};
+
+struct GuySlot {
+    Simulation *pSim = nullptr;
+    uint32_t index = 0;
+    uint32_t generation = 0;
+    bool live = false;
+    alignas(Guy) unsigned char storage[sizeof(Guy)];
+
+    Guy *guy() { return reinterpret_cast<Guy *>(storage); }
 };
 
+inline GuySlot *guySlotOf(const Guy *pGuy) {
+    return reinterpret_cast<GuySlot *>((uint8_t *)pGuy - offsetof(GuySlot, storage));
+}
+
+inline Guy *GuyRef::get() const {
+    if (pGuy && guySlotOf(pGuy)->generation == generation) {
+        return pGuy;
+    }
+    return nullptr;
+}
+
 inline GuyRef& GuyRef::operator=(Guy* rhs) {
     pGuy = rhs;
     if (pGuy) {
         guyID = pGuy->getUniqueID();
+        generation = guySlotOf(pGuy)->generation;
     } else {
         guyID = -1;
     }
@@ -1208,10 +1255,11 @@ inline GuyRef& GuyRef::operator=(Guy* rhs) {
 }
 
 inline GuyRef::GuyRef(Guy *pGuy) {
-    this->pGuy = pGuy;
-    if (this->pGuy) {
-        this->guyID = pGuy->getUniqueID();
-    } else {
-        this->guyID = -1;
+    *this = pGuy;
+}
+
+inline void GuyRef::FixRef(Simulation *pNewSim) {
+    if (pGuy) {
+        pGuy = pNewSim->guySlots[guySlotOf(pGuy)->index]->guy();
     }
 }
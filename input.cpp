@@ -132,23 +132,6 @@ private:
 std::vector<TouchButton> vecTouchButtons;
 std::vector<TouchPad> vecTouchPads;
 
-int addPressBits(int curInput, int prevInput)
-{
-    // put down the _pressed bits on first appearance
-    int retInput = curInput;
-    int key = 4;
-    while (key < 10)
-    {
-        int keyInput = 1<<key;
-        if (curInput & keyInput && !(prevInput & keyInput)) {
-            retInput |= 1<<(key+6);
-        }
-        key++;
-    }
-
-    return retInput;
-}
-
 void updateInputs(int sizeX, int sizeY)
 {
     // clear new press bits
@@ -214,10 +197,10 @@ void updateInputs(int sizeX, int sizeY)
                     currentInputMap[keyboardID] |= HK_pressed;
                     break;
                 case SDLK_z:
-                    saveState = true;
+                    queueTrainingCommand([]() { saveState = true; });
                     break;
                 case SDLK_x:
-                    restoreState = true;
+                    queueTrainingCommand([]() { restoreState = true; });
                     break;
                 case SDLK_c:
                     if (!showComboFinder) {
@@ -230,35 +213,51 @@ void updateInputs(int sizeX, int sizeY)
                     if (gameMode != Training) {
                         simController.playing = !simController.playing;
                     } else {
-                        paused = !paused;
+                        queueTrainingCommand([]() { paused = !paused; });
                     }
                     break;
                 case SDLK_q:
-                    resetpos = true;
+                    queueTrainingCommand([]() { resetpos = true; });
                     break;
                 case SDLK_0:
                     if (gameMode != Training) {
                         simController.scrubberFrame++;
                         simController.clampFrame(simController.scrubberFrame);
                     } else {
-                        oneframe = true;
+                        queueTrainingCommand([]() { oneframe = true; });
                     }
                     break;
-                case SDLK_BACKQUOTE:
-                    if (defaultSim.simGuys.size()) {
-                        defaultSim.simGuys[0]->setFocus(0);
-                        defaultSim.simGuys[0]->setGauge(0);
+                case SDLK_9:
+                    if (gameMode == Training) {
+                        queueTrainingCommand([]() { rewindToFrame = defaultSim.frameCounter - 1; });
                     }
                     break;
-                case SDLK_1:
-                    if (defaultSim.simGuys.size()) {
-                        defaultSim.simGuys[0]->setFocus(defaultSim.simGuys[0]->getFocus() + 10000, true);
+                case SDLK_BACKSPACE:
+                    if (gameMode == Training) {
+                        queueTrainingCommand([]() { rewindToFrame = defaultSim.frameCounter - 60; });
                     }
                     break;
+                case SDLK_BACKQUOTE:
+                    queueTrainingCommand([]() {
+                        if (defaultSim.simGuys.size()) {
+                            defaultSim.simGuys[0]->setFocus(0);
+                            defaultSim.simGuys[0]->setGauge(0);
+                        }
+                    });
+                    break;
+                case SDLK_1:
+                    queueTrainingCommand([]() {
+                        if (defaultSim.simGuys.size()) {
+                            defaultSim.simGuys[0]->setFocus(defaultSim.simGuys[0]->getFocus() + 10000, true);
+                        }
+                    });
+                    break;
                 case SDLK_2:
-                    if (defaultSim.simGuys.size()) {
-                        defaultSim.simGuys[0]->setGauge(defaultSim.simGuys[0]->getGauge() + 10000);
-                    }
+                    queueTrainingCommand([]() {
+                        if (defaultSim.simGuys.size()) {
+                            defaultSim.simGuys[0]->setGauge(defaultSim.simGuys[0]->getGauge() + 10000);
+                        }
+                    });
                     break;
                 case SDLK_F2:
                     toggleRenderUI = !toggleRenderUI;
@@ -273,31 +272,16 @@ void updateInputs(int sizeX, int sizeY)
                     lockCamera = !lockCamera;
                     break;
                 case SDLK_F8:
-                    limitRate = !limitRate;
+                    queueTrainingCommand([]() { limitRate = !limitRate; });
                     break;
                 case SDLK_F12:
                     toggleDebugUI = !toggleDebugUI;
                     break;
                 case SDLK_r:
-                    recordingInput = !recordingInput;
-                    if (recordingInput == true) {
-                        // so we can easily look for dupes
-                        timelineToInputBuffer(playBackInputBuffer);
-                        recordingStartFrame = defaultSim.frameCounter;
-                        if (playingBackInput) {
-                            playingBackInput = false;
-                        }
-                    }
+                    toggleTrainingRecording();
                     break;
                 case SDLK_t:
-                    playingBackInput = !playingBackInput;
-                    if (playingBackInput == true) {
-                        timelineToInputBuffer(playBackInputBuffer);
-                        playBackFrame = 0;
-                    } else {
-                        currentInputMap[recordingID] = 0;
-                    }
-                    paused = false;
+                    toggleTrainingPlayback();
                     break;
                 case SDLK_DELETE:
                     deleteInputs = true;
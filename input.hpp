@@ -114,9 +114,25 @@ static inline int angleDiff(int curAngle, int futureAngle)
 	return res;
 }
 
+static inline int addPressBits(int curInput, int prevInput)
+{
+	// put down the _pressed bits on first appearance
+	int retInput = curInput;
+	int key = 4;
+	while (key < 10)
+	{
+		int keyInput = 1<<key;
+		if (curInput & keyInput && !(prevInput & keyInput)) {
+			retInput |= 1<<(key+6);
+		}
+		key++;
+	}
+
+	return retInput;
+}
+
 extern std::map<int, int> currentInputMap;
 
-int addPressBits(int curInput, int prevInput);
 void updateInputs(int sizeX, int sizeY);
 void initTouchControls(void);
 void renderTouchControls(int sizeX, int sizeY);
\ No newline at end of file
@@ -11,6 +11,10 @@
 #include <deque>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
 #include <bitset>
 #include <unordered_set>
 #include <numbers>
@@ -28,142 +32,8 @@
 #include "render.hpp"
 #include "combogen.hpp"
 #include "chara.hpp"
-
-EGameMode gameMode = Training;
-
-bool forceCounter = false;
-bool forcePunishCounter = false;
-
-struct charEntry {
-    int charID;
-    const char *name;
-    const char *niceName;
-};
-
-std::vector<charEntry> charEntries;
-std::vector<const char *> charNames;
-std::vector<const char *> charNiceNames;
-
-void makeCharEntries(void)
-{
-    charEntries.push_back({1, "ryu", "Ryu"});
-    charEntries.push_back({2, "luke", "Luke"});
-    charEntries.push_back({3, "kimberly", "Kimberly"});
-    charEntries.push_back({4, "chunli", "Chun-Li"});
-    charEntries.push_back({5, "manon", "Manon"});
-    charEntries.push_back({6, "zangief", "Zangief"});
-    charEntries.push_back({7, "jp", "JP"});
-    charEntries.push_back({8, "dhalsim", "Dhalsim"});
-    charEntries.push_back({9, "cammy", "Cammy"});
-    charEntries.push_back({10, "ken", "Ken"});
-    charEntries.push_back({11, "deejay", "Dee Jay"});
-    charEntries.push_back({12, "lily", "Lily"});
-    charEntries.push_back({13, "aki", "A.K.I."});
-    charEntries.push_back({14, "rashid", "Rashid"});
-    charEntries.push_back({15, "blanka", "Blanka"});
-    charEntries.push_back({16, "juri", "Juri"});
-    charEntries.push_back({17, "marisa", "Marisa"});
-    charEntries.push_back({18, "guile", "Guile"});
-    charEntries.push_back({19, "ed", "Ed"});
-    charEntries.push_back({20, "honda", "E. Honda"});
-    charEntries.push_back({21, "jamie", "Jamie"});
-    charEntries.push_back({22, "akuma", "Akuma"});
-    charEntries.push_back({25, "sagat", "Sagat"});
-    charEntries.push_back({26, "dictator", "M. Bison"});
-    charEntries.push_back({27, "terry", "Terry"});
-    charEntries.push_back({28, "mai", "Mai"});
-    charEntries.push_back({29, "elena", "Elena"});
-    charEntries.push_back({30, "viper", "C. Viper"});
-    charEntries.push_back({31, "alex", "Alex"});
-    charEntries.push_back({32, "ingrid", "Ingrid"});
-
-    for (charEntry &entry : charEntries ) {
-        charNames.push_back(entry.name);
-        charNiceNames.push_back(entry.niceName);
-    }
-}
-
-const char *getCharNameFromID(int charID)
-{
-    for (charEntry &entry : charEntries ) {
-        if (entry.charID == charID) {
-            return entry.name;
-        }
-    }
-
-    return nullptr;
-}
-
-const char *getCharNiceNameFromID(int charID)
-{
-    for (charEntry &entry : charEntries ) {
-        if (entry.charID == charID) {
-            return entry.niceName;
-        }
-    }
-
-    return nullptr;
-}
-
-int getCharIDFromName(const char *charName)
-{
-    for (charEntry &entry : charEntries) {
-        if (strcmp(entry.name, charName) == 0) {
-            return entry.charID;
-        }
-    }
-
-    return 0;
-}
-
-const char* charVersions[] = {
-    "19 - S1 February Update",
-    "20 - S2 Akuma Update",
-    "21 - S2 Hotfix 1",
-    "22 - S2 Hotfix 2",
-    "23 - S2 M. Bison Update",
-    "24 - S2 Terry Update",
-    "25 - S2 December Update",
-    "26 - S2 Mai Update",
-    "30 - S3 Elena Update + Hotfix 1",
-    "31 - S3 Hotfix 2",
-    "32 - S3 Hotfix 3",
-    "33 - S3 Hotfix 4",
-    "34 - S3 Sagat Update",
-    "35 - S3 Sagat Hotfix 1",
-    "36 - S3 Viper Update",
-    "37 - S3 Viper Hotfix 1",
-    "38 - S3 Viper Hotfix 2",
-    "39 - S3 December Update",
-    "40 - S3 Alex Update",
-    "41 - S3 Alex Hotfix",
-    "42 - S3 Ingrid Update",
-};
-const int charVersionCount = IM_ARRAYSIZE(charVersions);
-
-int simVersionFromGameVersion(int gameVersion, int64_t time)
-{
-    static const struct { int game; int64_t time; int sim; } table[] = {
-        { 0,                 0, 19 },
-        { 10005000,          0, 21 }, // no 20 replays as that was hotfixed same day
-        { 10005000, 1717286400, 22 }, // hotfix 2 dropped like a week after
-        { 10006000,          0, 23 },
-        { 10007000,          0, 24 },
-        { 10008000,          0, 25 },
-        { 10009000,          0, 26 },
-        { 20002010,          0, 41 },
-        { 20003000,          0, 42 },
-    };
-    int ret = table[0].sim;
-    for (const auto &row : table) {
-        if (gameVersion > row.game || (gameVersion == row.game && time >= row.time)) {
-            ret = row.sim;
-        } else {
-            break;
-        }
-    }
-    return ret;
-}
+#include "gamedump.hpp"
+#include "batch.hpp"
 
 bool resetpos = false;
 
@@ -184,36 +54,45 @@ struct guyCreateInfo_t {
 };
 
 std::vector<guyCreateInfo_t> vecDeferredCreateGuys;
-bool newCharLoaded = false;
 
 struct PendingViewerLoad {
     bool active = false;
     bool isReplay = false;
     std::string path;
-    std::vector<std::string> neededChars;
+    std::vector<std::pair<std::string, int>> neededChars;
     int version;
 };
 PendingViewerLoad pendingViewerLoad;
 
-void createGuyNow(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color)
+void createGuyNow(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color, bool training)
 {
-    Guy *pNewGuy = new Guy(&defaultSim, charName, charVersion, x, y, startDir, color);
+    Guy *pNewGuy = new (&defaultSim) Guy(&defaultSim, charName, charVersion, x, y, startDir, color);
 
     if (guys.size()) {
         pNewGuy->setOpponent(guys[0]);
         if (guys.size() == 1) {
             guys[0]->setOpponent(pNewGuy);
         }
-    } else if (gameMode == Training) {
+    } else if (training) {
         *pNewGuy->getInputIDPtr() = keyboardID;
         *pNewGuy->getInputListIDPtr() = 1; // its spot in the UI, or it'll override it :/
     }
     defaultSim.simGuys.push_back(pNewGuy);
+    defaultSim.markRosterDirty();
 
     pNewGuy->DoInstantAction(580); // IMM_STAGE_INIT
     pNewGuy->DoInstantAction(581); // IMM_ROUND_INIT
 }
 
+// guys only ever get made on the training sim thread
+static void queueCreateGuy(const guyCreateInfo_t &info)
+{
+    bool training = gameMode == Training;
+    queueTrainingCommand([info, training]() {
+        createGuyNow(info.charName, info.charVersion, info.x, info.y, info.startDir, info.col, training);
+    });
+}
+
 bool isCharLoaded(const std::string& charName, int charVersion)
 {
     if (charName == "") {
@@ -223,8 +102,19 @@ bool isCharLoaded(const std::string& charName, int charVersion)
     std::string charSpec = charName + std::to_string(charVersion);
     return setCharsLoaded.find(charSpec) != setCharsLoaded.end();
 #else
-    (void)charVersion;
-    return true;
+    return isCharacterLoaded(charName, charVersion);
+#endif
+}
+
+bool isCharLoadFailed(const std::string& charName, int charVersion)
+{
+    if (charName == "") {
+        return false;
+    }
+#ifdef __EMSCRIPTEN__
+    return false;
+#else
+    return isCharacterLoadFailed(charName, charVersion);
 #endif
 }
 
@@ -234,7 +124,7 @@ void requestCharDownload(const std::string& charName, int charVersion)
         return;
     }
 #ifndef __EMSCRIPTEN__
-    (void)charVersion;
+    requestCharacterPreload(charName, charVersion);
 #else
     std::string charSpec = charName + std::to_string(charVersion);
     if (setCharsLoaded.find(charSpec) != setCharsLoaded.end()) {
@@ -265,65 +155,61 @@ void requestCharDownload(const std::string& charName, int charVersion)
 
 void createGuy(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color)
 {
-#ifdef __EMSCRIPTEN__
-    std::string charSpec = charName + std::to_string(charVersion);
-    if (setCharsLoaded.find(charSpec) == setCharsLoaded.end()) {
-        bool needDownload = true;
-        for (auto& deferred : vecDeferredCreateGuys) {
-            if (deferred.charName == charName && deferred.charVersion == charVersion)
-                needDownload = false;
-        }
-
+    // queue behind anything already waiting so guys keep their creation order
+    if (!isCharLoaded(charName, charVersion) || !vecDeferredCreateGuys.empty()) {
         vecDeferredCreateGuys.push_back({charName,charVersion,x,y,startDir,color});
-
-        if (!needDownload)
-            return;
-
         requestCharDownload(charName, charVersion);
     } else {
-        createGuyNow(charName, charVersion, x, y, startDir, color);
+        queueCreateGuy({charName,charVersion,x,y,startDir,color});
     }
-#else
-    createGuyNow(charName, charVersion, x, y, startDir, color);
-#endif
 }
 
 void doDeferredCreateGuys(void)
 {
-    std::vector<guyCreateInfo_t> vecDeferredNotDoneYet;
-    if (newCharLoaded) {
-        for (auto& deferredCreate : vecDeferredCreateGuys) {
-            std::string charSpec = deferredCreate.charName + std::to_string(deferredCreate.charVersion);
-            if (setCharsLoaded.find(charSpec) != setCharsLoaded.end()) {
-                createGuyNow(deferredCreate.charName, deferredCreate.charVersion, deferredCreate.x, deferredCreate.y, deferredCreate.startDir, deferredCreate.col);
-            } else {
-                vecDeferredNotDoneYet.push_back(deferredCreate);
-            }
+    size_t doneCount = 0;
+    for (auto& deferredCreate : vecDeferredCreateGuys) {
+        // a guy whose char failed to load is dropped so it doesn't hold up the ones behind it
+        if (isCharLoadFailed(deferredCreate.charName, deferredCreate.charVersion)) {
+            log("couldn't load " + deferredCreate.charName + std::to_string(deferredCreate.charVersion) + ", not creating guy");
+        } else if (isCharLoaded(deferredCreate.charName, deferredCreate.charVersion)) {
+            queueCreateGuy(deferredCreate);
+        } else {
+            break;
         }
-        vecDeferredCreateGuys = vecDeferredNotDoneYet;
-        newCharLoaded = false;
+        doneCount++;
     }
+    vecDeferredCreateGuys.erase(vecDeferredCreateGuys.begin(), vecDeferredCreateGuys.begin() + doneCount);
 
     if (pendingViewerLoad.active) {
         bool allReady = true;
-        for (auto &charSpec : pendingViewerLoad.neededChars) {
-            if (setCharsLoaded.find(charSpec) == setCharsLoaded.end()) {
-                allReady = false;
+        bool anyFailed = false;
+        for (auto &[charName, charVersion] : pendingViewerLoad.neededChars) {
+            if (isCharLoadFailed(charName, charVersion)) {
+                log("couldn't load " + charName + std::to_string(charVersion) + ", cancelling load of " + pendingViewerLoad.path);
+                anyFailed = true;
                 break;
             }
+            if (!isCharLoaded(charName, charVersion)) {
+                allReady = false;
+            }
         }
-        if (allReady) {
+        if (anyFailed) {
+            pendingViewerLoad.active = false;
+        } else if (allReady) {
+            simController.CancelSimulation();
             simController.charCount = 2;
             gameMode = Viewer;
             if (pendingViewerLoad.isReplay) {
                 simController.viewerDumpPath.clear();
-                simController.SimulateAllReplayRounds();
-                simController.LoadReplayRound(0);
+                simController.replayPath = pendingViewerLoad.path;
+                simController.SimulateAllReplayRounds(0);
             } else {
                 simController.replayRoundCount = 0;
                 simController.replayCurrentRound = -1;
                 simController.replayRoundRecordings.clear();
-                simController.replayInputData.clear();
+                simController.replay.inputData.clear();
+                simController.replayPath.clear();
+                simController.replayIndex = ReplayIndex();
                 simController.LoadFromGameDump(pendingViewerLoad.path, pendingViewerLoad.version);
             }
             simInputsChanged = false;
@@ -332,15 +218,43 @@ void doDeferredCreateGuys(void)
     }
 }
 
+// request every char the file needs, the viewer gets set up from
+// doDeferredCreateGuys once they're all loaded
+void startViewerLoad(const std::string &path, nlohmann::json &parsed, bool isReplay, int version)
+{
+    pendingViewerLoad = {};
+    pendingViewerLoad.active = true;
+    pendingViewerLoad.path = path;
+    pendingViewerLoad.version = version;
+    pendingViewerLoad.isReplay = isReplay;
+
+    if (isReplay) {
+        for (int i = 0; i < 2; i++) {
+            int fighterID = simController.replay.replayInfo["Fighters"][i]["FighterID"];
+            std::string charName = getCharNameFromID(fighterID);
+            pendingViewerLoad.neededChars.push_back({charName, simController.replay.version});
+            requestCharDownload(charName, simController.replay.version);
+        }
+    } else {
+        // otherwise treat as dump — extract char names from first frame's players
+        GameDump dump;
+        bool loaded = parsed.is_array() ? loadGameDumpFromJson(parsed, dump) : loadGameDump(path, dump);
+        if (loaded) {
+            for (int i = 0; i < 2; i++) {
+                std::string charName = getCharNameFromID(dump.get(0, i, eDumpCharID));
+                pendingViewerLoad.neededChars.push_back({charName, version});
+                requestCharDownload(charName, version);
+            }
+        }
+    }
+}
+
 extern "C" {
 
 void jsCharLoadCallback(char *charVerKey)
 {
     log(std::string(charVerKey) + " download complete");
-    if (setCharsLoaded.find(charVerKey) == setCharsLoaded.end()) {
-        setCharsLoaded.insert(charVerKey);
-        newCharLoaded = true;
-    }
+    setCharsLoaded.insert(charVerKey);
 }
 
 void jsLoadFile(char *filePath)
@@ -348,44 +262,20 @@ void jsLoadFile(char *filePath)
     int maxVersion = atoi(charVersions[charVersionCount - 1]);
     std::string path(filePath);
 
+    if (isBinaryGameDump(path)) {
+        nlohmann::json noJson;
+        startViewerLoad(path, noJson, false, maxVersion);
+        return;
+    }
+
     nlohmann::json parsed = parse_json_file(path);
     if (parsed == nullptr) {
         fprintf(stderr, "failed to parse dropped file\n");
         return;
     }
 
-    pendingViewerLoad = {};
-    pendingViewerLoad.active = true;
-    pendingViewerLoad.path = path;
-    pendingViewerLoad.version = maxVersion;
-
-    if (simController.LoadFromReplay(parsed, maxVersion)) {
-        pendingViewerLoad.isReplay = true;
-
-        for (int i = 0; i < 2; i++) {
-            int fighterID = simController.replayInfo["Fighters"][i]["FighterID"];
-            std::string charName = getCharNameFromID(fighterID);
-            std::string charSpec = charName + std::to_string(maxVersion);
-            pendingViewerLoad.neededChars.push_back(charSpec);
-            requestCharDownload(charName, maxVersion);
-        }
-    } else {
-        // otherwise treat as dump — extract char names from first frame's players
-        pendingViewerLoad.isReplay = false;
-
-        for (int i = 0; i < (int)parsed.size() && i < 1; i++) {
-            if (parsed[i].contains("players")) {
-                for (auto &p : parsed[i]["players"]) {
-                    std::string charName = getCharNameFromID(p["charID"]);
-                    std::string charSpec = charName + std::to_string(maxVersion);
-                    pendingViewerLoad.neededChars.push_back(charSpec);
-                    requestCharDownload(charName, maxVersion);
-                }
-                break;
-            }
-        }
-    }
-
+    bool isReplay = simController.LoadFromReplay(parsed, maxVersion);
+    startViewerLoad(path, parsed, isReplay, maxVersion);
 }
 
 }
@@ -427,92 +317,776 @@ bool limitRate = true;
 
 bool deleteInputs = false;
 
-void writeFile(const std::string &fileName, std::string contents)
+std::deque<std::string> logQueue;
+
+extern "C" {
+
+void jsLog(char *logLine)
 {
-    std::ofstream ofs(fileName.c_str(), std::ios::out | std::ios::trunc);
-    if (ofs.is_open()) {
-        ofs.write(contents.c_str(), contents.size());
+    log("JS:" + std::string(logLine));
+}
+
+}
+
+// log can be hit from the char preload workers, lines get staged here and
+// moved to logQueue on the main thread
+std::mutex mutexPendingLog;
+std::vector<std::string> vecPendingLog;
+
+static void queueLogLine(std::string logLine)
+{
+    std::scoped_lock lock(mutexPendingLog);
+    vecPendingLog.push_back(logLine);
+}
+
+void flushPendingLog(void)
+{
+    std::scoped_lock lock(mutexPendingLog);
+    for (auto &logLine : vecPendingLog) {
+        logQueue.push_back(logLine);
+        if (logQueue.size() > 15) {
+            logQueue.pop_front();
+        }
     }
+    vecPendingLog.clear();
 }
 
-std::string readFile(const std::string &fileName)
+uint32_t frameStartTime;
+ImGuiIO *io;
+SDL_Window *sdlwindow;
+color clearColor = {0.0,0.0,0.0};
+
+// training mode ticks on its own thread at a fixed 60Hz, so a slow ui frame
+// can't push sim frames around, and neither side ever waits on the other's
+// work. the main thread queues commands and the inputs it samples (with when
+// it sampled them) under trainingQueueMutex, and the sim thread hands frames
+// back under trainingPublishMutex - both only get held for a swap
+std::thread trainingSimThread;
+std::atomic<bool> trainingSimStop = false;
+// gameMode == Training, as of the main thread's last frame
+std::atomic<bool> trainingSimActive = false;
+TrainingTickStats trainingTickStats;
+
+struct QueuedInput {
+    std::chrono::steady_clock::time_point time;
+    std::map<int, int> inputs;
+};
+std::mutex trainingQueueMutex;
+std::vector<std::function<void()>> trainingCommandQueue;
+std::deque<QueuedInput> trainingInputQueue;
+// what the sim reads its inputs from, built from the queue every tick
+std::map<int, int> trainingInputMap;
+
+void queueTrainingCommand(std::function<void()> command)
 {
-    std::ifstream ifs(fileName.c_str(), std::ios::in | std::ios::ate);
+    std::scoped_lock lock(trainingQueueMutex);
+    trainingCommandQueue.push_back(std::move(command));
+}
 
-    std::ifstream::pos_type fileSize = ifs.tellg();
-    if (fileSize < 0)                             
-        return std::string();                     
+void editTrainingGuy(Guy *pGuy, std::function<void(Guy *)> edit)
+{
+    if (guySlotOf(pGuy)->pSim != &trainingViewSim) {
+        edit(pGuy);
+        return;
+    }
+    // the view mirrors the live sim's guy pool slot for slot
+    GuyRef ref(pGuy);
+    queueTrainingCommand([ref, edit]() mutable {
+        ref.FixRef(&defaultSim);
+        if (Guy *pLiveGuy = ref.get()) {
+            edit(pLiveGuy);
+        }
+    });
+}
 
-    ifs.seekg(0, std::ios::beg);
+static void queueTrainingInputs(void)
+{
+    static std::map<int, int> lastQueuedInputs;
+    if (currentInputMap == lastQueuedInputs) {
+        return;
+    }
+    std::scoped_lock lock(trainingQueueMutex);
+    trainingInputQueue.push_back({std::chrono::steady_clock::now(), currentInputMap});
+    lastQueuedInputs = currentInputMap;
+}
 
-    std::vector<char> bytes(fileSize);
-    ifs.read(&bytes[0], fileSize);
+// held buttons come from the latest sample, presses from every sample since
+// the last tick so none get lost when the ui runs faster than the sim
+static void takeTrainingInputs(std::deque<QueuedInput> &inputQueue, std::chrono::steady_clock::time_point tickTime,
+                               float &latencySumMS, float &worstLatencyMS, int &latencyCount)
+{
+    const int pressedBits = LP_pressed+MP_pressed+HP_pressed+LK_pressed+MK_pressed+HK_pressed;
+    for (auto &[slot, input] : trainingInputMap) {
+        input &= ~pressedBits;
+    }
+    while (!inputQueue.empty()) {
+        QueuedInput &queued = inputQueue.front();
+        for (auto &[slot, input] : queued.inputs) {
+            // playback writes that one on this side
+            if (slot != recordingID) {
+                trainingInputMap[slot] = input | (trainingInputMap[slot] & pressedBits);
+            }
+        }
+        float latencyMS = std::chrono::duration<float, std::milli>(tickTime - queued.time).count();
+        latencySumMS += latencyMS;
+        worstLatencyMS = std::max(worstLatencyMS, latencyMS);
+        latencyCount++;
+        inputQueue.pop_front();
+    }
+    if (!playingBackInput) {
+        trainingInputMap[recordingID] = 0;
+    }
+}
 
-    return std::string(&bytes[0], fileSize);
+// rollback training: the remote guy's inputs show up late like they would
+// over the network. until they do the sim guesses, and once they're in it
+// goes back to the first frame it guessed wrong and runs up to the present
+// again within the same tick
+RollbackSettings rollbackSettings;
+
+static constexpr int kRollbackFrames = 16;
+struct RollbackFrame {
+    // right before the frame ran
+    Simulation state;
+    std::vector<int> guyInputs;
+    bool hasInput = true;
+    bool confirmed = false;
+    int confirmedInput = 0;
+};
+RollbackFrame rollbackRing[kRollbackFrames];
+// oldest frame still in the ring, -1 when it's empty
+int rollbackFirstFrame = -1;
+int rollbackNextFrame = 0;
+size_t rollbackGuyCount = 0;
+int rollbackRingRemoteGuy = 0;
+// last remote input heard from before the ring starts
+int rollbackBaseRemoteInput = 0;
+
+struct RemoteInput {
+    int frame;
+    int arriveFrame;
+    int input;
+};
+std::deque<RemoteInput> rollbackInFlight;
+
+struct {
+    int resimFrames = 0;
+    float resimSeconds = 0.0f;
+    int rollbackCount = 0;
+    int worstRollbackFrames = 0;
+} rollbackStats;
+
+// the last few seconds of training mode, the sim as it was after each frame.
+// rewinding pauses on one of them, running a frame from there drops the
+// frames that came after it
+static constexpr int kHistoryFrames = 5 * 60;
+Simulation trainingHistory[kHistoryFrames];
+int trainingHistoryFirstFrame = -1;
+int trainingHistoryLastFrame = -1;
+int rewindToFrame = -1;
+
+static void recordTrainingHistory(void)
+{
+    int frame = defaultSim.frameCounter;
+    if (trainingHistoryFirstFrame == -1 || frame <= trainingHistoryFirstFrame || frame > trainingHistoryLastFrame + 1) {
+        trainingHistoryFirstFrame = frame;
+    }
+    trainingHistoryLastFrame = frame;
+    trainingHistoryFirstFrame = std::max(trainingHistoryFirstFrame, frame - kHistoryFrames + 1);
+    trainingHistory[frame % kHistoryFrames].Clone(&defaultSim);
 }
 
-nlohmann::json parse_json_file(const std::string &fileName)
+static void resetTrainingRollback(void)
 {
-    std::string fileText = readFile(fileName);
-    if (fileText == "") return nullptr;
-    return nlohmann::json::parse(fileText);
+    rollbackFirstFrame = -1;
+    rollbackBaseRemoteInput = 0;
+    rollbackInFlight.clear();
 }
 
+// what ticks leave for the main thread that a snapshot of the sim doesn't
+// cover, piled up until it takes a frame
+std::vector<int> trainingRecordedInput;
+std::vector<FrameEvent> trainingHitEvents;
+std::vector<normalRangePlotEntry> trainingPlotEntries;
+bool trainingPlotEntriesChanged = false;
+
+// the sim thread clones into its back buffer and swaps it with the ready one,
+// the main thread swaps the ready one with its own before cloning that into
+// trainingViewSim - nobody clones with trainingPublishMutex held
+Simulation trainingSimBuffers[3];
+Simulation *pTrainingBackSim = &trainingSimBuffers[0];
+Simulation *pTrainingReadySim = &trainingSimBuffers[1];
+Simulation *pTrainingTakenSim = &trainingSimBuffers[2];
+std::mutex trainingPublishMutex;
+struct {
+    bool fresh = false;
+    TrainingStatus status;
+    std::vector<int> recordedInput;
+    std::vector<FrameEvent> hitEvents;
+    bool plotEntriesChanged = false;
+    std::vector<normalRangePlotEntry> plotEntries;
+} trainingPublished;
+
+TrainingStatus trainingStatus;
+Simulation trainingViewSim;
+
+static void publishTrainingFrame(void)
+{
+    pTrainingBackSim->Clone(&defaultSim);
+
+    TrainingStatus status;
+    status.paused = paused;
+    status.limitRate = limitRate;
+    status.recordingInput = recordingInput;
+    status.playingBackInput = playingBackInput;
+    status.playBackFrame = playBackFrame;
+    status.runUntilFrame = runUntilFrame;
+    status.historyFirstFrame = trainingHistoryFirstFrame;
+    status.historyLastFrame = trainingHistoryLastFrame;
+    status.rollback = rollbackSettings;
+    status.tickStats = trainingTickStats;
+
+    std::vector<normalRangePlotEntry> plotEntries;
+    if (trainingPlotEntriesChanged) {
+        plotEntries = trainingPlotEntries;
+    }
 
-std::string to_string_leading_zeroes(unsigned int number, unsigned int length)
+    std::scoped_lock lock(trainingPublishMutex);
+    std::swap(pTrainingBackSim, pTrainingReadySim);
+    trainingPublished.fresh = true;
+    trainingPublished.status = status;
+    trainingPublished.recordedInput.insert(trainingPublished.recordedInput.end(), trainingRecordedInput.begin(), trainingRecordedInput.end());
+    trainingRecordedInput.clear();
+    trainingPublished.hitEvents.insert(trainingPublished.hitEvents.end(), trainingHitEvents.begin(), trainingHitEvents.end());
+    trainingHitEvents.clear();
+    if (trainingPlotEntriesChanged) {
+        trainingPublished.plotEntries = std::move(plotEntries);
+        trainingPublished.plotEntriesChanged = true;
+        trainingPlotEntriesChanged = false;
+    }
+}
+
+// the main thread's end of publishTrainingFrame, everything the ui shows of
+// training mode comes from here
+static void takeTrainingFrame(void)
 {
-    
-     std::string num_str = std::to_string(number);
-    
-    if(num_str.length() >= length) return num_str;
-    
-     std::string leading_zeros(length - num_str.length(), '0');
-    
-    return leading_zeros + num_str;
+    std::vector<int> newRecordedInput;
+    std::vector<FrameEvent> hitEvents;
+    bool plotEntriesChanged = false;
+    std::vector<normalRangePlotEntry> plotEntries;
+    {
+        std::scoped_lock lock(trainingPublishMutex);
+        if (!trainingPublished.fresh) {
+            return;
+        }
+        std::swap(pTrainingTakenSim, pTrainingReadySim);
+        trainingPublished.fresh = false;
+        trainingStatus = trainingPublished.status;
+        newRecordedInput.swap(trainingPublished.recordedInput);
+        hitEvents.swap(trainingPublished.hitEvents);
+        if (trainingPublished.plotEntriesChanged) {
+            plotEntries.swap(trainingPublished.plotEntries);
+            plotEntriesChanged = true;
+            trainingPublished.plotEntriesChanged = false;
+        }
+    }
+
+    // cloning over the same view keeps its guys where they were, hit
+    // markers hang on to them
+    trainingViewSim.Clone(pTrainingTakenSim);
+    recordedInput.insert(recordedInput.end(), newRecordedInput.begin(), newRecordedInput.end());
+    if (plotEntriesChanged) {
+        vecPlotEntries = std::move(plotEntries);
+    }
+    trainingViewSim.getCurrentFrameEvents() = std::move(hitEvents);
+    trainingViewSim.gatherEveryone();
+    addHitMarkersFromFrameEvents(&trainingViewSim);
 }
 
-std::deque<std::string> logQueue;
+// the finder keeps going with its own start snapshot and routes, the sim
+// thread gets copies of the ones to play
+std::map<int16_t, ActionRef> finderRouteTriggers;
+bool finderRoutePlaying = false;
 
-extern "C" {
+static void playTrainingFinderRoute(void)
+{
+    finder.playing = true;
+    std::shared_ptr<Simulation> pStartSim = std::make_shared<Simulation>();
+    pStartSim->Clone(&finder.startSnapshot);
+    std::map<int16_t, ActionRef> triggers;
+    if (finder.doneRoutes.size()) {
+        triggers = (*finder.doneRoutes.rbegin())->timelineTriggers;
+    }
+    queueTrainingCommand([pStartSim, triggers]() {
+        defaultSim.Clone(pStartSim.get());
+        finderRouteTriggers = triggers;
+        finderRoutePlaying = true;
+        resetTrainingRollback();
+        paused = false;
+    });
+}
 
-void jsLog(char *logLine)
+// the sim's own copy of the timeline, the ui keeps playBackInputBuffer
+std::deque<int> trainingPlayBackBuffer;
+
+void toggleTrainingRecording(void)
 {
-    log("JS:" + std::string(logLine));
+    bool startRecording = !trainingStatus.recordingInput;
+    if (startRecording) {
+        // so we can easily look for dupes
+        timelineToInputBuffer(playBackInputBuffer);
+    }
+    queueTrainingCommand([startRecording]() {
+        recordingInput = startRecording;
+        if (startRecording) {
+            recordingStartFrame = defaultSim.frameCounter;
+            playingBackInput = false;
+        }
+    });
 }
 
+void toggleTrainingPlayback(void)
+{
+    bool startPlayback = !trainingStatus.playingBackInput;
+    if (startPlayback) {
+        timelineToInputBuffer(playBackInputBuffer);
+    } else {
+        currentInputMap[recordingID] = 0;
+    }
+    queueTrainingCommand([startPlayback, timeline = playBackInputBuffer]() {
+        playingBackInput = startPlayback;
+        if (startPlayback) {
+            trainingPlayBackBuffer = timeline;
+            playBackFrame = 0;
+        }
+        paused = false;
+    });
 }
 
-void log(std::string logLine)
+static void runTrainingFrame(void);
+
+static void trainingSimLoop(void)
 {
-    logQueue.push_back(logLine);
-    if (logQueue.size() > 15) {
-        logQueue.pop_front();
+    using clock = std::chrono::steady_clock;
+    const clock::duration tickDuration = std::chrono::microseconds(1000000 / 60);
+    const int statsTickCount = 60;
+
+    clock::time_point nextTick = clock::now();
+    clock::time_point lastTick = nextTick;
+    clock::time_point lastPublish = nextTick;
+    int tickCount = 0;
+    float intervalSumMS = 0.0f;
+    float worstErrorMS = 0.0f;
+    float latencySumMS = 0.0f;
+    float worstLatencyMS = 0.0f;
+    int latencyCount = 0;
+
+    while (!trainingSimStop) {
+        clock::time_point tickTime = clock::now();
+        std::vector<std::function<void()>> commands;
+        std::deque<QueuedInput> inputQueue;
+        {
+            std::scoped_lock lock(trainingQueueMutex);
+            commands.swap(trainingCommandQueue);
+            inputQueue.swap(trainingInputQueue);
+        }
+        for (auto &command : commands) {
+            command();
+        }
+
+        bool rateLimited = limitRate || !playingBackInput;
+        if (trainingSimActive) {
+            takeTrainingInputs(inputQueue, tickTime, latencySumMS, worstLatencyMS, latencyCount);
+            runTrainingFrame();
+            rateLimited = limitRate || !playingBackInput;
+
+            intervalSumMS += std::chrono::duration<float, std::milli>(tickTime - lastTick).count();
+            if (rateLimited) {
+                worstErrorMS = std::max(worstErrorMS, std::abs(std::chrono::duration<float, std::milli>(tickTime - nextTick).count()));
+            }
+            if (++tickCount == statsTickCount) {
+                trainingTickStats.tickIntervalMS = intervalSumMS / tickCount;
+                trainingTickStats.worstTickErrorMS = worstErrorMS;
+                trainingTickStats.inputLatencyMS = latencyCount ? latencySumMS / latencyCount : 0.0f;
+                trainingTickStats.worstInputLatencyMS = worstLatencyMS;
+                trainingTickStats.resimFramesPerSecond = rollbackStats.resimSeconds > 0.0f ? rollbackStats.resimFrames / rollbackStats.resimSeconds : 0.0f;
+                trainingTickStats.rollbackCount = rollbackStats.rollbackCount;
+                trainingTickStats.worstRollbackFrames = rollbackStats.worstRollbackFrames;
+                rollbackStats = {};
+                tickCount = 0;
+                intervalSumMS = worstErrorMS = latencySumMS = worstLatencyMS = 0.0f;
+                latencyCount = 0;
+            }
+        }
+        lastTick = tickTime;
+        // running flat out, the ui couldn't show more than a frame a tick
+        if ((trainingSimActive || !commands.empty()) && (rateLimited || tickTime - lastPublish >= tickDuration)) {
+            publishTrainingFrame();
+            lastPublish = tickTime;
+        }
+
+        clock::time_point now = clock::now();
+        nextTick += tickDuration;
+        if (!rateLimited || now - nextTick > tickDuration * 4) {
+            // running flat out, or too far behind to catch up
+            nextTick = now;
+        }
+        if (rateLimited) {
+            std::this_thread::sleep_until(nextTick);
+        }
     }
 }
 
-void extractCharVersion(char *cmdLine, std::string &charName, int &version)
+static void stopTrainingSimThread(void)
 {
-    uint32_t i = 0;
-    while (i < strlen(cmdLine)) {
-        if (cmdLine[i] >= '0' && cmdLine[i] <= '9') {
-            version = atoi(&cmdLine[i]);
-            cmdLine[i] = 0;
-            break;
+    if (trainingSimThread.joinable()) {
+        trainingSimStop = true;
+        trainingSimThread.join();
+    }
+}
+
+// one sim frame of training mode - everything in here has to come out the
+// same when rollback runs the frame again, the rest is skipped on resimulation
+static void simulateTrainingFrame(const std::vector<int> &guyInputs, bool hasInput, bool runFrame, bool resimulating)
+{
+    if (finderRoutePlaying && guys.size()) {
+        int targetFrame = defaultSim.frameCounter + 1;
+        auto frameTrigger = finderRouteTriggers.find(targetFrame);
+        if (frameTrigger != finderRouteTriggers.end()) {
+            if (frameTrigger->second.actionID() > 0) {
+                guys[0]->getForcedTrigger() = frameTrigger->second;
+                if (!resimulating) {
+                    log("forced trigger " + std::to_string(targetFrame));
+                }
+            } else {
+                int input = -frameTrigger->second.actionID();
+                if (guys[0]->getDirection() < 0) {
+                    input = invertDirection(input);
+                }
+                guys[0]->Input(input);
+                hasInput = false; // todo better system for this
+            }
+        }
+    }
+
+    if (runFrame) {
+        for (auto guy : defaultSim.vecGuysToDelete) {
+            delete guy;
         }
-        i++;
+        defaultSim.vecGuysToDelete.clear();
+    }
+
+    defaultSim.gatherEveryone();
+
+    if (runFrame) {
+        for (auto guy : defaultSim.everyone) {
+            if (guy->RunFrame()) {
+            }
+        }
+    }
+
+    // gather everyone again in case of deletions/additions in RunFrame
+    defaultSim.gatherEveryone();
+
+    if (!runFrame) {
+        defaultSim.frameCounter--;
+    }
+
+    if (runFrame) {
+        for (auto guy : defaultSim.everyone) {
+            guy->WorldPhysics();
+        }
+        for (auto guy : defaultSim.everyone) {
+            guy->Push(guy->getOpponent());
+        }
+
+        for (auto guy : defaultSim.everyone) {
+            guy->RunFramePostPush();
+        }
+
+        // gather everyone again in case of deletions/additions in RunFramePostPush
+        defaultSim.gatherEveryone();
+
+        FrameVector<PendingHit> pendingHitList;
+
+        for (auto guy : defaultSim.everyone) {
+            guy->CheckHit(guy->getOpponent(), pendingHitList);
+        }
+
+        ResolveHits(&defaultSim, pendingHitList);
+        if (!resimulating) {
+            // they turn into hit markers on the main thread
+            std::vector<FrameEvent> &frameEvents = defaultSim.getCurrentFrameEvents();
+            trainingHitEvents.insert(trainingHitEvents.end(), frameEvents.begin(), frameEvents.end());
+            frameEvents.clear();
+        }
+
+        // any hit spawns
+        defaultSim.gatherEveryone();
+
+        static bool hasAddedData = false;
+        // update plot range if we're doing that
+        if (!resimulating && guys.size() > 0 ) {
+            if (curPlotActionID == 0 && guys[0]->getIsDrive() == true)
+            {
+                curPlotEntryStartFrame = defaultSim.frameCounter;
+                curPlotActionID = guys[0]->getCurrentAction();
+                trainingPlotEntries.push_back({});
+                curPlotEntryID++;
+                trainingPlotEntriesChanged = true;
+            }
+            if (curPlotActionID != 0 && !guys[0]->canAct() && guys[0]->getIsDrive() == false)
+            {
+                if (curPlotEntryNormalStartFrame == 0) {
+                    curPlotEntryNormalStartFrame = defaultSim.frameCounter - curPlotEntryStartFrame;
+                }
+                FrameVector<HitBox> hitBoxes;
+                guys[0]->getHitBoxes(&hitBoxes);
+                Fixed maxXHitBox = Fixed(0);
+                for (auto hitbox : hitBoxes) {
+                    if (hitbox.type != hitBoxType::hit) continue;
+                    Fixed hitBoxX = hitbox.box.x + hitbox.box.w;
+                    if (hitBoxX > maxXHitBox) {
+                        maxXHitBox = hitBoxX;
+                    }
+                }
+                // find a better solution for two-hitting normals
+                // if (maxXHitBox != Fixed(0)) {
+                //     hasAddedData = true;
+                // }
+                if (maxXHitBox != Fixed(0) || hasAddedData) {
+                    trainingPlotEntries[curPlotEntryID].hitBoxRangePlotX.push_back(defaultSim.frameCounter - curPlotEntryStartFrame);
+                    trainingPlotEntries[curPlotEntryID].hitBoxRangePlotY.push_back(maxXHitBox.f());
+                    trainingPlotEntriesChanged = true;
+                }
+                if (trainingPlotEntries[curPlotEntryID].strName == "") {
+                    trainingPlotEntries[curPlotEntryID].strName = guys[0]->getCharacter() + " " + guys[0]->getActionName(guys[0]->getCurrentAction()) + " (" + std::to_string(curPlotEntryNormalStartFrame) + "f cancel)";
+                    trainingPlotEntries[curPlotEntryID].col = guys[0]->getColor();
+                    trainingPlotEntriesChanged = true;
+                }
+            }
+            if (curPlotActionID != 0 && guys[0]->canAct()) {
+                hasAddedData = false;
+                curPlotActionID = 0;
+                curPlotEntryStartFrame = 0;
+                curPlotEntryNormalStartFrame = 0;
+            }
+        }
+    }
+
+    if (hasInput) {
+        for (uint32_t i = 0; i < guys.size(); i++) {
+            guys[i]->Input(i < guyInputs.size() ? guyInputs[i] : 0);
+        }
+    }
+
+    // the sim's own AdvanceFrame also rewinds the frame arena, everything
+    // this frame put in there is done with by now
+    if (runFrame) {
+        defaultSim.AdvanceFrame();
+    } else {
+        defaultSim.frameArena.Reset();
     }
-    charName = cmdLine;
 }
 
-uint32_t frameStartTime;
-std::vector<Guy *> vecGuysToDelete;
-ImGuiIO *io;
-SDL_Window *sdlwindow;
-color clearColor = {0.0,0.0,0.0};
+static int rollbackPredict(int confirmedInput)
+{
+    return confirmedInput & ~(LP_pressed+MP_pressed+HP_pressed+LK_pressed+MK_pressed+HK_pressed);
+}
+
+// runs frame F of the ring, first putting right whatever earlier frames
+// guessed wrong about the remote inputs that came in since
+static void runRollbackFrame(std::vector<int> guyInputs, bool hasInput)
+{
+    using clock = std::chrono::steady_clock;
+    const int frame = defaultSim.frameCounter;
+    const int remoteGuy = rollbackSettings.remoteGuy;
+
+    if (rollbackFirstFrame != -1 && (rollbackNextFrame != frame || rollbackGuyCount != guys.size() ||
+                                     rollbackRingRemoteGuy != remoteGuy)) {
+        // something outside the ring changed the sim
+        resetTrainingRollback();
+    }
+    if (rollbackFirstFrame == -1) {
+        rollbackFirstFrame = frame;
+        rollbackGuyCount = guys.size();
+        rollbackRingRemoteGuy = remoteGuy;
+    }
+    while (frame - rollbackFirstFrame >= kRollbackFrames) {
+        RollbackFrame &oldest = rollbackRing[rollbackFirstFrame % kRollbackFrames];
+        if (oldest.confirmed) {
+            rollbackBaseRemoteInput = oldest.confirmedInput;
+        }
+        rollbackFirstFrame++;
+    }
+
+    // send ours off, nothing can arrive after it'd fall out of the ring
+    int maxDelay = kRollbackFrames - 2;
+    int delay = std::clamp(rollbackSettings.delayFrames, 0, maxDelay);
+    int jitter = std::clamp(rollbackSettings.jitterFrames, 0, maxDelay - delay);
+    int arriveFrame = frame + delay + (jitter ? rand() % (jitter + 1) : 0);
+    rollbackInFlight.push_back({frame, arriveFrame, guyInputs[remoteGuy]});
+
+    RollbackFrame &current = rollbackRing[frame % kRollbackFrames];
+    current.confirmed = false;
+
+    for (auto it = rollbackInFlight.begin(); it != rollbackInFlight.end();) {
+        if (it->arriveFrame > frame) {
+            it++;
+            continue;
+        }
+        if (it->frame >= rollbackFirstFrame) {
+            RollbackFrame &arrived = rollbackRing[it->frame % kRollbackFrames];
+            arrived.confirmed = true;
+            arrived.confirmedInput = it->input;
+        }
+        it = rollbackInFlight.erase(it);
+    }
+
+    // go over what every frame got against what we know now, the frames
+    // that haven't heard yet guess the last input we did hear holds
+    int firstWrongFrame = rollbackSettings.everyFrame && rollbackFirstFrame < frame ? rollbackFirstFrame : -1;
+    int lastKnown = rollbackBaseRemoteInput;
+    for (int f = rollbackFirstFrame; f <= frame; f++) {
+        RollbackFrame &ringFrame = rollbackRing[f % kRollbackFrames];
+        int remoteInput = ringFrame.confirmed ? ringFrame.confirmedInput : rollbackPredict(lastKnown);
+        if (ringFrame.confirmed) {
+            lastKnown = ringFrame.confirmedInput;
+        }
+        if (f < frame && remoteInput != ringFrame.guyInputs[remoteGuy] && firstWrongFrame == -1) {
+            firstWrongFrame = f;
+        }
+        if (f < frame) {
+            ringFrame.guyInputs[remoteGuy] = remoteInput;
+        } else {
+            guyInputs[remoteGuy] = remoteInput;
+        }
+    }
+
+    if (firstWrongFrame != -1) {
+        clock::time_point resimStart = clock::now();
+        defaultSim.Clone(&rollbackRing[firstWrongFrame % kRollbackFrames].state);
+        for (int f = firstWrongFrame; f < frame; f++) {
+            RollbackFrame &ringFrame = rollbackRing[f % kRollbackFrames];
+            if (f != firstWrongFrame) {
+                defaultSim.frameCounter++;
+                ringFrame.state.Clone(&defaultSim);
+            }
+            simulateTrainingFrame(ringFrame.guyInputs, ringFrame.hasInput, true, true);
+            recordTrainingHistory();
+        }
+        defaultSim.frameCounter++;
+
+        int resimFrames = frame - firstWrongFrame;
+        rollbackStats.resimFrames += resimFrames;
+        rollbackStats.resimSeconds += std::chrono::duration<float>(clock::now() - resimStart).count();
+        rollbackStats.rollbackCount++;
+        rollbackStats.worstRollbackFrames = std::max(rollbackStats.worstRollbackFrames, resimFrames);
+    }
+
+    current.state.Clone(&defaultSim);
+    current.guyInputs = guyInputs;
+    current.hasInput = hasInput;
+    simulateTrainingFrame(guyInputs, hasInput, true, false);
+    rollbackNextFrame = frame + 1;
+}
+
+// one tick of training mode, on the sim thread
+static void runTrainingFrame(void)
+{
+    if (rewindToFrame != -1) {
+        if (trainingHistoryFirstFrame != -1) {
+            int frame = std::clamp(rewindToFrame, trainingHistoryFirstFrame, trainingHistoryLastFrame);
+            defaultSim.Clone(&trainingHistory[frame % kHistoryFrames]);
+            resetTrainingRollback();
+            paused = true;
+        }
+        rewindToFrame = -1;
+    }
+
+    defaultSim.frameCounter++;
+
+    if (recordingInput) {
+        trainingRecordedInput.push_back(trainingInputMap[keyboardID]);
+    }
+
+    if (saveState) {
+        snapShotSim.Clone(&defaultSim);
+        saveState = false;
+    }
+
+    if (restoreState) {
+        defaultSim.Clone(&snapShotSim);
+        resetTrainingRollback();
+        restoreState = false;
+    }
+
+    if (runUntilFrame) {
+        if (runUntilFrame > defaultSim.frameCounter) {
+            limitRate = false;
+            paused = false;
+        } else {
+            runUntilFrame = 0;
+            paused = true;
+            limitRate = true;
+        }
+    }
+
+    bool hasInput = true;
+    bool runFrame = oneframe || !paused;
+
+    if (playingBackInput) {
+        if (runFrame) {
+            if (playBackFrame >= (int)trainingPlayBackBuffer.size()) {
+                playingBackInput = false;
+                playBackFrame = 0;
+            } else {
+                trainingInputMap[recordingID] = trainingPlayBackBuffer[playBackFrame++];
+                //log ("input from playback! " + std::to_string(currentInput));
+            }
+        } else {
+            hasInput = false;
+        }
+    }
+
+
+    std::vector<int> guyInputs;
+    for (auto guy : guys) {
+        int input = 0;
+        if (trainingInputMap.count(*guy->getInputIDPtr())) {
+            input = trainingInputMap[*guy->getInputIDPtr()];
+        }
+        guyInputs.push_back(input);
+    }
+
+    if (rollbackSettings.enabled && runFrame && rollbackSettings.remoteGuy < (int)guys.size()) {
+        runRollbackFrame(guyInputs, hasInput);
+    } else {
+        resetTrainingRollback();
+        simulateTrainingFrame(guyInputs, hasInput, runFrame, false);
+    }
+
+    if (resetpos) {
+        uint32_t i = 0;
+        while (i < guys.size()) {
+            guys[i]->resetPos();
+            i++;
+        }
+        resetTrainingRollback();
+    }
+
+    if (runFrame) {
+        recordTrainingHistory();
+    }
+
+    resetpos = false;
+    oneframe = false;
+}
 
 static void mainloop(void)
 {
     if (done) {
+        stopTrainingSimThread();
         finder.Stop();
 
         // save timeline buffer to disk
@@ -536,39 +1110,41 @@ static void mainloop(void)
 #endif
     }
 
-    doDeferredCreateGuys();
-
     const float desiredFrameTimeMS = 1000.0 / 60.0f;
     uint32_t currentTime = SDL_GetTicks();
-    if ((limitRate || !playingBackInput) && currentTime - frameStartTime < desiredFrameTimeMS) {
+    if ((trainingStatus.limitRate || !trainingStatus.playingBackInput) && currentTime - frameStartTime < desiredFrameTimeMS) {
         const float timeToSleepMS = (desiredFrameTimeMS - (currentTime - frameStartTime));
         usleep(timeToSleepMS * 1000 - 100);
     }
     frameStartTime = SDL_GetTicks();
 
-    defaultSim.frameCounter++;
+    trainingSimActive = gameMode == Training;
+    takeTrainingFrame();
+
+    doDeferredCreateGuys();
+    flushPendingLog();
+    simController.PollSimulation();
 
     int sizeX, sizeY;
     SDL_GetWindowSize(sdlwindow, &sizeX, &sizeY);
 
     updateInputs(sizeX, sizeY);
+    if (gameMode == Training) {
+        queueTrainingInputs();
+    }
 
     finder.Update();
 
     if (finder.newBestPending) {
         finder.newBestPending = false;
         if (gameMode == Training) {
-            defaultSim.Clone(&finder.startSnapshot);
-            finder.playing = true;
-            paused = false;
+            playTrainingFinderRoute();
         }
     }
     if (finder.stoppedPending) {
         finder.stoppedPending = false;
         if (gameMode == Training) {
-            paused = false;
-            finder.playing = true;
-            defaultSim.Clone(&finder.startSnapshot);
+            playTrainingFinderRoute();
         }
     }
 
@@ -581,7 +1157,7 @@ static void mainloop(void)
         Simulation startSim;
         Simulation *pStartSim = nullptr;
         if (gameMode == Training) {
-            pStartSim = &defaultSim;
+            pStartSim = &trainingViewSim;
             for (int i = 0; i < 2; i++) {
                 finderStartTimelineTriggers[i].clear();
                 finderStartInputRegions[i].clear();
@@ -596,8 +1172,8 @@ static void mainloop(void)
             snapshotFinderStartState(startFrame);
         }
 
-        if (gameMode == Training && !paused) {
-            paused = true;
+        if (gameMode == Training) {
+            queueTrainingCommand([]() { paused = true; });
         }
 
         finder.Start(pStartSim);
@@ -613,6 +1189,11 @@ static void mainloop(void)
             curFrame = simController.scrubberFrame;
 
             simInputsChanged = false;
+            simInputsDirtyFrame = -1;
+        } else if (!simInputsChanged && simInputsDirtyFrame != -1) {
+            simController.ResimulateFrom(simInputsDirtyFrame);
+            curFrame = simController.scrubberFrame;
+            simInputsDirtyFrame = -1;
         }
 
         if (!simInputsChanged) {
@@ -631,8 +1212,13 @@ static void mainloop(void)
                 }
                 if (simController.scrubberFrame >= simController.simFrameCount) {
                     simController.scrubberFrame = simController.simFrameCount - 1;
-                    simController.playing = false;
-                    simController.playUntilFrame = 0;
+                    // more frames are on the way, wait for them
+                    if (simController.simulationRunning()) {
+                        simController.scrubberFrame = std::max(simController.scrubberFrame, 0);
+                    } else {
+                        simController.playing = false;
+                        simController.playUntilFrame = 0;
+                    }
                 }
                 if (simController.scrubberFrame < 0) {
                     simController.scrubberFrame = 0;
@@ -669,191 +1255,15 @@ static void mainloop(void)
         }
         renderUI(io->Framerate, &logQueue, sizeX, sizeY);
     } else {
-        if (recordingInput) {
-            recordedInput.push_back(currentInputMap[keyboardID]);
-        }
-
-        if (saveState) {
-            snapShotSim.Clone(&defaultSim);
-            saveState = false;
-        }
-
-        if (restoreState) {
-            defaultSim.Clone(&snapShotSim);
-            restoreState = false;
-        }
-
-        if (runUntilFrame) {
-            if (runUntilFrame > defaultSim.frameCounter) {
-                limitRate = false;
-                paused = false;
-            } else {
-                runUntilFrame = 0;
-                paused = true;
-                limitRate = true;
-            }
-        }
-
-        bool hasInput = true;
-        bool runFrame = oneframe || !paused;
-
-        if (playingBackInput) {
-            if (runFrame) {
-                if (playBackFrame >= (int)playBackInputBuffer.size()) {
-                    playingBackInput = false;
-                    playBackFrame = 0;
-                } else {
-                    currentInputMap[recordingID] = playBackInputBuffer[playBackFrame++];
-                    //log ("input from playback! " + std::to_string(currentInput));
-                }
-            } else {
-                hasInput = false;
-            }
-        }
-
-        if (finder.playing && finder.doneRoutes.size() && guys.size()) {
-            const DoneRoute &playingRoute = **finder.doneRoutes.rbegin();
-            int targetFrame = defaultSim.frameCounter + 1;
-            auto frameTrigger = playingRoute.timelineTriggers.find(targetFrame);
-            if (frameTrigger != playingRoute.timelineTriggers.end()) {
-                if (frameTrigger->second.actionID() > 0) {
-                    guys[0]->getForcedTrigger() = frameTrigger->second;
-                    log("forced trigger " + std::to_string(targetFrame));
-                } else {
-                    int input = -frameTrigger->second.actionID();
-                    if (guys[0]->getDirection() < 0) {
-                        input = invertDirection(input);
-                    }
-                    guys[0]->Input(input);
-                    hasInput = false; // todo better system for this
-                }
-            }
-        }
-
-        if (runFrame) {
-            for (auto guy : vecGuysToDelete) {
-                delete guy;
-            }
-            vecGuysToDelete.clear();
-        }
-
-        defaultSim.gatherEveryone();
-
-        if (runFrame) {
-            for (auto guy : defaultSim.everyone) {
-                if (guy->RunFrame()) {
-                }
-            }
-        }
-
-        // gather everyone again in case of deletions/additions in RunFrame
-        defaultSim.gatherEveryone();
-
-        if (!runFrame) {
-            defaultSim.frameCounter--;
-        }
-
-        if (runFrame) {
-            for (auto guy : defaultSim.everyone) {
-                guy->WorldPhysics();
-            }
-            for (auto guy : defaultSim.everyone) {
-                guy->Push(guy->getOpponent());
-            }
-
-            for (auto guy : defaultSim.everyone) {
-                guy->RunFramePostPush();
-            }
-
-            // gather everyone again in case of deletions/additions in RunFramePostPush
-            defaultSim.gatherEveryone();
-
-            std::vector<PendingHit> pendingHitList;
-
-            for (auto guy : defaultSim.everyone) {
-                guy->CheckHit(guy->getOpponent(), pendingHitList);
-            }
-
-            ResolveHits(&defaultSim, pendingHitList);
-
-            // any hit spawns
-            defaultSim.gatherEveryone();
-
-            static bool hasAddedData = false;
-            // update plot range if we're doing that
-            if (guys.size() > 0 ) {
-                if (curPlotActionID == 0 && guys[0]->getIsDrive() == true)
-                {
-                    curPlotEntryStartFrame = defaultSim.frameCounter;
-                    curPlotActionID = guys[0]->getCurrentAction();
-                    vecPlotEntries.push_back({});
-                    curPlotEntryID++;
-                }
-                if (curPlotActionID != 0 && !guys[0]->canAct() && guys[0]->getIsDrive() == false)
-                {
-                    if (curPlotEntryNormalStartFrame == 0) {
-                        curPlotEntryNormalStartFrame = defaultSim.frameCounter - curPlotEntryStartFrame;
-                    }
-                    std::vector<HitBox> hitBoxes;
-                    guys[0]->getHitBoxes(&hitBoxes);
-                    Fixed maxXHitBox = Fixed(0);
-                    for (auto hitbox : hitBoxes) {
-                        if (hitbox.type != hitBoxType::hit) continue;
-                        Fixed hitBoxX = hitbox.box.x + hitbox.box.w;
-                        if (hitBoxX > maxXHitBox) {
-                            maxXHitBox = hitBoxX;
-                        }
-                    }
-                    // find a better solution for two-hitting normals
-                    // if (maxXHitBox != Fixed(0)) {
-                    //     hasAddedData = true;
-                    // }
-                    if (maxXHitBox != Fixed(0) || hasAddedData) {
-                        vecPlotEntries[curPlotEntryID].hitBoxRangePlotX.push_back(defaultSim.frameCounter - curPlotEntryStartFrame);
-                        vecPlotEntries[curPlotEntryID].hitBoxRangePlotY.push_back(maxXHitBox.f());
-                    }
-                    if (vecPlotEntries[curPlotEntryID].strName == "") {
-                        vecPlotEntries[curPlotEntryID].strName = guys[0]->getCharacter() + " " + guys[0]->getActionName(guys[0]->getCurrentAction()) + " (" + std::to_string(curPlotEntryNormalStartFrame) + "f cancel)";
-                        vecPlotEntries[curPlotEntryID].col = guys[0]->getColor();
-                    }
-                }
-                if (curPlotActionID != 0 && guys[0]->canAct()) {
-                    hasAddedData = false;
-                    curPlotActionID = 0;
-                    curPlotEntryStartFrame = 0;
-                    curPlotEntryNormalStartFrame = 0;
-                }
-            }
-        }
-
-        for (auto guy : guys) {
-            if ( hasInput ) {
-                int input = 0;
-                if (currentInputMap.count(*guy->getInputIDPtr())) {
-                    input = currentInputMap[*guy->getInputIDPtr()];
-                }
-                guy->Input( input );
-            }
-        }
-
-        if (runFrame) {
-            for (auto guy : defaultSim.everyone) {
-                bool die = !guy->AdvanceFrame();
-
-                if (die) {
-                    vecGuysToDelete.push_back(guy);
-                }
-            }
-        }
-
+        std::vector<Guy *> &viewGuys = trainingViewSim.simGuys;
         // find camera position if we have 2 guys
-        if (lockCamera && guys.size() >= 2) {
-            translateX = (guys[1]->getLastPosX(true).f() + guys[0]->getLastPosX(true).f()) / 2.0f;
+        if (lockCamera && viewGuys.size() >= 2) {
+            translateX = (viewGuys[1]->getLastPosX(true).f() + viewGuys[0]->getLastPosX(true).f()) / 2.0f;
             translateX = fmin(translateX, 550.0);
             translateX = fmax(translateX, -550.0);
 
             // first find required camera distance to have both guys in view horizontally
-            float distGuys = fabs( guys[1]->getLastPosX(true).f() - guys[0]->getLastPosX(true).f() );
+            float distGuys = fabs( viewGuys[1]->getLastPosX(true).f() - viewGuys[0]->getLastPosX(true).f() );
             distGuys += 200.0; // account for some buffer behind
             float angleRad = fov / 2.0 * std::numbers::pi / 180.0;
             // zoom is adjacent edge, equals opposite over tan(ang)
@@ -869,40 +1279,11 @@ static void mainloop(void)
         
         //log("zoom " + std::to_string(zoom) + " translateX " + std::to_string(translateX) + " translateY " + std::to_string(translateY));
 
-        // gather everyone again in case of deletions/additions in renderUI
-        defaultSim.everyone.clear(); 
-        for (auto guy : guys) {
-            defaultSim.everyone.push_back(guy);
-            for ( auto minion : guy->getMinions() ) {
-                defaultSim.everyone.push_back(minion);
-            }
-        }
-
-        // gather everyone again in case of deletions/additions in renderUI
-        defaultSim.everyone.clear();
-        for (auto guy : guys) {
-            defaultSim.everyone.push_back(guy);
-            for ( auto minion : guy->getMinions() ) {
-                defaultSim.everyone.push_back(minion);
-            }
-        }
-
         setRenderState(clearColor, sizeX, sizeY);
         renderUI(io->Framerate, &logQueue, sizeX, sizeY);
 
         finder.Render();
-        defaultSim.Render();
-
-        if (resetpos) {
-            uint32_t i = 0;
-            while (i < guys.size()) {
-                guys[i]->resetPos();
-                i++;
-            }
-        }
-
-        resetpos = false;
-        oneframe = false;
+        trainingViewSim.Render();
     }
 
     renderMarkersAndStuff();
@@ -922,71 +1303,12 @@ int main(int argc, char**argv)
     std::string strDumpLoadPath;
     int dumpVersion = -1;
 
-    if ( argc > 2 && std::string(argv[1]) == "run_dump") {
-        gameMode = Batch;
-        int version = -1;
-        if ( argc > 3 ) {
-            version = atoi(argv[3]);
-        }
-        strDumpLoadPath = argv[2];
-
-        simController.recordFrames = false;
-        simController.LoadFromGameDump(strDumpLoadPath, version);
-
-        exit(0);
+    int batchExitCode = 0;
+    if (runBatchCommand(argc, argv, batchExitCode)) {
+        exit(batchExitCode);
     }
 
-    if ( argc > 2 && std::string(argv[1]) == "run_replay") {
-        gameMode = Batch;
-        int version = -1;
-        if ( argc > 3 ) {
-            version = atoi(argv[3]);
-        }
-
-        nlohmann::json replayJson = parse_json_file(argv[2]);
-        if (replayJson == nullptr) {
-            fprintf(stderr, "failed to load replay %s\n", argv[2]);
-            exit(1);
-        }
-        if (!simController.LoadFromReplay(replayJson, version)) {
-            fprintf(stderr, "replay missing InputData or ReplayInfo\n");
-            exit(1);
-        }
-        simController.recordFrames = false;
-        simController.SimulateAllReplayRounds();
-
-        exit(0);
-    }
-
-    if (argc > 1 && std::string(argv[1]) == "printversions") {
-        for (int i = 0; i < charVersionCount; i++) {
-            printf("%d\n", atoi(charVersions[i]));
-        }
-        exit(0);
-    }
-
-    if (argc > 3 && std::string(argv[1]) == "cook") {
-        char* charSpec = argv[2];
-        std::string outFile = argv[3];
-
-        std::string charName;
-        int version = atoi(charVersions[charVersionCount - 1]);
-        extractCharVersion(charSpec, charName, version);
-
-        CharacterData* pData = loadCharacter(charName, version);
-        if (!pData) {
-            fprintf(stderr, "failed to load %s v%d\n", charName.c_str(), version);
-            exit(1);
-        }
-
-        if (!cookCharacter(pData, outFile)) {
-            fprintf(stderr, "failed to cook %s v%d\n", charName.c_str(), version);
-            exit(1);
-        }
-
-        delete pData;
-        exit(0);
-    }
+    setLogHandler(queueLogLine);
 
     if ( argc > 2 && std::string(argv[1]) == "load_dump") {
         strDumpLoadPath = argv[2];
@@ -1056,10 +1378,15 @@ int main(int argc, char**argv)
             dumpVersion = maxVersion;
         }
 
-        simController.charCount = 2;
-        gameMode = Viewer;
-        simController.LoadFromGameDump(strDumpLoadPath, dumpVersion);
-        simInputsChanged = false;
+        nlohmann::json dumpJson;
+        if (!isBinaryGameDump(strDumpLoadPath)) {
+            dumpJson = parse_json_file(strDumpLoadPath);
+            if (dumpJson == nullptr) {
+                fprintf(stderr, "failed to load dump %s\n", strDumpLoadPath.c_str());
+                exit(1);
+            }
+        }
+        startViewerLoad(strDumpLoadPath, dumpJson, false, dumpVersion);
     }
 
     if (loadingReplay) {
@@ -1074,11 +1401,7 @@ int main(int argc, char**argv)
             exit(1);
         }
 
-        simController.charCount = 2;
-        gameMode = Viewer;
-        simController.SimulateAllReplayRounds();
-        simController.LoadReplayRound(0);
-        simInputsChanged = false;
+        startViewerLoad(strReplayLoadPath, replayJson, true, useVersion);
     }
 
     frameStartTime = SDL_GetTicks();
@@ -1087,6 +1410,8 @@ int main(int argc, char**argv)
     currentInputMap[keyboardID] = 0;
     currentInputMap[recordingID] = 0;
 
+    trainingSimThread = std::thread(trainingSimLoop);
+
 #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(mainloop, 0, 1);
 #else
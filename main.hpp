@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <string>
 #include <deque>
+#include <functional>
 #include "json.hpp"
 #include "fixed.hpp"
 
@@ -25,6 +27,24 @@ enum hitentryflags {
     punish_counter = special|counter,
 };
 
+// view into one of a character's packed key arenas - first/count is what gets
+// stored and cooked, pData is resolved once the arena is done growing
+template<typename T>
+struct KeySpan {
+    T *pData = nullptr;
+    uint32_t first = 0;
+    uint32_t count = 0;
+
+    inline T *begin() const { return pData; }
+    inline T *end() const { return pData + count; }
+    inline std::size_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+    inline T& operator[](std::size_t index) const {
+        assert(index < count);
+        return pData[index];
+    }
+};
+
 struct Box {
     Fixed x;
     Fixed y;
@@ -90,7 +110,7 @@ struct UniqueBox {
     int checkMask;
     bool uniquePitcher;
     bool holderIsTarget;
-    std::vector<struct UniqueBoxOp> *pOps;
+    KeySpan<struct UniqueBoxOp> *pOps;
 };
 
 struct HurtBox {
@@ -123,6 +143,15 @@ struct color {
     float b;
 };
 
+struct RenderBox {
+    Box box;
+    float thickness = 10.0;
+    color col;
+    bool drive = false;
+    bool parry = false;
+    bool di = false;
+};
+
 static inline float randFloat()
 {
     float ret = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
@@ -130,6 +159,8 @@ static inline float randFloat()
 }
 
 void log(std::string logLine);
+// where log lines end up, nothing is kept until one is set
+void setLogHandler(void (*pHandler)(std::string logLine));
 
 class Guy;
 
@@ -147,6 +178,7 @@ extern const int charVersionCount;
 int simVersionFromGameVersion(int gameVersion, int64_t time);
 
 bool isCharLoaded(const std::string& charName, int charVersion);
+bool isCharLoadFailed(const std::string& charName, int charVersion);
 void requestCharDownload(const std::string& charName, int charVersion);
 
 extern float startPos1;
@@ -156,19 +188,22 @@ class Simulation;
 extern Simulation defaultSim;
 extern std::vector<Guy *> &guys;
 
+// the training sim thread's, only change them from a training command
 extern bool resetpos;
-
-extern bool done;
 extern bool paused;
 extern bool oneframe;
 extern int runUntilFrame;
+extern bool saveState;
+extern bool restoreState;
+extern bool limitRate;
+// picked up on the next training tick, which pauses there
+extern int rewindToFrame;
+
+extern bool done;
 extern bool lockCamera;
 extern bool toggleRenderUI;
 extern bool toggleDebugUI;
 
-extern bool saveState;
-extern bool restoreState;
-
 extern bool comboFinderDoLights;
 extern bool comboFinderDoLateCancels;
 extern bool comboFinderDoWalk;
@@ -176,13 +211,10 @@ extern bool comboFinderDoKaras;
 extern bool showComboFinder;
 extern bool runComboFinder;
 
-extern bool recordingInput;
 extern std::vector<int> recordedInput;
 extern int recordingStartFrame;
 
-extern bool playingBackInput;
 extern std::deque<int> playBackInputBuffer;
-extern int playBackFrame;
 
 extern std::vector<float> hitBoxRangePlotX;
 extern std::vector<float> hitBoxRangePlotY;
@@ -198,14 +230,76 @@ extern std::vector<normalRangePlotEntry> vecPlotEntries;
 
 extern bool deleteInputs;
 
-extern bool limitRate;
+// how the training sim thread kept up over its last second of ticks
+struct TrainingTickStats {
+    float tickIntervalMS = 0.0f;
+    float worstTickErrorMS = 0.0f;
+    float inputLatencyMS = 0.0f;
+    float worstInputLatencyMS = 0.0f;
+    // rollback mode only
+    float resimFramesPerSecond = 0.0f;
+    int rollbackCount = 0;
+    int worstRollbackFrames = 0;
+};
+
+struct RollbackSettings {
+    bool enabled = false;
+    int delayFrames = 3;
+    int jitterFrames = 2;
+    int remoteGuy = 1;
+    bool everyFrame = false;
 
-extern bool forceCounter;
-extern bool forcePunishCounter;
+    bool operator==(const RollbackSettings &other) const = default;
+};
+// the sim thread's, the ui changes it with a training command
+extern RollbackSettings rollbackSettings;
+
+// the training sim thread owns defaultSim and all the state around it. the
+// ui only looks at what it published after its last tick, and every change
+// the ui makes is a command the sim thread runs before its next one
+struct TrainingStatus {
+    bool paused = false;
+    bool limitRate = true;
+    bool recordingInput = false;
+    bool playingBackInput = false;
+    int playBackFrame = 0;
+    int runUntilFrame = 0;
+    // frames training mode can rewind to, -1 when there's none yet
+    int historyFirstFrame = -1;
+    int historyLastFrame = -1;
+    RollbackSettings rollback;
+    TrainingTickStats tickStats;
+};
+extern TrainingStatus trainingStatus;
+// the sim as of that tick, a copy only the main thread touches
+extern Simulation trainingViewSim;
+
+void queueTrainingCommand(std::function<void()> command);
+// R and T, the timeline gets handed to the sim thread
+void toggleTrainingRecording(void);
+void toggleTrainingPlayback(void);
+// queues edit on the live guy behind a guy of trainingViewSim, a guy from
+// any other sim gets edited right away
+void editTrainingGuy(Guy *pGuy, std::function<void(Guy *)> edit);
+
+// set from the ui, read by the training sim thread and the viewer workers
+extern std::atomic<bool> forceCounter;
+extern std::atomic<bool> forcePunishCounter;
+
+// log flags the viewer puts on its sims, projectiles spawn with them too
+extern bool viewerLogTransitions;
+extern bool viewerLogTriggers;
+extern bool viewerLogUnknowns;
+extern bool viewerLogHits;
+extern bool viewerLogBranches;
+extern bool viewerLogResources;
 
 std::string to_string_leading_zeroes(unsigned int number, unsigned int length);
 std::string readFile(const std::string &fileName);
+void writeFile(const std::string &fileName, std::string contents);
 nlohmann::json parse_json_file(const std::string &fileName);
+void makeCharEntries(void);
+void extractCharVersion(char *cmdLine, std::string &charName, int &version);
 void createGuy(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color);
 
 #define STRINGIZE(x) #x
@@ -267,6 +361,10 @@ public:
         return count;
     }
 
+    static constexpr std::size_t capacity() {
+        return N;
+    }
+
     inline bool operator!=(const FixedBuffer& other) const {
         if (count != other.count) return true;
         return std::memcmp(buffer, other.buffer, count * sizeof(T)) != 0;
@@ -0,0 +1,211 @@
+#!/usr/bin/python
+
+# ctypes bindings over the psychodrive_capi library (see psychodrive.h), so
+# sweeps can run sims in process instead of spawning psychodrive per run
+#
+#   sim = psychodrive.Sim()
+#   sim.addGuy("ryu", 42, -150.0, 1)
+#   sim.addGuy("ken", 42, 150.0, -1)
+#   inputs = numpy.zeros((600, 2), dtype=numpy.int32)
+#   inputs[10:, 0] = psychodrive.FORWARD
+#   states = sim.run(inputs)
+#   states["pos_x"][:, 0] / psychodrive.FIXED_ONE
+#
+# set PSYCHODRIVE_CAPI to the library path if it isn't next to the repo root
+# or in a build directory under it. character data is loaded relative to the
+# working directory like the executables do
+
+import ctypes
+import os
+
+import numpy as np
+
+PD_API_VERSION = 2
+
+FIXED_ONE = 65536
+
+# input.hpp
+NEUTRAL = 0
+UP = 1
+DOWN = 2
+BACK = 4
+FORWARD = 8
+LP = 16
+MP = 32
+HP = 64
+LK = 128
+MK = 256
+HK = 512
+
+scriptPath = os.path.abspath(__file__)
+scriptDir = os.path.dirname(scriptPath)
+baseDir = os.path.join(scriptDir, "..", "..")
+
+guyStateFields = [
+    ("unique_id", ctypes.c_int32),
+    ("char_id", ctypes.c_int32),
+    ("action_id", ctypes.c_int32),
+    ("action_frame", ctypes.c_int32),
+    ("direction", ctypes.c_int32),
+    ("health", ctypes.c_int32),
+    ("drive_gauge", ctypes.c_int32),
+    ("super_gauge", ctypes.c_int32),
+    ("combo_hits", ctypes.c_int32),
+    ("combo_damage", ctypes.c_int32),
+    ("hit_stop", ctypes.c_int32),
+    ("hit_stun", ctypes.c_int32),
+    ("current_input", ctypes.c_int32),
+    ("can_act", ctypes.c_int32),
+    ("airborne", ctypes.c_int32),
+    ("minion_count", ctypes.c_int32),
+    ("pos_x", ctypes.c_int64),
+    ("pos_y", ctypes.c_int64),
+    ("vel_x", ctypes.c_int64),
+    ("vel_y", ctypes.c_int64),
+    ("accel_x", ctypes.c_int64),
+    ("accel_y", ctypes.c_int64),
+    ("hit_vel_x", ctypes.c_int64),
+    ("hit_accel_x", ctypes.c_int64),
+]
+
+class GuyState(ctypes.Structure):
+    _fields_ = guyStateFields
+
+# same layout as pd_guy_state, run() hands the native side this buffer directly
+guyStateDtype = np.dtype([(name, np.int32 if ctype == ctypes.c_int32 else np.int64) for name, ctype in guyStateFields], align=True)
+assert guyStateDtype.itemsize == ctypes.sizeof(GuyState)
+
+def findLibrary():
+    if "PSYCHODRIVE_CAPI" in os.environ:
+        return os.environ["PSYCHODRIVE_CAPI"]
+    if os.name == 'nt':
+        libNames = ["psychodrive_capi.dll", "libpsychodrive_capi.dll"]
+    else:
+        libNames = ["libpsychodrive_capi.so", "libpsychodrive_capi.dylib"]
+    searchDirs = [baseDir]
+    for entry in sorted(os.listdir(baseDir)):
+        if os.path.isdir(os.path.join(baseDir, entry)):
+            searchDirs.append(os.path.join(baseDir, entry))
+    for searchDir in searchDirs:
+        for libName in libNames:
+            libPath = os.path.join(searchDir, libName)
+            if os.path.isfile(libPath):
+                return libPath
+    raise OSError("couldn't find psychodrive_capi, set PSYCHODRIVE_CAPI")
+
+lib = None
+
+def loadLibrary():
+    global lib
+    if lib:
+        return lib
+    lib = ctypes.CDLL(findLibrary())
+
+    simPtr = ctypes.c_void_p
+    intPtr = ctypes.POINTER(ctypes.c_int32)
+    statePtr = ctypes.POINTER(GuyState)
+
+    lib.pd_api_version.restype = ctypes.c_int
+    lib.pd_api_version.argtypes = []
+    lib.pd_sim_create.restype = simPtr
+    lib.pd_sim_create.argtypes = []
+    lib.pd_sim_clone.restype = simPtr
+    lib.pd_sim_clone.argtypes = [simPtr]
+    lib.pd_sim_free.restype = None
+    lib.pd_sim_free.argtypes = [simPtr]
+    lib.pd_sim_add_guy.restype = ctypes.c_int
+    lib.pd_sim_add_guy.argtypes = [simPtr, ctypes.c_char_p, ctypes.c_int, ctypes.c_double, ctypes.c_int]
+    lib.pd_sim_guy_count.restype = ctypes.c_int
+    lib.pd_sim_guy_count.argtypes = [simPtr]
+    lib.pd_sim_step.restype = ctypes.c_int
+    lib.pd_sim_step.argtypes = [simPtr, intPtr, ctypes.c_int]
+    lib.pd_sim_step_frames.restype = ctypes.c_int
+    lib.pd_sim_step_frames.argtypes = [simPtr, intPtr, ctypes.c_int, ctypes.c_int]
+    lib.pd_sim_step_frames_states.restype = ctypes.c_int
+    lib.pd_sim_step_frames_states.argtypes = [simPtr, intPtr, ctypes.c_int, ctypes.c_int, statePtr]
+    lib.pd_sim_get_frame.restype = ctypes.c_int
+    lib.pd_sim_get_frame.argtypes = [simPtr]
+    lib.pd_sim_get_guy_state.restype = ctypes.c_int
+    lib.pd_sim_get_guy_state.argtypes = [simPtr, ctypes.c_int, statePtr]
+
+    version = lib.pd_api_version()
+    if version != PD_API_VERSION:
+        raise OSError(f"psychodrive_capi is api version {version}, bindings are {PD_API_VERSION}")
+    return lib
+
+class Sim:
+    def __init__(self, handle=None):
+        loadLibrary()
+        self.handle = handle if handle else lib.pd_sim_create()
+        if not self.handle:
+            raise RuntimeError("pd_sim_create failed")
+
+    def close(self):
+        if self.handle:
+            lib.pd_sim_free(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def clone(self):
+        handle = lib.pd_sim_clone(self.handle)
+        if not handle:
+            raise RuntimeError("pd_sim_clone failed")
+        return Sim(handle)
+
+    def addGuy(self, charName, version, posX, direction):
+        index = lib.pd_sim_add_guy(self.handle, charName.encode(), version, posX, direction)
+        if index < 0:
+            raise ValueError(f"couldn't add {charName} v{version}")
+        return index
+
+    def guyCount(self):
+        return lib.pd_sim_guy_count(self.handle)
+
+    def frame(self):
+        return lib.pd_sim_get_frame(self.handle)
+
+    def step(self, inputs=None):
+        guyCount = self.guyCount()
+        frameInputs = np.zeros(guyCount, dtype=np.int32) if inputs is None else np.ascontiguousarray(inputs, dtype=np.int32)
+        ret = lib.pd_sim_step(self.handle, frameInputs.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)), frameInputs.size)
+        if ret < 0:
+            raise ValueError(f"step needs {guyCount} inputs")
+        return ret
+
+    # inputs is (frames, guys), or just a frame count to run with no input.
+    # returns a (frames, guys) array of guyStateDtype with the state after
+    # every frame, or None when states is False
+    def run(self, inputs, states=True):
+        guyCount = self.guyCount()
+        if isinstance(inputs, int):
+            inputs = np.zeros((inputs, guyCount), dtype=np.int32)
+        inputs = np.ascontiguousarray(inputs, dtype=np.int32)
+        if inputs.ndim != 2 or inputs.shape[1] != guyCount:
+            raise ValueError(f"inputs need to be (frames, {guyCount})")
+        frameCount = inputs.shape[0]
+        inputPtr = inputs.ctypes.data_as(ctypes.POINTER(ctypes.c_int32))
+
+        if not states:
+            ret = lib.pd_sim_step_frames(self.handle, inputPtr, inputs.size, frameCount)
+            out = None
+        else:
+            out = np.zeros((frameCount, guyCount), dtype=guyStateDtype)
+            ret = lib.pd_sim_step_frames_states(self.handle, inputPtr, inputs.size, frameCount,
+                                                out.ctypes.data_as(ctypes.POINTER(GuyState)))
+        if ret < 0:
+            raise RuntimeError("pd_sim_step_frames failed")
+        return out
+
+    def guyState(self, index):
+        out = np.zeros(1, dtype=guyStateDtype)
+        if lib.pd_sim_get_guy_state(self.handle, index, out.ctypes.data_as(ctypes.POINTER(GuyState))) < 0:
+            raise IndexError(f"no guy {index}")
+        return out[0]
@@ -0,0 +1,61 @@
+#!/usr/bin/python
+
+import os
+import subprocess
+import sys
+import concurrent.futures
+import multiprocessing
+
+scriptPath = os.path.abspath(__file__)
+scriptDir = os.path.dirname(scriptPath)
+baseDir = os.path.join(scriptDir, "..", "..")
+dumpDir = os.path.join(baseDir, "tests", "dumps")
+
+def discoverDumps():
+    dumps = []
+    for root, dirs, files in os.walk(dumpDir):
+        for file in files:
+            if file.endswith(".json"):
+                dumps.append(os.path.join(root, file))
+    return sorted(dumps)
+
+def convertOne(psychodrivePath, dumpPath):
+    outFile = dumpPath[:-len(".json")] + ".pdump"
+    if os.path.isfile(outFile) and os.path.getmtime(outFile) >= os.path.getmtime(dumpPath):
+        return outFile
+    result = subprocess.run(
+        [psychodrivePath, "convert_dump", dumpPath, outFile],
+        stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
+    )
+    if result.returncode != 0:
+        return None
+    return outFile
+
+def main():
+    if len(sys.argv) >= 2:
+        psychodrivePath = sys.argv[1]
+    else:
+        psychodriveBin = "psychodrive"
+        if os.name == 'nt':
+            psychodriveBin += ".exe"
+        psychodrivePath = os.path.join(baseDir, psychodriveBin)
+
+    dumps = discoverDumps()
+
+    numThreads = multiprocessing.cpu_count()
+    print(f"converting {len(dumps)} dumps on {numThreads} threads...")
+
+    converted = 0
+    with concurrent.futures.ThreadPoolExecutor(max_workers=numThreads) as executor:
+        futures = {executor.submit(convertOne, psychodrivePath, d): d for d in dumps}
+        for future in concurrent.futures.as_completed(futures):
+            if future.result():
+                converted += 1
+                print(".", end="", flush=True)
+            else:
+                print("x", end="", flush=True)
+
+    print(f"\nconverted {converted} dumps")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "profile.hpp"
+
+static const char *phaseNames[eProfilePhaseCount] = {
+    "RunFrame",
+    "WorldPhysics",
+    "Push",
+    "RunFramePostPush",
+    "CheckHit",
+    "ResolveHits",
+    "AdvanceFrame",
+};
+
+void SimProfile::Add(const SimProfile &other)
+{
+    for (int i = 0; i < eProfilePhaseCount; i++) {
+        phases[i].calls += other.phases[i].calls;
+        phases[i].nanoseconds += other.phases[i].nanoseconds;
+        phases[i].allocations += other.phases[i].allocations;
+        phases[i].allocatedBytes += other.phases[i].allocatedBytes;
+    }
+    frames += other.frames;
+}
+
+std::string SimProfile::Summary() const
+{
+    std::string ret;
+    char line[256];
+    uint64_t perFrame = frames ? frames : 1;
+
+    snprintf(line, sizeof(line), "%llu frames\n", (unsigned long long)frames);
+    ret += line;
+    snprintf(line, sizeof(line), "%-18s %10s %10s %10s %12s %10s\n", "phase", "total ms", "ns/frame", "allocs", "allocs/frame", "KB");
+    ret += line;
+
+    ProfilePhaseStats total;
+    for (int i = 0; i < eProfilePhaseCount; i++) {
+        const ProfilePhaseStats &stats = phases[i];
+        snprintf(line, sizeof(line), "%-18s %10.2f %10llu %10llu %12.2f %10.1f\n", phaseNames[i],
+                 stats.nanoseconds / 1000000.0, (unsigned long long)(stats.nanoseconds / perFrame),
+                 (unsigned long long)stats.allocations, stats.allocations / (double)perFrame,
+                 stats.allocatedBytes / 1024.0);
+        ret += line;
+        total.nanoseconds += stats.nanoseconds;
+        total.allocations += stats.allocations;
+        total.allocatedBytes += stats.allocatedBytes;
+    }
+    snprintf(line, sizeof(line), "%-18s %10.2f %10llu %10llu %12.2f %10.1f\n", "total",
+             total.nanoseconds / 1000000.0, (unsigned long long)(total.nanoseconds / perFrame),
+             (unsigned long long)total.allocations, total.allocations / (double)perFrame,
+             total.allocatedBytes / 1024.0);
+    ret += line;
+    return ret;
+}
+
+#ifdef PSYCHODRIVE_PROFILE
+thread_local uint64_t profileAllocations = 0;
+thread_local uint64_t profileAllocatedBytes = 0;
+
+// everything still ends up in malloc, so jemalloc in the executables - this
+// just counts on the way through, per thread so parallel sims don't mix
+void *operator new(size_t size)
+{
+    profileAllocations++;
+    profileAllocatedBytes += size;
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// time and allocations per phase of Simulation::RunFrame/AdvanceFrame. only
+// builds with PSYCHODRIVE_PROFILE (meson -Dprofile=true) fill it in, otherwise
+// PROFILE_PHASE is nothing and the counters stay at zero
+
+enum ProfilePhase {
+    eProfileRunFrame = 0,
+    eProfileWorldPhysics,
+    eProfilePush,
+    eProfileRunFramePostPush,
+    eProfileCheckHit,
+    eProfileResolveHits,
+    eProfileAdvanceFrame,
+    eProfilePhaseCount
+};
+
+struct ProfilePhaseStats {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+struct SimProfile {
+    ProfilePhaseStats phases[eProfilePhaseCount];
+    uint64_t frames = 0;
+
+    void Add(const SimProfile &other);
+    std::string Summary() const;
+};
+
+#ifdef PSYCHODRIVE_PROFILE
+const bool profileEnabled = true;
+
+// bumped by the operator new in profile.cpp
+extern thread_local uint64_t profileAllocations;
+extern thread_local uint64_t profileAllocatedBytes;
+
+class ProfileScope {
+public:
+    ProfileScope(SimProfile &profile, ProfilePhase phase) : stats(profile.phases[phase]) {
+        startAllocations = profileAllocations;
+        startAllocatedBytes = profileAllocatedBytes;
+        startTime = std::chrono::steady_clock::now();
+    }
+    ~ProfileScope() {
+        auto elapsed = std::chrono::steady_clock::now() - startTime;
+        stats.calls++;
+        stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        stats.allocations += profileAllocations - startAllocations;
+        stats.allocatedBytes += profileAllocatedBytes - startAllocatedBytes;
+    }
+private:
+    ProfilePhaseStats &stats;
+    uint64_t startAllocations;
+    uint64_t startAllocatedBytes;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+#define PROFILE_PHASE(profile, phase) ProfileScope profileScope(profile, phase)
+#else
+const bool profileEnabled = false;
+
+#define PROFILE_PHASE(profile, phase)
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+/* C interface to psychodrive_core for embedding the simulation in other
+ * languages. Handles are opaque, nothing here throws, functions that can fail
+ * return a negative value or a null handle. Not thread safe per handle, but
+ * different sims can be stepped from different threads. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32) && defined(PD_BUILDING_LIBRARY)
+#define PD_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define PD_API __declspec(dllimport)
+#else
+#define PD_API __attribute__((visibility("default")))
+#endif
+
+/* bumped whenever a function or struct below changes */
+#define PD_API_VERSION 2
+
+typedef struct pd_sim pd_sim;
+
+/* fixed point fields are the raw 16.16 values the game uses, divide by 65536
+ * for units. velocities and accelerations are in screen space like the dumps */
+typedef struct pd_guy_state {
+    int32_t unique_id;
+    int32_t char_id;
+    int32_t action_id;
+    int32_t action_frame;
+    int32_t direction;
+    int32_t health;
+    int32_t drive_gauge;
+    int32_t super_gauge;
+    int32_t combo_hits;
+    int32_t combo_damage;
+    int32_t hit_stop;
+    int32_t hit_stun;
+    int32_t current_input;
+    int32_t can_act;
+    int32_t airborne;
+    int32_t minion_count;
+    int64_t pos_x;
+    int64_t pos_y;
+    int64_t vel_x;
+    int64_t vel_y;
+    int64_t accel_x;
+    int64_t accel_y;
+    int64_t hit_vel_x;
+    int64_t hit_accel_x;
+} pd_guy_state;
+
+PD_API int pd_api_version(void);
+
+/* character data is looked up relative to the working directory, like the
+ * executables do */
+PD_API pd_sim *pd_sim_create(void);
+PD_API pd_sim *pd_sim_clone(pd_sim *sim);
+PD_API void pd_sim_free(pd_sim *sim);
+
+/* the first two guys become each other's opponent. pos_x is in units,
+ * direction is 1 facing right or -1 facing left. returns the guy's index or
+ * -1 if the character couldn't be loaded */
+PD_API int pd_sim_add_guy(pd_sim *sim, const char *char_name, int version, double pos_x, int direction);
+PD_API int pd_sim_guy_count(pd_sim *sim);
+
+/* inputs are one Input bitmask per guy in add order (see input.hpp), with
+ * FORWARD meaning right and BACK left on screen - the guy flips them to the way
+ * it faces. press bits get added from the previous frame's input.
+ * pd_sim_step_frames takes frame_count * guy_count inputs back to back. both
+ * return the sim's frame counter, or -1 on a bad argument */
+PD_API int pd_sim_step(pd_sim *sim, const int32_t *inputs, int input_count);
+PD_API int pd_sim_step_frames(pd_sim *sim, const int32_t *inputs, int input_count, int frame_count);
+/* same, and also fills out_states with every guy's state after each frame,
+ * frame_count * guy_count entries laid out like inputs */
+PD_API int pd_sim_step_frames_states(pd_sim *sim, const int32_t *inputs, int input_count, int frame_count, pd_guy_state *out_states);
+
+PD_API int pd_sim_get_frame(pd_sim *sim);
+PD_API int pd_sim_get_guy_state(pd_sim *sim, int guy_index, pd_guy_state *out_state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstring>
+
+#include "recording.hpp"
+#include "guy.hpp"
+
+// a few unchanged bytes in the middle of a run are cheaper to carry along
+// than starting a new run over them
+static const size_t deltaRunGap = 8;
+
+void FrameRecording::Record(Simulation *pSim)
+{
+    frames.emplace_back();
+    Frame &frame = frames.back();
+
+    StateBlob state;
+    pSim->SaveState(state);
+    frame.stateSize = state.data.size();
+
+    if ((firstFrame + frames.size() - 1) % keyframeInterval == 0) {
+        frame.keyframe = state.data;
+    } else {
+        const std::vector<uint8_t> &prev = lastState;
+        const std::vector<uint8_t> &cur = state.data;
+        size_t common = std::min(prev.size(), cur.size());
+        size_t i = 0;
+        while (i < cur.size()) {
+            if (i + 8 <= common && !memcmp(&prev[i], &cur[i], 8)) {
+                i += 8;
+                continue;
+            }
+            if (i < common && prev[i] == cur[i]) {
+                i++;
+                continue;
+            }
+            size_t start = i;
+            size_t lastChanged = i;
+            while (i < cur.size() && i - lastChanged <= deltaRunGap) {
+                if (i >= common || prev[i] != cur[i]) {
+                    lastChanged = i;
+                }
+                i++;
+            }
+            size_t end = lastChanged + 1;
+            frame.deltaRuns.push_back({(uint32_t)start, (uint32_t)(end - start)});
+            frame.deltaBytes.insert(frame.deltaBytes.end(), cur.begin() + start, cur.begin() + end);
+            i = end;
+        }
+    }
+    lastState = std::move(state.data);
+
+    for (Guy *pGuy : pSim->everyone) {
+        RecordedGuyFrame guyFrame;
+        guyFrame.uniqueID = pGuy->getUniqueID();
+        guyFrame.frameMeterColorIndex = pGuy->getFrameMeterColorIndex();
+        guyFrame.currentInput = pGuy->getCurrentInput();
+        guyFrame.direction = pGuy->getDirection();
+        guyFrame.posX = pGuy->getPosX().f();
+        guyFrame.posY = pGuy->getPosY().f();
+        guyFrame.frameTriggers.assign(pGuy->getFrameTriggers().begin(), pGuy->getFrameTriggers().end());
+        frame.guys.push_back(std::move(guyFrame));
+    }
+
+    frame.events = pSim->getCurrentFrameEvents();
+    pSim->getCurrentFrameEvents().clear();
+
+    // logs aren't part of the sim state, only keep a guy's when it changed
+    bool keyframe = !frame.keyframe.empty();
+    std::vector<RecordedLogQueue> logQueues;
+    for (Guy *pGuy : pSim->everyone) {
+        std::deque<std::string> &lines = pGuy->getLogQueue();
+        if (lines.empty()) {
+            continue;
+        }
+        RecordedLogQueue logQueue = {pGuy->getUniqueID(), pGuy->getLastLogFrame(), lines};
+        auto prevIt = std::find_if(lastLogQueues.begin(), lastLogQueues.end(), [&](const RecordedLogQueue &prevQueue) {
+            return prevQueue.guyID == logQueue.guyID;
+        });
+        if (keyframe || prevIt == lastLogQueues.end() || prevIt->lastLogFrame != logQueue.lastLogFrame || prevIt->lines != lines) {
+            frame.logQueues.push_back(logQueue);
+        }
+        logQueues.push_back(std::move(logQueue));
+    }
+    lastLogQueues = std::move(logQueues);
+}
+
+void FrameRecording::clear()
+{
+    frames.clear();
+    firstFrame = 0;
+    lastState.clear();
+    lastLogQueues.clear();
+    cache.clear();
+    cursorFrame = -1;
+    cursorState = StateBlob();
+}
+
+Simulation *FrameRecording::GetFrame(int frameIndex)
+{
+    if (frameIndex < 0 || frameIndex >= (int)frames.size()) {
+        return nullptr;
+    }
+
+    for (auto it = cache.begin(); it != cache.end(); it++) {
+        if (it->frameIndex == frameIndex) {
+            cache.splice(cache.begin(), cache, it);
+            return cache.front().pSim.get();
+        }
+    }
+
+    RebuildState(frameIndex);
+
+    // reuse the least recently used sim once the cache is full
+    std::unique_ptr<Simulation> pSim;
+    if ((int)cache.size() >= cachedFrameCount) {
+        pSim = std::move(cache.back().pSim);
+        cache.pop_back();
+    } else {
+        pSim = std::make_unique<Simulation>();
+    }
+    if (!pSim->LoadState(cursorState, nullptr, true)) {
+        return nullptr;
+    }
+
+    for (Guy *pGuy : pSim->everyone) {
+        const RecordedGuyFrame *pGuyFrame = GetGuy(frameIndex, pGuy->getUniqueID());
+        if (pGuyFrame) {
+            pGuy->getFrameTriggers() = std::set<ActionRef>(pGuyFrame->frameTriggers.begin(), pGuyFrame->frameTriggers.end());
+        }
+    }
+    RestoreLogQueues(frameIndex, pSim.get());
+
+    cache.push_front({frameIndex, std::move(pSim)});
+    return cache.front().pSim.get();
+}
+
+void FrameRecording::Truncate(int frameCount)
+{
+    if (frameCount <= 0) {
+        clear();
+        return;
+    }
+    if (frameCount >= (int)frames.size()) {
+        return;
+    }
+
+    cache.remove_if([frameCount](const CachedFrame &cached) { return cached.frameIndex >= frameCount; });
+    frames.resize(frameCount);
+
+    // the next Record diffs against the new last frame
+    RebuildState(frameCount - 1);
+    lastState = cursorState.data;
+    Simulation *pLastSim = GetFrame(frameCount - 1);
+    lastLogQueues.clear();
+    if (pLastSim) {
+        for (Guy *pGuy : pLastSim->everyone) {
+            if (!pGuy->getLogQueue().empty()) {
+                lastLogQueues.push_back({pGuy->getUniqueID(), pGuy->getLastLogFrame(), pGuy->getLogQueue()});
+            }
+        }
+    }
+}
+
+void FrameRecording::ContinueFrom(const FrameRecording &other)
+{
+    clear();
+    firstFrame = other.firstFrame + other.frames.size();
+    lastState = other.lastState;
+    lastLogQueues = other.lastLogQueues;
+}
+
+void FrameRecording::MoveFramesTo(FrameRecording &dst)
+{
+    if (frames.empty()) {
+        return;
+    }
+    for (Frame &frame : frames) {
+        dst.frames.push_back(std::move(frame));
+    }
+    firstFrame += frames.size();
+    frames.clear();
+    dst.lastState = lastState;
+    dst.lastLogQueues = lastLogQueues;
+}
+
+void FrameRecording::RebuildState(int frameIndex)
+{
+    int keyframeIndex = frameIndex - frameIndex % keyframeInterval;
+    if (cursorFrame < keyframeIndex || cursorFrame > frameIndex) {
+        cursorState.data = frames[keyframeIndex].keyframe;
+        cursorFrame = keyframeIndex;
+    }
+    while (cursorFrame < frameIndex) {
+        cursorFrame++;
+        const Frame &frame = frames[cursorFrame];
+        cursorState.data.resize(frame.stateSize);
+        size_t bytePos = 0;
+        for (const DeltaRun &run : frame.deltaRuns) {
+            memcpy(&cursorState.data[run.offset], &frame.deltaBytes[bytePos], run.size);
+            bytePos += run.size;
+        }
+    }
+}
+
+void FrameRecording::RestoreLogQueues(int frameIndex, Simulation *pSim)
+{
+    // keyframes have everyone's log, no need to look further back
+    int keyframeIndex = frameIndex - frameIndex % keyframeInterval;
+    for (Guy *pGuy : pSim->everyone) {
+        for (int i = frameIndex; i >= keyframeIndex; i--) {
+            auto &logQueues = frames[i].logQueues;
+            auto it = std::find_if(logQueues.begin(), logQueues.end(), [pGuy](const RecordedLogQueue &logQueue) {
+                return logQueue.guyID == pGuy->getUniqueID();
+            });
+            if (it != logQueues.end()) {
+                pGuy->getLogQueue() = it->lines;
+                pGuy->getLastLogFrame() = it->lastLogFrame;
+                break;
+            }
+        }
+    }
+}
+
+const RecordedGuyFrame *FrameRecording::GetGuy(int frameIndex, int guyID) const
+{
+    if (frameIndex < 0 || frameIndex >= (int)frames.size()) {
+        return nullptr;
+    }
+    for (const RecordedGuyFrame &guyFrame : frames[frameIndex].guys) {
+        if (guyFrame.uniqueID == guyID) {
+            return &guyFrame;
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<FrameEvent> *FrameRecording::GetEvents(int frameIndex) const
+{
+    if (frameIndex < 0 || frameIndex >= (int)frames.size()) {
+        return nullptr;
+    }
+    return &frames[frameIndex].events;
+}
+
+void FrameRecording::UpdateLastFrameTriggers(Simulation *pSim)
+{
+    if (frames.empty()) {
+        return;
+    }
+    int frameIndex = frames.size() - 1;
+    for (RecordedGuyFrame &guyFrame : frames[frameIndex].guys) {
+        for (Guy *pGuy : pSim->everyone) {
+            if (pGuy->getUniqueID() == guyFrame.uniqueID) {
+                guyFrame.frameTriggers.assign(pGuy->getFrameTriggers().begin(), pGuy->getFrameTriggers().end());
+                break;
+            }
+        }
+    }
+    // anything already rebuilt from the old triggers is stale
+    cache.remove_if([frameIndex](const CachedFrame &cached) { return cached.frameIndex == frameIndex; });
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chara.hpp"
+#include "simulation.hpp"
+
+// what the timeline reads off every recorded frame, kept for each frame so
+// drawing the frame meter never has to rebuild a sim
+struct RecordedGuyFrame {
+    int uniqueID = -1;
+    int frameMeterColorIndex = 0;
+    int currentInput = 0;
+    int direction = 1;
+    float posX = 0.0f;
+    float posY = 0.0f;
+    std::vector<ActionRef> frameTriggers;
+};
+
+// the viewer's frame by frame history of a sim. every keyframeInterval frames
+// there's a full SaveState, in between only the bytes that changed since the
+// frame before. GetFrame rebuilds a frame from its keyframe and keeps the last
+// few it built around, so a pointer it returns stays good until that many
+// other frames have been asked for
+class FrameRecording {
+public:
+    static const int keyframeInterval = 60;
+    static const int cachedFrameCount = 8;
+
+    void Record(Simulation *pSim);
+    size_t size() const { return frames.size(); }
+    bool empty() const { return frames.empty(); }
+    void clear();
+    // drops every frame from frameCount on, recording carries on after that
+    void Truncate(int frameCount);
+
+    // for recording on one thread and viewing on another: ContinueFrom starts
+    // an empty recording that picks up where other ends, MoveFramesTo hands
+    // what it has recorded since over to the end of dst. it keeps recording
+    // as if the frames were still there, but can't GetFrame them anymore
+    void ContinueFrom(const FrameRecording &other);
+    void MoveFramesTo(FrameRecording &dst);
+
+    Simulation *GetFrame(int frameIndex);
+    const RecordedGuyFrame *GetGuy(int frameIndex, int guyID) const;
+    const std::vector<FrameEvent> *GetEvents(int frameIndex) const;
+    // AdvanceFrame settles the frame triggers after the frame got recorded
+    void UpdateLastFrameTriggers(Simulation *pSim);
+
+private:
+    struct DeltaRun {
+        uint32_t offset;
+        uint32_t size;
+    };
+    struct RecordedLogQueue {
+        int guyID;
+        int lastLogFrame;
+        std::deque<std::string> lines;
+    };
+    struct Frame {
+        // the whole state on keyframes, otherwise deltaRuns over the previous
+        // frame's state with their bytes back to back in deltaBytes
+        std::vector<uint8_t> keyframe;
+        uint32_t stateSize = 0;
+        std::vector<DeltaRun> deltaRuns;
+        std::vector<uint8_t> deltaBytes;
+
+        std::vector<RecordedGuyFrame> guys;
+        std::vector<FrameEvent> events;
+        // only for guys that logged something this frame, or everyone with a
+        // log on keyframes
+        std::vector<RecordedLogQueue> logQueues;
+    };
+    struct CachedFrame {
+        int frameIndex;
+        std::unique_ptr<Simulation> pSim;
+    };
+
+    // leaves frameIndex's state in cursorState
+    void RebuildState(int frameIndex);
+    void RestoreLogQueues(int frameIndex, Simulation *pSim);
+
+    std::vector<Frame> frames;
+    // index of frames[0], only ever not 0 after ContinueFrom
+    int firstFrame = 0;
+    // what the next delta is against
+    std::vector<uint8_t> lastState;
+    std::vector<RecordedLogQueue> lastLogQueues;
+
+    // most recently used first
+    std::list<CachedFrame> cache;
+    // the last state GetFrame rebuilt, walking forward carries on from it
+    // instead of going back to the keyframe
+    int cursorFrame = -1;
+    StateBlob cursorState;
+};
@@ -602,7 +602,7 @@ void renderMarkersAndStuff(void)
 {
     int markerToDelete = -1;
     std::vector<Guy *> everyone;
-    defaultSim.gatherEveryone(&everyone, false);
+    trainingViewSim.gatherEveryone(&everyone, false);
     for (uint32_t i = 0; i < vecMarkers.size(); i++)
     {
         if (std::find(everyone.begin(), everyone.end(), vecMarkers[i].pOrigin) == everyone.end()) {
@@ -628,6 +628,78 @@ void renderMarkersAndStuff(void)
     }
 }
 
+// the realtime sim doesn't get recorded, its hit events turn into markers as they happen
+void addHitMarkersFromFrameEvents(Simulation *pSim)
+{
+    for (const auto &event : pSim->getCurrentFrameEvents()) {
+        if (event.type != FrameEvent::Hit) {
+            continue;
+        }
+        for (auto guy : pSim->everyone) {
+            if (guy->getUniqueID() == event.hitEventData.targetID) {
+                addHitMarker({event.hitEventData.x, event.hitEventData.y, event.hitEventData.radius, guy, event.hitEventData.hitType,
+                              0, 10, event.hitEventData.seed, event.hitEventData.dirX, event.hitEventData.dirY});
+                break;
+            }
+        }
+    }
+    pSim->getCurrentFrameEvents().clear();
+}
+
+void Guy::Render(float a /* = 1.0f */, bool showDomain) {
+    Fixed fixedX = posX + (posOffsetX * direction);
+    Fixed fixedY = posY + posOffsetY;
+    float x = fixedX.f();
+    float y = fixedY.f();
+
+    std::vector<RenderBox> renderBoxes;
+    getHurtBoxes(nullptr, nullptr, &renderBoxes);
+    getPushBoxes(nullptr, &renderBoxes);
+    getHitBoxes(nullptr, &renderBoxes, hitBoxType::none, showDomain ? hitBoxType::none : hitBoxType::domain);
+    getUniqueBoxes(nullptr, &renderBoxes);
+
+    for (auto box : renderBoxes) {
+        drawHitBox(box.box,thickboxes?box.thickness:1,0.0,box.col,box.drive,box.parry,box.di,a);
+    }
+
+    if (renderPositionAnchors && a == 1.0f) {
+        float radius = 6.0;
+        float thickness = thickboxes?radius:1;
+        drawBox(x-radius/2,y-radius/2,radius,radius,thickness,0.0,charColorR,charColorG,charColorB,1.0);
+        // radius = 5.0;
+        // drawBox(x-radius/2,y-radius/2,radius,radius,thickness,1.0,1.0,1.0,0.2);
+
+        // meters
+        if (!isProjectile) {
+            drawBox(x - 35.0, y - 1.0, focus / float(maxFocus) * 30.0, 3.0, 1.0, 0.0, !burnout ? 0.20 : 0.7, !burnout ? 0.80 : 0.7, !burnout ? 0.0 : 0.7, 1.0);
+            drawBox(x + 5.0, y - 1.0, gauge / float(pCharData->gauge) * 30.0, 3.0, 1.0, 0.0, 0.0, 0.80, 0.80, 1.0);
+            drawBox(x - 35.0, y + 5.0, health / float(pCharData->vitality) * 70.0, 3.0, 1.0, 0.0, 0.9, health > 2500 ? 0.90 : 0.0, health > 2500 ? 0.90 : 0.0, 1.0);
+        }
+    }
+}
+
+void Simulation::Render(float z /* = 0.0 */, bool showDomain)
+{
+    std::vector<Guy *> everyoneRender;
+    gatherEveryone(&everyoneRender, false);
+    for (auto guy : everyoneRender) {
+        guy->Render(z, showDomain);
+    }
+}
+
+void ComboFinder::Render(void)
+{
+    if (!running) {
+        return;
+    }
+
+    for (auto worker : workerPool) {
+        std::scoped_lock lockWorkerRenderSnapshot(worker->mutexRenderSnapshot);
+        worker->simRenderSnapshot.Render(1.0 / (workerPool.size() / 3.0) , false);
+        worker->wantsRenderSnapshot = true;
+    }
+}
+
 void setRenderState(color clearColor, int sizeX, int sizeY)
 {
     ImGui_ImplOpenGL3_NewFrame();
@@ -5,15 +5,7 @@
 #include "main.hpp"
 
 class Guy;
-
-struct RenderBox {
-    Box box;
-    float thickness = 10.0;
-    color col;
-    bool drive = false;
-    bool parry = false;
-    bool di = false;
-};
+class Simulation;
 
 struct HitMarker {
     float x;
@@ -38,6 +30,7 @@ extern int translateY;
 void setRenderState(color clearColor, int sizeX, int sizeY);
 void setScreenSpaceRenderState(int sizeX, int sizeY);
 void addHitMarker(HitMarker newMarker);
+void addHitMarkersFromFrameEvents(Simulation *pSim);
 void clearHitMarkers(void);
 void renderMarkersAndStuff(void);
 void drawHitMarker(float x, float y, float radius, int hitType, int time, int maxTime, float dirX = 1.0f, float dirY = 0.0f, int seed = 0);
@@ -0,0 +1,600 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#include "replay.hpp"
+#include "guy.hpp"
+#include "main.hpp"
+
+static const nlohmann::json &replayInputBytes(const nlohmann::json &inputData)
+{
+    if (inputData.is_object() && inputData.contains("mValue")) {
+        return inputData["mValue"];
+    }
+    return inputData;
+}
+
+static bool isOldReplayFormat(const nlohmann::json &replayInfo)
+{
+    if (replayInfo.contains("RoundInfo") && replayInfo["RoundInfo"].is_object()) {
+        return true;
+    }
+    if (replayInfo.contains("Fighters") && replayInfo["Fighters"].is_object()
+        && replayInfo["Fighters"].contains("FighterID")
+        && replayInfo["Fighters"]["FighterID"].is_array()) {
+        return true;
+    }
+    return false;
+}
+
+static void fixupOldReplayInfo(nlohmann::json &replayInfo)
+{
+    // fix up everything except input data, which still needs mValue accessed by hand
+
+    if (replayInfo["Fighters"].is_object() && replayInfo["Fighters"].contains("FighterID")
+        && replayInfo["Fighters"]["FighterID"].is_array()) {
+        nlohmann::json oldFighters = replayInfo["Fighters"];
+        nlohmann::json newFighters = nlohmann::json::array();
+        size_t n = oldFighters["FighterID"].size();
+        for (size_t i = 0; i < n; i++) {
+            nlohmann::json f = nlohmann::json::object();
+            for (auto it = oldFighters.begin(); it != oldFighters.end(); ++it) {
+                if (it.value().is_array() && it.value().size() > i) {
+                    f[it.key()] = it.value()[i];
+                }
+            }
+            newFighters.push_back(f);
+        }
+        replayInfo["Fighters"] = newFighters;
+    }
+
+    if (replayInfo["RoundInfo"].is_object()) {
+        nlohmann::json old = replayInfo["RoundInfo"];
+
+        nlohmann::json saGauge = nlohmann::json::array({0, 0});
+        if (old.contains("SAGaugeStart")) {
+            const auto &sg = old["SAGaugeStart"];
+            if (sg.is_object() && sg.contains("mValue")) saGauge = sg["mValue"];
+            else if (sg.is_array()) saGauge = sg;
+        }
+        nlohmann::json styleNo = nlohmann::json::array({0, 0});
+        if (old.contains("StyleNo")) {
+            const auto &sn = old["StyleNo"];
+            if (sn.is_object() && sn.contains("mValue")) styleNo = sn["mValue"];
+            else if (sn.is_array()) styleNo = sn;
+        }
+        nlohmann::json uniqueParam = nlohmann::json::array({0, 0});
+        if (old.contains("UniqueParam")) {
+            const auto &up = old["UniqueParam"];
+            if (up.is_object() && up.contains("raw")) uniqueParam = up["raw"];
+            else if (up.is_array()) uniqueParam = up;
+        }
+
+        int roundCount = 0;
+        if (old.contains("RandomSeed") && old["RandomSeed"].is_array()) {
+            roundCount = (int)old["RandomSeed"].size();
+        }
+
+        nlohmann::json newRounds = nlohmann::json::array();
+        for (int r = 0; r < roundCount; r++) {
+            nlohmann::json ri = nlohmann::json::object();
+            ri["RandomSeed"] = old["RandomSeed"][r];
+            ri["WinPlayerType"] = 0;
+            if (old.contains("WinPlayerType") && old["WinPlayerType"].is_array() && (int)old["WinPlayerType"].size() > r) {
+                ri["WinPlayerType"] = old["WinPlayerType"][r];
+            }
+            ri["FinishType"] = 0;
+            if (old.contains("FinishType") && old["FinishType"].is_array() && (int)old["FinishType"].size() > r) {
+                ri["FinishType"] = old["FinishType"][r];
+            }
+            // old format only stores end-of-match values for these fields; use them on the
+            // last round only and zero earlier rounds so simulation code can safely consume
+            // RoundInfo[r] without picking up wrong per-round state
+            bool isLast = (r == roundCount - 1);
+            ri["SAGaugeStart"] = isLast ? saGauge : nlohmann::json::array({0, 0});
+            ri["StyleNo"] = isLast ? styleNo : nlohmann::json::array({0, 0});
+            ri["UniqueParam"] = isLast ? uniqueParam : nlohmann::json::array({0, 0});
+            if (old.contains("BgmInfo")) ri["BgmInfo"] = old["BgmInfo"];
+            newRounds.push_back(ri);
+        }
+        replayInfo["RoundInfo"] = newRounds;
+    }
+}
+
+bool loadReplayData(nlohmann::json &parsed, int version, ReplayData &replay)
+{
+    nlohmann::json &data = parsed.contains("BattleReplayData") ? parsed["BattleReplayData"] : parsed;
+    if (!data.contains("InputData") || !data.contains("ReplayInfo")) {
+        return false;
+    }
+
+    replay.replayInfo = data["ReplayInfo"];
+    replay.isOldFormat = isOldReplayFormat(replay.replayInfo);
+    if (replay.isOldFormat) {
+        fixupOldReplayInfo(replay.replayInfo);
+    }
+    replay.inputData = replayInputBytes(data["InputData"]).get<std::vector<uint8_t>>();
+    if (version == -1) {
+        if (replay.replayInfo.contains("Version") && replay.replayInfo["Version"].is_number_integer()) {
+            int64_t startTime = 0;
+            if (parsed.contains("ReplayResultInfo") && parsed["ReplayResultInfo"].is_object()
+                && parsed["ReplayResultInfo"].contains("StartTime")
+                && parsed["ReplayResultInfo"]["StartTime"].is_number_integer()) {
+                startTime = parsed["ReplayResultInfo"]["StartTime"].get<int64_t>();
+            }
+            version = simVersionFromGameVersion(replay.replayInfo["Version"].get<int>(), startTime);
+        } else {
+            version = atoi(charVersions[charVersionCount - 1]);
+        }
+    }
+    replay.version = version;
+    return true;
+}
+
+void setupViewerGuys(Simulation *pSim)
+{
+    for (auto &guy : pSim->simGuys) {
+        guy->setRecordFrameTriggers(true, true);
+        guy->setLogTransitions(viewerLogTransitions);
+        guy->setLogTriggers(viewerLogTriggers);
+        guy->setLogUnknowns(viewerLogUnknowns);
+        guy->setLogHits(viewerLogHits);
+        guy->setLogBranches(viewerLogBranches);
+        guy->setLogResources(viewerLogResources);
+    }
+}
+
+bool simulateGameDump(Simulation *pSim, const std::string &path, int version,
+                      const std::function<void(Simulation *)> &onFrame)
+{
+    if (path.find("match") != std::string::npos) {
+        pSim->match = true;
+    }
+    if (path.find("forcepc") != std::string::npos) {
+        pSim->forcePunishCounter = true;
+    }
+
+    bool ret = pSim->SetupFromGameDump(path, version);
+    setupViewerGuys(pSim);
+
+    while (pSim->replayingGameStateDump) {
+        pSim->RunFrame();
+        if (onFrame) {
+            onFrame(pSim);
+        }
+        pSim->AdvanceFrame();
+    }
+
+    return ret;
+}
+
+std::vector<ReplayRoundStart> scanReplayRounds(const ReplayData &replay)
+{
+    std::vector<ReplayRoundStart> rounds;
+    int roundCount = (int)replay.replayInfo["RoundInfo"].size();
+
+    ReplayDecoder decoder;
+    decoder.inputData = replay.inputData;
+
+    for (int round = 0; round < roundCount; round++) {
+        if (replay.replayInfo["RoundInfo"][round]["RandomSeed"] == 0) {
+            break;
+        }
+
+        ReplayRoundStart start;
+        start.pos = decoder.pos;
+        start.finished = decoder.finished;
+        rounds.push_back(start);
+
+        // same stepping as the sim loop below, minus the sim
+        while (!decoder.finished) {
+            if (decoder.DecodeFrame() & ReplayDecoder::roundEndCommand) {
+                break;
+            }
+            if (!decoder.finished) {
+                int inputLeft, inputRight;
+                decoder.TakeInputs(inputLeft, inputRight);
+            }
+        }
+
+        decoder.inputState[0] = 0;
+        decoder.inputState[1] = 0;
+        decoder.prevInputState[0] = 0;
+        decoder.prevInputState[1] = 0;
+    }
+
+    return rounds;
+}
+
+struct SimulatedRound {
+    Simulation *pSim = nullptr;
+    int prevHealth[2] = {0, 0};
+    ReplayRoundStart start;
+    int frameCount = 0;
+    std::vector<StateBlob> checkpoints;
+};
+
+static void simulateReplayRound(const ReplayData &replay, int round, ReplayDecoder &decoder, const Simulation *prevRoundEnd,
+                                SimulatedRound &out, const std::function<void(int, Simulation *)> &onFrame,
+                                int checkpointInterval)
+{
+    out.start.pos = decoder.pos;
+    out.start.finished = decoder.finished;
+
+    Simulation *pSim = new Simulation;
+    pSim->SetupReplayRound(replay.replayInfo, round, replay.version, decoder, prevRoundEnd);
+    setupViewerGuys(pSim);
+
+    while (!decoder.finished && pSim->replayingReplay) {
+        if (checkpointInterval > 0 && out.frameCount % checkpointInterval == 0) {
+            out.checkpoints.emplace_back();
+            pSim->SaveState(out.checkpoints.back());
+        }
+        out.prevHealth[0] = pSim->simGuys[0]->getHealth();
+        out.prevHealth[1] = pSim->simGuys[1]->getHealth();
+        pSim->RunFrame();
+        if (onFrame) {
+            onFrame(round, pSim);
+        }
+        pSim->AdvanceFrame();
+        out.frameCount++;
+    }
+
+    // the decoder is about to go away or move on to the next round
+    pSim->pReplayDecoder = nullptr;
+    out.pSim = pSim;
+}
+
+static ReplayRoundResult checkReplayRound(const ReplayData &replay, int round, int roundCount, SimulatedRound &simulated, bool batchMode)
+{
+    Simulation *pSim = simulated.pSim;
+    const nlohmann::json &roundInfo = replay.replayInfo.at("RoundInfo").at(round);
+
+    if (batchMode) {
+        fprintf(stderr, "R;round %d finished at frame %d\n", round + 1, pSim->frameCounter);
+    }
+
+    int winPlayer = roundInfo.at("WinPlayerType");
+
+    ReplayRoundResult result;
+    result.finishFrame = pSim->frameCounter;
+    result.start = simulated.start;
+    result.frameCount = simulated.frameCount;
+    result.checkpoints = std::move(simulated.checkpoints);
+    std::string errors;
+
+    if (winPlayer == 0 || winPlayer == 1) {
+        int losePlayer = winPlayer ^ 1;
+        int loserHealth = pSim->simGuys[losePlayer]->getHealth();
+        if (loserHealth != 0 || simulated.prevHealth[losePlayer] == 0) {
+            if (batchMode) {
+                fprintf(stderr, "E;round %d loser (P%d) health %d expected zero prev health %d expected nonzero\n", round + 1, losePlayer + 1, loserHealth, simulated.prevHealth[losePlayer]);
+            }
+            errors += "loser P" + std::to_string(losePlayer + 1) + " health " + std::to_string(loserHealth) + "; ";
+            result.hasErrors = true;
+        }
+    } else {
+        for (int p = 0; p < 2; p++) {
+            int h = pSim->simGuys[p]->getHealth();
+            if (h != 0 || simulated.prevHealth[p] == 0) {
+                if (batchMode) {
+                    fprintf(stderr, "E;round %d draw P%d health %d expected zero prev health %d expected nonzero\n", round + 1, p + 1, h, simulated.prevHealth[p]);
+                }
+                errors += "draw P" + std::to_string(p + 1) + " health " + std::to_string(h) + "; ";
+                result.hasErrors = true;
+            }
+        }
+    }
+
+    bool checkGauge = !replay.isOldFormat || round == roundCount - 1;
+    if (checkGauge) {
+        for (int p = 0; p < 2; p++) {
+            int simGauge = pSim->simGuys[p]->getGauge();
+            int expectedGauge = roundInfo.at("SAGaugeStart").at(p);
+            if (expectedGauge != simGauge) {
+                if (batchMode) {
+                    fprintf(stderr, "E;round %d P%d end gauge %d expected %d\n", round + 1, p + 1, simGauge, expectedGauge);
+                }
+                errors += "P" + std::to_string(p + 1) + " gauge " + std::to_string(simGauge) + " expected " + std::to_string(expectedGauge) + "; ";
+                result.hasErrors = true;
+            }
+        }
+    }
+
+    if (result.hasErrors) {
+        result.summary = "Round " + std::to_string(round + 1) + ": " + errors;
+    } else {
+        result.summary = "Round " + std::to_string(round + 1) + ": OK";
+    }
+
+    return result;
+}
+
+void simulateReplayRounds(ReplayData &replay,
+                          const std::function<void(int, Simulation *)> &onFrame,
+                          const std::function<void(int, Simulation *, ReplayRoundResult &)> &onRoundEnd,
+                          const ReplayRunOptions &options)
+{
+    int roundCount = (int)replay.replayInfo["RoundInfo"].size();
+    bool batchMode = gameMode == Batch && options.printResults;
+
+    if (replay.isOldFormat || !options.parallelRounds) {
+        // old format rounds start from the previous round's end state, one
+        // decoder carries through all of them - new ones are fine like this too
+        ReplayDecoder decoder;
+        decoder.inputData = replay.inputData;
+
+        Simulation *prevRoundSim = nullptr;
+
+        for (int round = 0; round < roundCount; round++) {
+            if (replay.replayInfo["RoundInfo"][round]["RandomSeed"] == 0) {
+                break;
+            }
+
+            SimulatedRound simulated;
+            const Simulation *prevRoundEnd = (replay.isOldFormat && round > 0) ? prevRoundSim : nullptr;
+            simulateReplayRound(replay, round, decoder, prevRoundEnd, simulated, onFrame, options.checkpointInterval);
+
+            ReplayRoundResult result = checkReplayRound(replay, round, roundCount, simulated, batchMode);
+            if (onRoundEnd) {
+                onRoundEnd(round, simulated.pSim, result);
+            }
+
+            delete prevRoundSim;
+            prevRoundSim = simulated.pSim;
+
+            decoder.inputState[0] = 0;
+            decoder.inputState[1] = 0;
+            decoder.prevInputState[0] = 0;
+            decoder.prevInputState[1] = 0;
+        }
+
+        delete prevRoundSim;
+    } else {
+        // nothing carries over between new format rounds, so once we know
+        // where each one's input starts they can all run at once
+        std::vector<ReplayRoundStart> starts = scanReplayRounds(replay);
+        std::vector<SimulatedRound> simulated(starts.size());
+        std::vector<bool> roundDone(starts.size());
+        std::mutex doneMutex;
+        std::condition_variable doneCV;
+        std::atomic<size_t> nextRound = 0;
+
+        auto worker = [&]() {
+            size_t round;
+            while ((round = nextRound++) < starts.size()) {
+                ReplayDecoder decoder;
+                decoder.inputData = replay.inputData;
+                decoder.pos = starts[round].pos;
+                decoder.finished = starts[round].finished;
+                simulateReplayRound(replay, round, decoder, nullptr, simulated[round], onFrame, options.checkpointInterval);
+                {
+                    std::scoped_lock lock(doneMutex);
+                    roundDone[round] = true;
+                }
+                doneCV.notify_one();
+            }
+        };
+
+        // this thread only hands out results, so every hardware thread gets a worker
+        size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(starts.size(), 1));
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < workerCount; i++) {
+            workers.emplace_back(worker);
+        }
+
+        auto joinWorkers = [&]() {
+            for (std::thread &thread : workers) {
+                thread.join();
+            }
+        };
+
+        // results and their output stay in round order, each round goes out
+        // as soon as it and every round before it are done
+        try {
+            for (size_t round = 0; round < simulated.size(); round++) {
+                {
+                    std::unique_lock lock(doneMutex);
+                    doneCV.wait(lock, [&]() { return roundDone[round]; });
+                }
+                ReplayRoundResult result = checkReplayRound(replay, round, roundCount, simulated[round], batchMode);
+                if (onRoundEnd) {
+                    onRoundEnd(round, simulated[round].pSim, result);
+                }
+                delete simulated[round].pSim;
+                simulated[round].pSim = nullptr;
+            }
+        } catch (...) {
+            joinWorkers();
+            for (SimulatedRound &round : simulated) {
+                delete round.pSim;
+            }
+            throw;
+        }
+        joinWorkers();
+    }
+
+    if (batchMode) {
+        fprintf(stderr, "F;replay finished;%d\n", replay.version);
+    }
+}
+
+std::string replayIndexPath(const std::string &replayPath)
+{
+    return replayPath + ".pdindex";
+}
+
+// fnv-1a over everything the simulation reads from the replay
+uint64_t hashReplayData(const ReplayData &replay)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto hashBytes = [&hash](const void *pData, size_t size) {
+        const uint8_t *pBytes = (const uint8_t *)pData;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ pBytes[i]) * 0x100000001b3ull;
+        }
+    };
+    hashBytes(replay.inputData.data(), replay.inputData.size());
+    hashBytes(&replay.version, sizeof(replay.version));
+    std::string info = replay.replayInfo.dump();
+    hashBytes(info.data(), info.size());
+    return hash;
+}
+
+void buildReplayIndex(ReplayData &replay, ReplayIndex &index, int checkpointInterval)
+{
+    index = ReplayIndex();
+    index.replayHash = hashReplayData(replay);
+    index.checkpointInterval = checkpointInterval;
+
+    ReplayRunOptions options;
+    options.printResults = false;
+    options.checkpointInterval = checkpointInterval;
+    simulateReplayRounds(replay, nullptr, [&index](int, Simulation *, ReplayRoundResult &result) {
+        index.rounds.push_back(std::move(result));
+    }, options);
+}
+
+static const uint32_t replayIndexMagic = 0x49524450; // 'PDRI'
+static const uint32_t replayIndexVersion = 1;
+
+bool writeReplayIndex(const ReplayIndex &index, const std::string &path)
+{
+    StateBlob blob;
+    blob.write(replayIndexMagic);
+    blob.write(replayIndexVersion);
+    blob.write(index.replayHash);
+    blob.write(index.checkpointInterval);
+    blob.write<uint32_t>(index.rounds.size());
+    for (const ReplayRoundResult &round : index.rounds) {
+        blob.writeString(round.summary);
+        blob.write(round.hasErrors);
+        blob.write(round.finishFrame);
+        blob.write(round.start.pos);
+        blob.write(round.start.finished);
+        blob.write(round.frameCount);
+        blob.write<uint32_t>(round.checkpoints.size());
+        for (const StateBlob &checkpoint : round.checkpoints) {
+            blob.write<uint32_t>(checkpoint.data.size());
+            blob.writeBytes(checkpoint.data.data(), checkpoint.data.size());
+        }
+    }
+
+    std::ofstream f(path, std::ios::binary);
+    if (!f) {
+        return false;
+    }
+    f.write((const char *)blob.data.data(), blob.data.size());
+    return (bool)f;
+}
+
+bool loadReplayIndex(const std::string &path, const ReplayData &replay, ReplayIndex &index)
+{
+    index = ReplayIndex();
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        return false;
+    }
+    StateBlob blob;
+    blob.data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+
+    if (blob.read<uint32_t>() != replayIndexMagic || blob.read<uint32_t>() != replayIndexVersion) {
+        return false;
+    }
+    index.replayHash = blob.read<uint64_t>();
+    index.checkpointInterval = blob.read<int>();
+    if (blob.overrun || index.replayHash != hashReplayData(replay) || index.checkpointInterval <= 0) {
+        index = ReplayIndex();
+        return false;
+    }
+
+    uint32_t roundCount = blob.read<uint32_t>();
+    for (uint32_t r = 0; r < roundCount && !blob.overrun; r++) {
+        ReplayRoundResult round;
+        round.summary = blob.readString();
+        round.hasErrors = blob.read<bool>();
+        round.finishFrame = blob.read<int>();
+        round.start.pos = blob.read<int>();
+        round.start.finished = blob.read<bool>();
+        round.frameCount = blob.read<int>();
+        uint32_t checkpointCount = blob.read<uint32_t>();
+        for (uint32_t i = 0; i < checkpointCount && !blob.overrun; i++) {
+            uint32_t size = blob.read<uint32_t>();
+            StateBlob checkpoint;
+            checkpoint.data.resize(blob.overrun ? 0 : size);
+            blob.readBytes(checkpoint.data.data(), checkpoint.data.size());
+            round.checkpoints.push_back(std::move(checkpoint));
+        }
+        index.rounds.push_back(std::move(round));
+    }
+
+    if (blob.overrun) {
+        index = ReplayIndex();
+        return false;
+    }
+
+    // an index written by another build has the right hash but checkpoints
+    // this one can't load, better to find out now than when seeking
+    if (!index.rounds.empty() && !index.rounds[0].checkpoints.empty()) {
+        Simulation sim;
+        ReplayDecoder decoder;
+        StateBlob checkpoint = index.rounds[0].checkpoints[0];
+        bool loaded = sim.LoadState(checkpoint, &decoder);
+        sim.pReplayDecoder = nullptr;
+        if (!loaded) {
+            index = ReplayIndex();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool seekReplayIndex(const ReplayIndex &index, const ReplayData &replay, int round, int frame,
+                     Simulation *pSim, ReplayDecoder &decoder,
+                     const std::function<void(int, Simulation *)> &onFrame)
+{
+    if (round < 0 || round >= (int)index.rounds.size() || frame < 0) {
+        return false;
+    }
+    const ReplayRoundResult &indexRound = index.rounds[round];
+    int checkpoint = std::min<int>(frame / index.checkpointInterval, (int)indexRound.checkpoints.size() - 1);
+    if (checkpoint < 0) {
+        return false;
+    }
+
+    // LoadState doesn't touch the blob's contents, only its read position
+    StateBlob blob = indexRound.checkpoints[checkpoint];
+    decoder.inputData = replay.inputData;
+    if (!pSim->LoadState(blob, &decoder)) {
+        return false;
+    }
+    setupViewerGuys(pSim);
+
+    int simFrame = checkpoint * index.checkpointInterval;
+    while (simFrame < frame && !decoder.finished && pSim->replayingReplay) {
+        pSim->RunFrame();
+        if (onFrame) {
+            onFrame(round, pSim);
+        }
+        pSim->AdvanceFrame();
+        simFrame++;
+    }
+    return true;
+}
+
+void finishReplayRound(int round, Simulation *pSim, ReplayDecoder &decoder,
+                       const std::function<void(int, Simulation *)> &onFrame)
+{
+    while (!decoder.finished && pSim->replayingReplay) {
+        pSim->RunFrame();
+        if (onFrame) {
+            onFrame(round, pSim);
+        }
+        pSim->AdvanceFrame();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "simulation.hpp"
+
+// a replay file boiled down to what the sim needs, old format replays get
+// their ReplayInfo rewritten to the new layout on load
+struct ReplayData {
+    nlohmann::json replayInfo;
+    std::vector<uint8_t> inputData;
+    int version = -1;
+    bool isOldFormat = false;
+};
+
+// where a round's input starts in ReplayData::inputData
+struct ReplayRoundStart {
+    int pos = 0;
+    bool finished = false;
+};
+
+struct ReplayRoundResult {
+    std::string summary;
+    bool hasErrors = false;
+    // the sim frame the round ended on, which is where any errors are found
+    int finishFrame = 0;
+
+    ReplayRoundStart start;
+    // how many times the round ran RunFrame
+    int frameCount = 0;
+    // with ReplayRunOptions::checkpointInterval, the sim state right before
+    // frame i * checkpointInterval of the round ran
+    std::vector<StateBlob> checkpoints;
+};
+
+struct ReplayRunOptions {
+    // new format rounds each on their own thread
+    bool parallelRounds = true;
+    // the R;/E;/F; lines on stderr, only ever in batch mode
+    bool printResults = true;
+    // SaveState every this many frames into the round results, 0 for none
+    int checkpointInterval = 0;
+};
+
+bool loadReplayData(nlohmann::json &parsed, int version, ReplayData &replay);
+
+// frame trigger recording and the viewer log flags, on every guy of a new sim
+void setupViewerGuys(Simulation *pSim);
+
+// finds every round's start by decoding the input without simulating, the
+// decoder state is reset between rounds so that's all a round needs
+std::vector<ReplayRoundStart> scanReplayRounds(const ReplayData &replay);
+
+// onFrame runs between RunFrame and AdvanceFrame, in batch mode errors and
+// round results go to stderr
+bool simulateGameDump(Simulation *pSim, const std::string &path, int version,
+                      const std::function<void(Simulation *)> &onFrame = nullptr);
+// new format rounds don't depend on each other and get simulated in parallel,
+// so onFrame can run on several threads at once - each round only on one.
+// onRoundEnd gets called on the calling thread in round order either way
+void simulateReplayRounds(ReplayData &replay,
+                          const std::function<void(int, Simulation *)> &onFrame = nullptr,
+                          const std::function<void(int, Simulation *, ReplayRoundResult &)> &onRoundEnd = nullptr,
+                          const ReplayRunOptions &options = {});
+
+// what a replay's rounds looked like after simulating them once, kept next to
+// the replay (<replay>.pdindex) so the viewer can open any round or frame with
+// one LoadState and at most checkpointInterval frames of simulation. the
+// checkpoints are StateBlobs, so an index only loads in the build that wrote it
+struct ReplayIndex {
+    uint64_t replayHash = 0;
+    int checkpointInterval = 0;
+    std::vector<ReplayRoundResult> rounds;
+};
+
+const int defaultReplayCheckpointInterval = 300;
+
+std::string replayIndexPath(const std::string &replayPath);
+uint64_t hashReplayData(const ReplayData &replay);
+void buildReplayIndex(ReplayData &replay, ReplayIndex &index, int checkpointInterval = defaultReplayCheckpointInterval);
+bool writeReplayIndex(const ReplayIndex &index, const std::string &path);
+// fails if the file is missing, for a different replay or from another build
+bool loadReplayIndex(const std::string &path, const ReplayData &replay, ReplayIndex &index);
+
+// loads the closest checkpoint at or before frame into pSim (a fresh one) and
+// simulates up to frame, leaving it ready to RunFrame it. the sim reads its
+// input from decoder, which has to outlive it
+bool seekReplayIndex(const ReplayIndex &index, const ReplayData &replay, int round, int frame,
+                     Simulation *pSim, ReplayDecoder &decoder,
+                     const std::function<void(int, Simulation *)> &onFrame = nullptr);
+// keeps going from wherever the sim is until the round ends
+void finishReplayRound(int round, Simulation *pSim, ReplayDecoder &decoder,
+                       const std::function<void(int, Simulation *)> &onFrame = nullptr);
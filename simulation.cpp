@@ -1,28 +1,49 @@
 #include "simulation.hpp"
 #include "guy.hpp"
-#include "ui.hpp"
 #include "input.hpp"
-#include "render.hpp"
 
 Simulation::~Simulation() {
     if (!enableCleanup) {
         return;
     }
-    gatherEveryone();
-    for (auto guy: everyone) {
-        // don't try to massage the guys list or opponent pointers, we're deleting everything
-        guy->enableCleanup = false;
-        delete guy;
+    for (GuySlot *pSlot : guySlots) {
+        if (pSlot->live) {
+            // don't try to massage the guys list or opponent pointers, we're deleting everything
+            pSlot->guy()->enableCleanup = false;
+            pSlot->guy()->~Guy();
+        }
+        delete pSlot;
     }
 }
 
-void Simulation::gatherEveryone(std::vector<Guy*> *vecOutEveryone /* = nullptr */, bool simulationOrder /* = true */)
+void *Simulation::AllocGuySlot()
 {
-    if (!vecOutEveryone) {
-        vecOutEveryone = &everyone;
+    GuySlot *pSlot;
+    if (freeGuySlots.size()) {
+        pSlot = guySlots[freeGuySlots.back()];
+        freeGuySlots.pop_back();
+    } else {
+        pSlot = new GuySlot;
+        pSlot->pSim = this;
+        pSlot->index = guySlots.size();
+        guySlots.push_back(pSlot);
     }
-    vecOutEveryone->clear();
+    pSlot->live = true;
+    return pSlot->storage;
+}
 
+void Simulation::FreeGuySlot(void *pStorage)
+{
+    GuySlot *pSlot = guySlotOf((Guy *)pStorage);
+    assert(pSlot->live);
+    pSlot->live = false;
+    // refs to whoever was here go stale
+    pSlot->generation++;
+    pSlot->pSim->freeGuySlots.push_back(pSlot->index);
+}
+
+void Simulation::gatherEveryone(std::vector<Guy*> *vecOutEveryone /* = nullptr */, bool simulationOrder /* = true */)
+{
     bool filterOdd = true;
     if (frameCounter & 1) {
         filterOdd = !filterOdd;
@@ -37,6 +58,21 @@ void Simulation::gatherEveryone(std::vector<Guy*> *vecOutEveryone /* = nullptr *
         }
     }
 
+    if (!vecOutEveryone) {
+        vecOutEveryone = &everyone;
+        if (simulationOrder) {
+            if (!rosterDirty && filterOdd == rosterFilterOdd) {
+                return;
+            }
+            rosterDirty = false;
+            rosterFilterOdd = filterOdd;
+        } else {
+            // not the order the cache is keyed on
+            rosterDirty = true;
+        }
+    }
+    vecOutEveryone->clear();
+
     for (uint32_t i = 0; i < simGuys.size(); i++) {
         if ((i & 1) == filterOdd && simulationOrder) {
             continue;
@@ -65,135 +101,287 @@ void Simulation::gatherEveryone(std::vector<Guy*> *vecOutEveryone /* = nullptr *
 
 void Simulation::Clone(Simulation *pOtherSim)
 {
-    gatherEveryone();
-
-    if (everyone.size() < pOtherSim->everyone.size()) {
-        int guysToAllocate = pOtherSim->everyone.size() - everyone.size();
-        for (int i = 0; i < guysToAllocate; i++) {
-            Guy *newGuy = new Guy;
-            everyone.push_back(newGuy);
+    // mirror their pool slot for slot, so every ref just moves over to our
+    // slot of the same index
+    while (guySlots.size() < pOtherSim->guySlots.size()) {
+        GuySlot *pSlot = new GuySlot;
+        pSlot->pSim = this;
+        pSlot->index = guySlots.size();
+        guySlots.push_back(pSlot);
+    }
+
+    for (uint32_t i = 0; i < guySlots.size(); i++) {
+        GuySlot *pSlot = guySlots[i];
+        GuySlot *pOtherSlot = i < pOtherSim->guySlots.size() ? pOtherSim->guySlots[i] : nullptr;
+        bool otherLive = pOtherSlot && pOtherSlot->live;
+        if (pSlot->live && !otherLive) {
+            pSlot->guy()->enableCleanup = false;
+            pSlot->guy()->~Guy();
+            pSlot->live = false;
         }
-    }
-    if (everyone.size() > pOtherSim->everyone.size()) {
-        int guysToFree = everyone.size() - pOtherSim->everyone.size();
-        for (int i = 0; i < guysToFree; i++) {
-            everyone.back()->enableCleanup = false;
-            delete everyone.back();
-            everyone.pop_back();
+        if (otherLive) {
+            if (!pSlot->live) {
+                ::new (pSlot->storage) Guy;
+                pSlot->live = true;
+            }
+            *pSlot->guy() = *pOtherSlot->guy();
+            pSlot->guy()->setSim(this);
         }
+        pSlot->generation = pOtherSlot ? pOtherSlot->generation : pSlot->generation + 1;
     }
 
-    std::map<int,Guy*> guysByID;
-    std::map<Guy*,Guy*> ourGuyByTheirGuy;
-
-    assert(everyone.size() == pOtherSim->everyone.size());
-
-    for (uint64_t i = 0; i < everyone.size(); i++) {
-        *everyone[i] = *pOtherSim->everyone[i];
-        everyone[i]->setSim(this);
-        assert(guysByID.find(everyone[i]->getUniqueID()) == guysByID.end());
-        guysByID[everyone[i]->getUniqueID()] = everyone[i];
-        ourGuyByTheirGuy[pOtherSim->everyone[i]] = everyone[i];
+    // our extra slots go under theirs so we keep handing out the same
+    // indices they would
+    freeGuySlots.clear();
+    for (uint32_t i = guySlots.size(); i > pOtherSim->guySlots.size(); i--) {
+        freeGuySlots.push_back(i - 1);
     }
+    freeGuySlots.insert(freeGuySlots.end(), pOtherSim->freeGuySlots.begin(), pOtherSim->freeGuySlots.end());
 
-    for (uint64_t i = 0; i < everyone.size(); i++) {
-        everyone[i]->FixRefs(guysByID);
-        assert(everyone[i]->getUniqueID() == pOtherSim->everyone[i]->getUniqueID());
+    for (GuySlot *pSlot : guySlots) {
+        if (pSlot->live) {
+            pSlot->guy()->FixRefs(this);
+        }
     }
 
     simGuys.clear();
     for (Guy *pGuy : pOtherSim->simGuys) {
-        simGuys.push_back(ourGuyByTheirGuy[pGuy]);
+        simGuys.push_back(guySlots[guySlotOf(pGuy)->index]->guy());
     }
 
     vecGuysToDelete.clear();
     for (Guy *pGuy : pOtherSim->vecGuysToDelete) {
-        assert(ourGuyByTheirGuy.find(pGuy) != ourGuyByTheirGuy.end());
-        vecGuysToDelete.push_back(ourGuyByTheirGuy[pGuy]);
+        vecGuysToDelete.push_back(guySlots[guySlotOf(pGuy)->index]->guy());
     }
 
+    markRosterDirty();
+
+    charDataRefs = pOtherSim->charDataRefs;
     guyIDCounter = pOtherSim->guyIDCounter;
     frameCounter = pOtherSim->frameCounter;
+    randomSeed = pOtherSim->randomSeed;
+    match = pOtherSim->match;
+    finished = pOtherSim->finished;
+    timerStarted = pOtherSim->timerStarted;
     comboProbe = pOtherSim->comboProbe;
+    forceCounter = pOtherSim->forceCounter;
+    forcePunishCounter = pOtherSim->forcePunishCounter;
 }
 
-void Simulation::CreateGuy(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color)
-{
-    Guy *pNewGuy = new Guy(this, charName, charVersion, x, y, startDir, color);
+static const uint32_t simStateMagic = 0x53534450; // 'PDSS'
+static const uint32_t simStateVersion = 2;
 
-    if (simGuys.size()) {
-        pNewGuy->setOpponent(simGuys[0]);
-        if (simGuys.size() == 1) {
-            simGuys[0]->setOpponent(pNewGuy);
-        }
-    }
-
-    simGuys.push_back(pNewGuy);
-}
-
-void Simulation::CreateGuyFromDumpedPlayer(nlohmann::json &playerJson, int version)
+void Simulation::SaveState(StateBlob &blob)
 {
-    std::string charName = getCharNameFromID(playerJson["charID"]);
-    Fixed posX = Fixed(playerJson["posX"].get<double>());
-    Fixed posY = Fixed(playerJson["posY"].get<double>());
-    int bitValue = playerJson["bitValue"];
-    int charDirection = (bitValue & 1<<7) ? 1 : -1;
-    color charColor = {randFloat(), randFloat(), randFloat()};
+    gatherEveryone();
 
-    CreateGuy(charName, version, posX, posY, charDirection, charColor);
+    blob.write<uint32_t>(simStateMagic);
+    blob.write<uint32_t>(simStateVersion);
+
+    blob.write<uint32_t>(everyone.size());
+    for (Guy *pGuy : everyone) {
+        pGuy->SaveState(blob);
+    }
+    blob.write<uint32_t>(simGuys.size());
+    for (Guy *pGuy : simGuys) {
+        blob.write<int>(pGuy->getUniqueID());
+    }
+    blob.write<uint32_t>(vecGuysToDelete.size());
+    for (Guy *pGuy : vecGuysToDelete) {
+        blob.write<int>(pGuy->getUniqueID());
+    }
+
+    blob.write(guyIDCounter);
+    blob.write(frameCounter);
+    blob.write(randomSeed);
+    blob.write(comboProbe);
+    blob.write(match);
+    blob.write(forceCounter);
+    blob.write(forcePunishCounter);
+    blob.write(finished);
+    blob.write(timerStarted);
+
+    blob.write(replayingGameStateDump);
+    blob.write(dumpCompareFirstFrame);
+    blob.write(gameStateFrame);
+    blob.write(gameStateStartFrame);
+    blob.write(replayErrors);
+
+    blob.write(replayingReplay);
+    blob.write(replayTimerStartFrame);
+    blob.write<bool>(pReplayDecoder != nullptr);
+    if (pReplayDecoder) {
+        blob.write(pReplayDecoder->pos);
+        blob.write(pReplayDecoder->inputState);
+        blob.write(pReplayDecoder->prevInputState);
+        blob.write(pReplayDecoder->finished);
+    }
 }
 
-void Simulation::CreateGuyFromCharController(CharacterUIController &controller)
+bool Simulation::LoadState(StateBlob &blob, ReplayDecoder *pDecoder, bool detached)
 {
-    std::string charName = charNames[controller.character];
+    blob.readPos = 0;
+    blob.overrun = false;
+    if (blob.read<uint32_t>() != simStateMagic || blob.read<uint32_t>() != simStateVersion) {
+        return false;
+    }
 
-    int version = atoi(charVersions[controller.charVersion]);
-    CreateGuy(charName, version, controller.startPosX, Fixed(0), controller.rightSide ? -1 : 1, controller.charColor);
+    gatherEveryone();
+    for (Guy *pGuy : everyone) {
+        pGuy->enableCleanup = false;
+        delete pGuy;
+    }
+    everyone.clear();
+    simGuys.clear();
+    vecGuysToDelete.clear();
+    charDataRefs.clear();
+    markRosterDirty();
 
-    Guy *pGuy = simGuys[controller.getSimCharSlot()];
+    std::vector<Guy *> loadedGuys;
+    std::map<int,Guy*> guysByID;
+    bool loaded = true;
+    uint32_t guyCount = blob.read<uint32_t>();
+    for (uint32_t i = 0; i < guyCount && loaded; i++) {
+        Guy *pGuy = new (this) Guy;
+        loadedGuys.push_back(pGuy);
+        loaded = pGuy->LoadState(blob, this) && guysByID.find(pGuy->getUniqueID()) == guysByID.end();
+        guysByID[pGuy->getUniqueID()] = pGuy;
+    }
+
+    auto readGuyList = [&](std::vector<Guy *> &outList) {
+        uint32_t count = blob.read<uint32_t>();
+        for (uint32_t i = 0; i < count && !blob.overrun; i++) {
+            auto it = guysByID.find(blob.read<int>());
+            if (it == guysByID.end()) {
+                loaded = false;
+                return;
+            }
+            outList.push_back(it->second);
+        }
+    };
+    if (loaded) {
+        readGuyList(simGuys);
+        readGuyList(vecGuysToDelete);
+    }
 
-    controller.maxStartHealth = pGuy->getCharData()->vitality;
-    controller.maxStartGauge = pGuy->getCharData()->gauge;
+    if (loaded) {
+        for (Guy *pGuy : loadedGuys) {
+            pGuy->FixRefs(guysByID);
+        }
+    }
 
-    if (controller.startHealth == 0) {
-        controller.startHealth = controller.maxStartHealth;
+    guyIDCounter = blob.read<int>();
+    frameCounter = blob.read<int>();
+    randomSeed = blob.read<int>();
+    blob.readBytes(&comboProbe, sizeof(comboProbe));
+    match = blob.read<bool>();
+    forceCounter = blob.read<bool>();
+    forcePunishCounter = blob.read<bool>();
+    finished = blob.read<bool>();
+    timerStarted = blob.read<bool>();
+
+    replayingGameStateDump = blob.read<bool>();
+    dumpCompareFirstFrame = blob.read<bool>();
+    gameStateFrame = blob.read<int>();
+    gameStateStartFrame = blob.read<int>();
+    replayErrors = blob.read<int>();
+    if (replayingGameStateDump && gameStateFrame >= (int)dumpFrames.size() && !detached) {
+        loaded = false;
+    }
+
+    replayingReplay = blob.read<bool>();
+    replayTimerStartFrame = blob.read<int>();
+    pReplayDecoder = nullptr;
+    ReplayDecoder detachedDecoder;
+    if (detached) {
+        pDecoder = &detachedDecoder;
+    }
+    if (blob.read<bool>()) {
+        if (!pDecoder) {
+            loaded = false;
+        } else {
+            pReplayDecoder = pDecoder;
+            pDecoder->pos = blob.read<int>();
+            blob.readBytes(pDecoder->inputState, sizeof(pDecoder->inputState));
+            blob.readBytes(pDecoder->prevInputState, sizeof(pDecoder->prevInputState));
+            pDecoder->finished = blob.read<bool>();
+        }
     }
-    if (controller.startHealth > controller.maxStartHealth) {
-        controller.startHealth = controller.maxStartHealth;
+
+    if (!loaded || blob.overrun) {
+        // refs may be half fixed up, don't let the destructors chase them
+        for (Guy *pGuy : loadedGuys) {
+            pGuy->enableCleanup = false;
+            delete pGuy;
+        }
+        simGuys.clear();
+        vecGuysToDelete.clear();
+        charDataRefs.clear();
+        replayingGameStateDump = false;
+        replayingReplay = false;
+        pReplayDecoder = nullptr;
+        return false;
     }
-    if (controller.startGauge == 0) {
-        controller.startGauge = controller.maxStartGauge;
+
+    if (detached) {
+        replayingGameStateDump = false;
+        replayingReplay = false;
+        pReplayDecoder = nullptr;
     }
-    if (controller.startGauge > controller.maxStartGauge) {
-        controller.startGauge = controller.maxStartGauge;
+
+    gatherEveryone();
+    return true;
+}
+
+CharacterData *Simulation::AcquireCharacterData(const std::string &charName, int charVersion)
+{
+    std::shared_ptr<CharacterData> pCharData = loadCharacter(charName, charVersion);
+    if (std::find(charDataRefs.begin(), charDataRefs.end(), pCharData) == charDataRefs.end()) {
+        charDataRefs.push_back(pCharData);
     }
-    pGuy->setHealth(controller.startHealth);
-    pGuy->setFocus(controller.startFocus);
-    pGuy->setGauge(controller.startGauge);
+    return pCharData.get();
+}
 
-    pGuy->DoInstantAction(580); // IMM_STAGE_INIT
-    pGuy->DoInstantAction(581); // IMM_ROUND_INIT
+void Simulation::CreateGuy(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color)
+{
+    Guy *pNewGuy = new (this) Guy(this, charName, charVersion, x, y, startDir, color);
 
-    if (controller.buffLevel != pGuy->getUniqueParam(0)) {
-        pGuy->getUniqueParam(0) = controller.buffLevel;
-        if (controller.buffLevel && controller.buffLevel < (int)(pGuy->getCharData()->styles.size())) {
-            pGuy->ChangeStyle(controller.buffLevel);
+    if (simGuys.size()) {
+        pNewGuy->setOpponent(simGuys[0]);
+        if (simGuys.size() == 1) {
+            simGuys[0]->setOpponent(pNewGuy);
         }
     }
+
+    simGuys.push_back(pNewGuy);
+    markRosterDirty();
 }
 
+void Simulation::CreateGuyFromDumpedPlayer(int dumpFrame, int player, int version)
+{
+    std::string charName = getCharNameFromID(gameStateDump.get(dumpFrame, player, eDumpCharID));
+    Fixed posX = gameStateDump.getFixed(dumpFrame, player, eDumpPosX);
+    Fixed posY = gameStateDump.getFixed(dumpFrame, player, eDumpPosY);
+    int bitValue = gameStateDump.get(dumpFrame, player, eDumpBitValue);
+    int charDirection = (bitValue & 1<<7) ? 1 : -1;
+    color charColor = {randFloat(), randFloat(), randFloat()};
+
+    CreateGuy(charName, version, posX, posY, charDirection, charColor);
+}
 
 bool Simulation::SetupFromGameDump(std::string dumpPath, int version)
 {
-    gameStateDump = parse_json_file(dumpPath);
-    if (gameStateDump == nullptr) {
+    // takes either the json dump or one made by convert_dump
+    if (!loadGameDump(dumpPath, gameStateDump)) {
         return false;
     }
+    decodeGameDumpFrames(gameStateDump, dumpFrames);
 
+    GameDump &dump = gameStateDump;
     int i = 0;
-    while (i < (int)gameStateDump.size()) {
-        if (gameStateDump[i]["playTimer"] != 0 && gameStateDump[i]["players"][0]["actionID"] != 0 &&
-            gameStateDump[i+1]["players"][0]["actionFrame"] != 0) {
+    while (i + 1 < dump.frameCount) {
+        if (dump.get(i, eDumpPlayTimer) != 0 && dump.get(i, 0, eDumpActionID) != 0 &&
+            dump.get(i+1, 0, eDumpActionFrame) != 0) {
             break;
         }
         i++;
@@ -204,36 +392,34 @@ bool Simulation::SetupFromGameDump(std::string dumpPath, int version)
         version = atoi(charVersions[charVersionCount - 1]);
     }
 
-    nlohmann::json &players = gameStateDump[i]["players"];
-    CreateGuyFromDumpedPlayer(players[0], version);
-    CreateGuyFromDumpedPlayer(players[1], version);
+    CreateGuyFromDumpedPlayer(i, 0, version);
+    CreateGuyFromDumpedPlayer(i, 1, version);
 
     int playerID = 0;
     while (playerID < 2) {
-        nlohmann::json &playerJson = players[playerID];
-        int actionID = playerJson["actionID"];
-        int actionFrame = playerJson["actionFrame"];
+        int actionID = dump.get(i, playerID, eDumpActionID);
+        int actionFrame = dump.get(i, playerID, eDumpActionFrame);
         if (actionID == 17) {
             // guile66hit combo has p2 in mid-dash and we don't capture posoffset
             actionID = 1;
             actionFrame = 0;
         }
         simGuys[playerID]->setAction(actionID, actionFrame - 1);
-        simGuys[playerID]->setHealth(playerJson["hp"]);
-        simGuys[playerID]->setFocus(playerJson.value("driveGauge", maxFocus));
+        simGuys[playerID]->setHealth(dump.get(i, playerID, eDumpHP));
+        simGuys[playerID]->setFocus(dump.get(i, playerID, eDumpDriveGauge, maxFocus));
         simGuys[playerID]->setFocusRegenCooldown(-1);
-        simGuys[playerID]->setGauge(playerJson.value("superGauge", simGuys[playerID]->getCharData()->gauge));
+        simGuys[playerID]->setGauge(dump.get(i, playerID, eDumpSuperGauge, simGuys[playerID]->getCharData()->gauge));
         playerID++;
     }
 
     gameStateFrame = i;
     gameStateStartFrame = i;
 
-    if (gameStateDump[i].contains("stageTimer")) {
-        frameCounter = gameStateDump[i]["stageTimer"];
+    if (dump.has(eDumpStageTimer)) {
+        frameCounter = dump.get(i, eDumpStageTimer);
     }
-    if (gameStateDump[i].contains("randomL")) {
-        randomSeed = gameStateDump[i]["randomL"];
+    if (dump.has(eDumpRandomL)) {
+        randomSeed = dump.get(i, eDumpRandomL);
     }
 
     replayingGameStateDump = true;
@@ -241,18 +427,18 @@ bool Simulation::SetupFromGameDump(std::string dumpPath, int version)
     return true;
 }
 
-void Simulation::SetupReplayRound(nlohmann::json &replayInfo, int round, int version, ReplayDecoder &decoder, const Simulation *prevRoundEnd)
+void Simulation::SetupReplayRound(const nlohmann::json &replayInfo, int round, int version, ReplayDecoder &decoder, const Simulation *prevRoundEnd)
 {
     for (int i = 0; i < 2; i++) {
-        int fighterID = replayInfo["Fighters"][i]["FighterID"];
+        int fighterID = replayInfo.at("Fighters").at(i).at("FighterID");
         const char *charName = getCharNameFromID(fighterID);
         Fixed startX = (i == 0) ? Fixed(-150.0f) : Fixed(150.0f);
         int startDir = (i == 0) ? 1 : -1;
         CreateGuy(charName, version, startX, Fixed(0), startDir, {0.5f, 0.5f, 0.5f});
     }
 
-    nlohmann::json &roundInfo = replayInfo["RoundInfo"][round];
-    randomSeed = roundInfo["RandomSeed"];
+    const nlohmann::json &roundInfo = replayInfo.at("RoundInfo").at(round);
+    randomSeed = roundInfo.at("RandomSeed");
 
     if (prevRoundEnd) {
         for (int p = 0; p < 2; p++) {
@@ -267,13 +453,13 @@ void Simulation::SetupReplayRound(nlohmann::json &replayInfo, int round, int ver
             simGuys[p]->setGauge(0);
         }
     } else {
-        nlohmann::json &prevRoundInfo = replayInfo["RoundInfo"][round - 1];
+        const nlohmann::json &prevRoundInfo = replayInfo.at("RoundInfo").at(round - 1);
         for (int p = 0; p < 2; p++) {
-            simGuys[p]->setGauge(prevRoundInfo["SAGaugeStart"][p]);
+            simGuys[p]->setGauge(prevRoundInfo.at("SAGaugeStart").at(p));
             if (simGuys[p]->getCharData()->flags & (1<<6)) {
-                simGuys[p]->getUniqueParam(0) = prevRoundInfo["UniqueParam"][p];
+                simGuys[p]->getUniqueParam(0) = prevRoundInfo.at("UniqueParam").at(p);
             }
-            simGuys[p]->ChangeStyle(prevRoundInfo["StyleNo"][p]);
+            simGuys[p]->ChangeStyle(prevRoundInfo.at("StyleNo").at(p));
         }
     }
 
@@ -290,31 +476,43 @@ void Simulation::SetupReplayRound(nlohmann::json &replayInfo, int round, int ver
     replayingReplay = true;
 }
 
-void Simulation::CompareGameStateFixed( Fixed dumpValue, Fixed realValue, int player, int frame, ErrorType errorType, std::string description )
+static std::string describeGameStateError(int player, int frame, Simulation::ErrorType errorType, const char *description)
 {
-    if (dumpValue != realValue)
-    {
-        float valueDiff = realValue.f() - dumpValue.f();
-        int64_t valueDiffData = realValue.data - dumpValue.data;
-        std::string dumpValueStr = std::to_string(dumpValue.data) + " / " + std::to_string(dumpValue.f());
-        std::string simValueStr = std::to_string(realValue.data) + " / " + std::to_string(realValue.f());
-        std::string diffStr = std::to_string(valueDiffData) + " / " + std::to_string(valueDiff);
-        std::string headerStr = "E;" + std::to_string(player) + ";" + std::to_string(frame) + ";" + std::to_string(errorType) + ";";
-        Log(headerStr + description + " dump: " + dumpValueStr + " sim: " + simValueStr + " diff: " + diffStr);
-
-        replayErrors++;
+    std::string headerStr = "E;" + std::to_string(player) + ";" + std::to_string(frame) + ";" + std::to_string(errorType) + ";";
+    // the random seed is the only sim-wide field
+    if (errorType == Simulation::eRandomSeed) {
+        return headerStr + description;
     }
+    return headerStr + "player " + std::to_string(player) + " " + description;
 }
 
-void Simulation::CompareGameStateInt( int64_t dumpValue, int64_t realValue, int player, int frame, ErrorType errorType, std::string description )
+void Simulation::ReportGameStateFixedError( int64_t dumpValueData, Fixed realValue, int player, int frame, ErrorType errorType, const char *description )
 {
-    if (dumpValue != realValue)
-    {
-        std::string headerStr = "E;" + std::to_string(player) + ";" + std::to_string(frame) + ";" + std::to_string(errorType) + ";";
-        Log(headerStr + description + " dump: " + std::to_string(dumpValue) + " sim: " + std::to_string(realValue));
+    Fixed dumpValue;
+    dumpValue.data = dumpValueData;
+    float valueDiff = realValue.f() - dumpValue.f();
+    int64_t valueDiffData = realValue.data - dumpValue.data;
+    replayErrors++;
+    if (onGameStateError) {
+        onGameStateError({player, frame, errorType});
+        return;
+    }
+
+    std::string dumpValueStr = std::to_string(dumpValue.data) + " / " + std::to_string(dumpValue.f());
+    std::string simValueStr = std::to_string(realValue.data) + " / " + std::to_string(realValue.f());
+    std::string diffStr = std::to_string(valueDiffData) + " / " + std::to_string(valueDiff);
+    Log(describeGameStateError(player, frame, errorType, description) + " dump: " + dumpValueStr + " sim: " + simValueStr + " diff: " + diffStr);
+}
 
-        replayErrors++;
+void Simulation::ReportGameStateIntError( int64_t dumpValue, int64_t realValue, int player, int frame, ErrorType errorType, const char *description )
+{
+    replayErrors++;
+    if (onGameStateError) {
+        onGameStateError({player, frame, errorType});
+        return;
     }
+
+    Log(describeGameStateError(player, frame, errorType, description) + " dump: " + std::to_string(dumpValue) + " sim: " + std::to_string(realValue));
 }
 
 void Simulation::Log(std::string logLine)
@@ -337,35 +535,55 @@ void Simulation::RunFrame(void) {
     }
     vecGuysToDelete.clear();
 
+    profile.frames++;
+
     gatherEveryone();
 
-    for (auto guy : everyone) {
-        guy->RunFrame();
+    {
+        PROFILE_PHASE(profile, eProfileRunFrame);
+        for (auto guy : everyone) {
+            guy->RunFrame();
+        }
     }
 
     // gather everyone again in case of deletions/additions in RunFrame
     gatherEveryone();
 
-    for (auto guy : everyone) {
-        guy->WorldPhysics();
+    {
+        PROFILE_PHASE(profile, eProfileWorldPhysics);
+        for (auto guy : everyone) {
+            guy->WorldPhysics();
+        }
     }
-    for (auto guy : everyone) {
-        guy->Push(guy->getOpponent());
+    {
+        PROFILE_PHASE(profile, eProfilePush);
+        for (auto guy : everyone) {
+            guy->Push(guy->getOpponent());
+        }
     }
-    for (auto guy : everyone) {
-        guy->RunFramePostPush();
+    {
+        PROFILE_PHASE(profile, eProfileRunFramePostPush);
+        for (auto guy : everyone) {
+            guy->RunFramePostPush();
+        }
     }
 
     // gather everyone again in case of deletions/additions in RunFramePostPush
     gatherEveryone();
 
-    std::vector<PendingHit> pendingHitList;
+    FrameVector<PendingHit> pendingHitList(&frameArena);
 
-    for (auto guy : everyone) {
-        guy->CheckHit(guy->getOpponent(), pendingHitList);
+    {
+        PROFILE_PHASE(profile, eProfileCheckHit);
+        for (auto guy : everyone) {
+            guy->CheckHit(guy->getOpponent(), pendingHitList);
+        }
     }
 
-    ResolveHits(this, pendingHitList);
+    {
+        PROFILE_PHASE(profile, eProfileResolveHits);
+        ResolveHits(this, pendingHitList);
+    }
 
     // hits can make guys too
     gatherEveryone();
@@ -376,12 +594,13 @@ void Simulation::RunFrame(void) {
         if (dumpCompareFirstFrame) {
             dumpCompareFirstFrame = false;
         } else {
-            nlohmann::json &players = gameStateDump[targetDumpFrame]["players"];
+            GameDump &dump = gameStateDump;
+            const DumpFrame &dumpFrame = dumpFrames[targetDumpFrame];
             int i = 0;
             while (i < 2) {
-                std::string desc = "player " + std::to_string(i);
+                const DumpPlayerFrame &dumpPlayer = dumpFrame.players[i];
 
-                if (!finished && players[i]["hp"] == 0 && players[i]["hp"] == simGuys[i]->getHealth()) {
+                if (!finished && dumpPlayer.hp == 0 && dumpPlayer.hp == simGuys[i]->getHealth()) {
                     finished = true;
                 }
 
@@ -391,101 +610,94 @@ void Simulation::RunFrame(void) {
 
                 // some tests have a first frame from before state reset?
                 if (targetDumpFrame > 1) {
-                    CompareGameStateFixed(Fixed(players[i]["posX"].get<double>()), simGuys[i]->getPosX(), i, targetDumpFrame, ePos, desc + " pos X");
-                    CompareGameStateFixed(Fixed(players[i]["posY"].get<double>()), simGuys[i]->getPosY(), i, targetDumpFrame, ePos, desc + " pos Y");
+                    CompareGameStateFixed(dumpPlayer.posX, simGuys[i]->getPosX(), i, targetDumpFrame, ePos, "pos X");
+                    CompareGameStateFixed(dumpPlayer.posY, simGuys[i]->getPosY(), i, targetDumpFrame, ePos, "pos Y");
                 }
                 Fixed velX, velY, accelX, accelY;
                 simGuys[i]->getVel(velX, velY, accelX, accelY);
-                CompareGameStateFixed(Fixed(players[i]["velX"].get<double>()), velX, i, targetDumpFrame, eVel, desc + " vel X");
-                CompareGameStateFixed(Fixed(players[i]["velY"].get<double>()), velY, i, targetDumpFrame, eVel, desc + " vel Y");
-                if (players[i].contains("accelX")) {
-                    CompareGameStateFixed(Fixed(players[i]["accelX"].get<double>()), accelX, i, targetDumpFrame, eAccel, desc + " accel X");
+                CompareGameStateFixed(dumpPlayer.velX, velX, i, targetDumpFrame, eVel, "vel X");
+                CompareGameStateFixed(dumpPlayer.velY, velY, i, targetDumpFrame, eVel, "vel Y");
+                if (dump.has(i, eDumpAccelX)) {
+                    CompareGameStateFixed(dumpPlayer.accelX, accelX, i, targetDumpFrame, eAccel, "accel X");
                 }
-                CompareGameStateFixed(Fixed(players[i]["accelY"].get<double>()), accelY, i, targetDumpFrame, eAccel, desc + " accel Y");
+                CompareGameStateFixed(dumpPlayer.accelY, accelY, i, targetDumpFrame, eAccel, "accel Y");
 
-                if (players[i].contains("hitVelX")) {
-                    CompareGameStateFixed(Fixed(players[i]["hitVelX"].get<double>()), simGuys[i]->getHitVelX(), i, targetDumpFrame, eHitVel, desc + " hitAccel X");
-                    CompareGameStateFixed(Fixed(players[i]["hitAccelX"].get<double>()), simGuys[i]->getHitAccelX(), i, targetDumpFrame, eHitAccel, desc + " hitAccel X");
+                if (dump.has(i, eDumpHitVelX)) {
+                    CompareGameStateFixed(dumpPlayer.hitVelX, simGuys[i]->getHitVelX(), i, targetDumpFrame, eHitVel, "hitAccel X");
+                    CompareGameStateFixed(dumpPlayer.hitAccelX, simGuys[i]->getHitAccelX(), i, targetDumpFrame, eHitAccel, "hitAccel X");
                 }
 
-                CompareGameStateInt(players[i]["actionID"], simGuys[i]->getCurrentAction(), i, targetDumpFrame, eActionID, desc + " action ID");
-                CompareGameStateInt(players[i]["actionFrame"], simGuys[i]->getCurrentFrame(), i, targetDumpFrame, eActionFrame, desc + " action frame");
+                CompareGameStateInt(dumpPlayer.actionID, simGuys[i]->getCurrentAction(), i, targetDumpFrame, eActionID, "action ID");
+                CompareGameStateInt(dumpPlayer.actionFrame, simGuys[i]->getCurrentFrame(), i, targetDumpFrame, eActionFrame, "action frame");
 
                 // swap players here, we track combo hits on the opponent
-                CompareGameStateInt(players[i]["comboCount"], simGuys[!i]->getComboHits(), i, targetDumpFrame, eComboCount, desc + " combo");
+                CompareGameStateInt(dumpPlayer.comboCount, simGuys[!i]->getComboHits(), i, targetDumpFrame, eComboCount, "combo");
 
-                CompareGameStateInt((players[i]["bitValue"].get<int>() & (1<<7)) ? 1 : -1, simGuys[i]->getDirection(), i, targetDumpFrame, eDirection, desc + " direction");
+                CompareGameStateInt(dumpPlayer.direction, simGuys[i]->getDirection(), i, targetDumpFrame, eDirection, "direction");
 
-                if (targetDumpFrame > 0) {
-                    nlohmann::json &prevPlayers = gameStateDump[targetDumpFrame-1]["players"];
-                    nlohmann::json &firstPlayers = gameStateDump[0]["players"];
-                    if (!match && detectTrainingAutoRegen(prevPlayers[i], players[i], firstPlayers[i], "hp", simGuys[i]->getCharData()->vitality)) {
-                        simGuys[i]->setHealth(players[i]["hp"]);
+                if (targetDumpFrame > 0 && !match) {
+                    const DumpPlayerFrame &prevPlayer = dumpFrames[targetDumpFrame-1].players[i];
+                    const DumpPlayerFrame &firstPlayer = dumpFrames[0].players[i];
+                    if (dump.has(i, eDumpHP) && detectTrainingAutoRegen(prevPlayer.hp, dumpPlayer.hp, firstPlayer.hp, simGuys[i]->getCharData()->vitality)) {
+                        simGuys[i]->setHealth(dumpPlayer.hp);
                     }
-                    if (!match && detectTrainingAutoRegen(prevPlayers[i], players[i], firstPlayers[i], "driveGauge", maxFocus)) {
-                        simGuys[i]->guyLog(simGuys[i]->getLogResources(), "focus training refill detected, focus to " + std::to_string(players[i]["driveGauge"].get<int>()) + " was " + std::to_string(simGuys[i]->getFocus()));
-                        simGuys[i]->setFocus(players[i]["driveGauge"]);
+                    if (dump.has(i, eDumpDriveGauge) && detectTrainingAutoRegen(prevPlayer.driveGauge, dumpPlayer.driveGauge, firstPlayer.driveGauge, maxFocus)) {
+                        simGuys[i]->guyLog(simGuys[i]->getLogResources(), "focus training refill detected, focus to " + std::to_string(dumpPlayer.driveGauge) + " was " + std::to_string(simGuys[i]->getFocus()));
+                        simGuys[i]->setFocus(dumpPlayer.driveGauge);
                         simGuys[i]->setFocusRegenCooldown(-1);
                     }
-                    if (!match && detectTrainingAutoRegen(prevPlayers[i], players[i], firstPlayers[i], "superGauge", simGuys[i]->getCharData()->gauge)) {
-                        simGuys[i]->setGauge(players[i]["superGauge"]);
+                    if (dump.has(i, eDumpSuperGauge) && detectTrainingAutoRegen(prevPlayer.superGauge, dumpPlayer.superGauge, firstPlayer.superGauge, simGuys[i]->getCharData()->gauge)) {
+                        simGuys[i]->setGauge(dumpPlayer.superGauge);
                     }
                 }
 
-                CompareGameStateInt(players[i]["hp"], simGuys[i]->getHealth(), i, targetDumpFrame, eHealth, desc + " health");
-                CompareGameStateInt(players[i]["hitStop"], simGuys[i]->getHitStopForDump(), i, targetDumpFrame, eHitStop, desc + " hitstop");
-
-                if (players[i].contains("driveGauge")) {
-                    CompareGameStateInt(players[i]["driveGauge"], simGuys[i]->getFocus(), i, targetDumpFrame, eGauge, desc + " drive gauge");
-                    // if (targetDumpFrame < 240 && (targetDumpFrame + 1) < (int)gameStateDump.size()) {
-                    //     nlohmann::json &nextPlayers = gameStateDump[targetDumpFrame+1]["players"];
-                    //     int driveDiff = nextPlayers[i]["driveGauge"].get<int>() - players[i]["driveGauge"].get<int>();
-                    //     if (driveDiff == 40 || driveDiff == 50 || driveDiff == 20 || driveDiff == 25 || driveDiff == 60 || driveDiff == 70) {
-                    //         if (!simGuys[i]->getHasFocusRegenCooldowned()) {
-                    //             simGuys[i]->setFocusRegenCooldown(1); // start regenning next frame
-                    //         }
-                    //     }
-                    // }
+                CompareGameStateInt(dumpPlayer.hp, simGuys[i]->getHealth(), i, targetDumpFrame, eHealth, "health");
+                CompareGameStateInt(dumpPlayer.hitStop, simGuys[i]->getHitStopForDump(), i, targetDumpFrame, eHitStop, "hitstop");
+
+                if (dump.has(i, eDumpDriveGauge)) {
+                    CompareGameStateInt(dumpPlayer.driveGauge, simGuys[i]->getFocus(), i, targetDumpFrame, eGauge, "drive gauge");
                 }
-                if (players[i].contains("superGauge")) {
-                    CompareGameStateInt(players[i]["superGauge"], simGuys[i]->getGauge(), i, targetDumpFrame, eGauge, desc + " super gauge");
+                if (dump.has(i, eDumpSuperGauge)) {
+                    CompareGameStateInt(dumpPlayer.superGauge, simGuys[i]->getGauge(), i, targetDumpFrame, eGauge, "super gauge");
                 }
 
-                if (gameMode == Viewer && players[i].contains("driveCooldown")) {
-                    CompareGameStateInt(players[i]["driveCooldown"], simGuys[i]->getFocusRegenCoolDown(), i, targetDumpFrame, eFocusRegen, desc + " drive cooldown");
+                if (gameMode == Viewer && dump.has(i, eDumpDriveCooldown)) {
+                    CompareGameStateInt(dumpPlayer.driveCooldown, simGuys[i]->getFocusRegenCoolDown(), i, targetDumpFrame, eFocusRegen, "drive cooldown");
                 }
 
                 i++;
             }
 
-            if (gameMode == Viewer && gameStateDump[targetDumpFrame].contains("randomL")) {
-                CompareGameStateInt(gameStateDump[targetDumpFrame]["randomL"], randomSeed, 0, targetDumpFrame, eRandomSeed, "random seed");
+            if (gameMode == Viewer && dump.has(eDumpRandomL)) {
+                CompareGameStateInt(dumpFrame.randomL, randomSeed, 0, targetDumpFrame, eRandomSeed, "random seed");
             }
 
             gameStateFrame++;
             targetDumpFrame++;
         }
 
-        if (targetDumpFrame >= (int)gameStateDump.size()) {
+        if (targetDumpFrame >= gameStateDump.frameCount) {
             replayingGameStateDump = false;
             gameStateFrame = 0;
             frameCounter = 0;
             Log("F;game replay finished, errors: " + std::to_string(replayErrors));
         } else {
-            int inputLeft = gameStateDump[targetDumpFrame]["players"][0]["currentInput"];
+            GameDump &dump = gameStateDump;
+            const DumpFrame &dumpFrame = dumpFrames[targetDumpFrame];
+            int inputLeft = dumpFrame.players[0].currentInput;
             int prevInputLeft = 0;
             if (targetDumpFrame > 0) {
-                prevInputLeft = gameStateDump[targetDumpFrame-1]["players"][0]["currentInput"];
+                prevInputLeft = dumpFrames[targetDumpFrame-1].players[0].currentInput;
             }
             inputLeft = addPressBits( inputLeft, prevInputLeft );
 
             int inputRight = 0;
             // training dumps don't have input for player 2
-            if (gameStateDump[targetDumpFrame]["players"][1].contains("currentInput")) {
-                inputRight = gameStateDump[targetDumpFrame]["players"][1]["currentInput"];
+            if (dump.has(1, eDumpCurrentInput)) {
+                inputRight = dumpFrame.players[1].currentInput;
                 int prevInputRight = 0;
                 if (targetDumpFrame > 0) {
-                    prevInputRight = gameStateDump[targetDumpFrame-1]["players"][1]["currentInput"];
+                    prevInputRight = dumpFrames[targetDumpFrame-1].players[1].currentInput;
                 }
                 inputRight = addPressBits( inputRight, prevInputRight );
             }
@@ -493,12 +705,12 @@ void Simulation::RunFrame(void) {
             simGuys[0]->Input(inputLeft);
             simGuys[1]->Input(inputRight);
 
-            if (gameStateDump[targetDumpFrame].contains("stageTimer")) {
-                frameCounter = gameStateDump[targetDumpFrame]["stageTimer"];
+            if (dump.has(eDumpStageTimer)) {
+                frameCounter = dumpFrame.stageTimer;
             }
 
-            int playTimerSeconds = gameStateDump[targetDumpFrame].value("playTimer", 99);
-            int playTimerFrames = gameStateDump[targetDumpFrame].value("playTimerMS", 60);
+            int playTimerSeconds = dumpFrame.playTimer;
+            int playTimerFrames = dumpFrame.playTimerMS;
 
             if (match && (playTimerSeconds != 99 || (playTimerFrames != 60 && playTimerFrames != 59))) {
                 timerStarted = true;
@@ -507,23 +719,13 @@ void Simulation::RunFrame(void) {
     }
 
     if (replayingReplay) {
-        uint8_t cmd;
-        do {
-            cmd = pReplayDecoder->DecodeTick();
-            if (cmd >= 1 && cmd <= 8) {
-                if (cmd == 1) {
-                    replayTimerStartFrame = frameCounter + 190;
-                    pReplayDecoder->inputState[0] = 0;
-                    pReplayDecoder->inputState[1] = 0;
-                    pReplayDecoder->prevInputState[0] = 0;
-                    pReplayDecoder->prevInputState[1] = 0;
-                }
-                if (cmd == 3) {
-                    replayingReplay = false;
-                    break;
-                }
-            }
-        } while (cmd >= 1 && cmd <= 8 && !pReplayDecoder->finished);
+        uint32_t cmds = pReplayDecoder->DecodeFrame();
+        if (cmds & ReplayDecoder::timerStartCommand) {
+            replayTimerStartFrame = frameCounter + 190;
+        }
+        if (cmds & ReplayDecoder::roundEndCommand) {
+            replayingReplay = false;
+        }
 
         if (replayTimerStartFrame >= 0 && frameCounter >= replayTimerStartFrame) {
             timerStarted = true;
@@ -531,11 +733,8 @@ void Simulation::RunFrame(void) {
         }
 
         if (replayingReplay && !pReplayDecoder->finished) {
-            int inputLeft = addPressBits(pReplayDecoder->inputState[0], pReplayDecoder->prevInputState[0]);
-            int inputRight = addPressBits(pReplayDecoder->inputState[1], pReplayDecoder->prevInputState[1]);
-
-            pReplayDecoder->prevInputState[0] = pReplayDecoder->inputState[0];
-            pReplayDecoder->prevInputState[1] = pReplayDecoder->inputState[1];
+            int inputLeft, inputRight;
+            pReplayDecoder->TakeInputs(inputLeft, inputRight);
 
             simGuys[0]->Input(inputLeft);
             simGuys[1]->Input(inputRight);
@@ -549,6 +748,8 @@ void Simulation::RunFrame(void) {
 
 void Simulation::AdvanceFrame(void)
 {
+    PROFILE_PHASE(profile, eProfileAdvanceFrame);
+
     for (auto guy : everyone) {
         bool die = !guy->AdvanceFrame();
 
@@ -558,6 +759,8 @@ void Simulation::AdvanceFrame(void)
             vecGuysToDelete.push_back(guy);
         }
     }
+
+    frameArena.Reset();
 }
 
 int Simulation::GetRandom(void)
@@ -569,15 +772,6 @@ int Simulation::GetRandom(void)
     return (((randomSeed << 9) | (randomSeed >> 7)) & 0xFFFF) % 100;
 }
 
-void Simulation::Render(float z /* = 0.0 */, bool showDomain)
-{
-    std::vector<Guy *> everyoneRender;
-    gatherEveryone(&everyoneRender, false);
-    for (auto guy : everyoneRender) {
-        guy->Render(z, showDomain);
-    }
-}
-
 uint8_t ReplayDecoder::DecodeTick()
 {
     if (pos >= (int)inputData.size()) {
@@ -626,3 +820,34 @@ uint8_t ReplayDecoder::DecodeTick()
 
     return 0;
 }
+
+uint32_t ReplayDecoder::DecodeFrame()
+{
+    uint32_t cmds = 0;
+    uint8_t cmd;
+    do {
+        cmd = DecodeTick();
+        if (cmd >= 1 && cmd <= 8) {
+            cmds |= 1 << cmd;
+            if (cmd == 1) {
+                inputState[0] = 0;
+                inputState[1] = 0;
+                prevInputState[0] = 0;
+                prevInputState[1] = 0;
+            }
+            if (cmd == 3) {
+                break;
+            }
+        }
+    } while (cmd >= 1 && cmd <= 8 && !finished);
+    return cmds;
+}
+
+void ReplayDecoder::TakeInputs(int &inputLeft, int &inputRight)
+{
+    inputLeft = addPressBits(inputState[0], prevInputState[0]);
+    inputRight = addPressBits(inputState[1], prevInputState[1]);
+
+    prevInputState[0] = inputState[0];
+    prevInputState[1] = inputState[1];
+}
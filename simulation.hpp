@@ -1,23 +1,69 @@
 #pragma once
 
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "fixed.hpp"
+#include "framearena.hpp"
+#include "gamedump.hpp"
 #include "main.hpp"
+#include "profile.hpp"
 
-inline bool detectTrainingAutoRegen(nlohmann::json &prevPlayer, nlohmann::json &curPlayer, nlohmann::json &firstPlayer, const char *field, int maxValue)
+inline bool detectTrainingAutoRegen(int prev, int cur, int first, int maxValue)
 {
-    if (!curPlayer.contains(field)) {
-        return false;
-    }
-    int prev = prevPlayer[field];
-    int cur = curPlayer[field];
-    int first = firstPlayer[field];
     return prev != cur && (cur == maxValue || cur == first);
 }
 
 class CharacterUIController;
+struct CharacterData;
+struct GuySlot;
+
+// byte stream for Simulation::SaveState/LoadState - guy state goes in as raw
+// bytes so a blob only loads in the same build on the same architecture
+struct StateBlob {
+    std::vector<uint8_t> data;
+    size_t readPos = 0;
+    bool overrun = false;
+
+    void writeBytes(const void *pSrc, size_t size) {
+        const uint8_t *pBytes = (const uint8_t *)pSrc;
+        data.insert(data.end(), pBytes, pBytes + size);
+    }
+    bool readBytes(void *pDst, size_t size) {
+        if (overrun || readPos + size > data.size()) {
+            overrun = true;
+            return false;
+        }
+        memcpy(pDst, data.data() + readPos, size);
+        readPos += size;
+        return true;
+    }
+    template<typename T>
+    void write(const T &value) { writeBytes(&value, sizeof(T)); }
+    template<typename T>
+    T read() {
+        T value{};
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+    void writeString(const std::string &str) {
+        write<uint32_t>(str.size());
+        writeBytes(str.data(), str.size());
+    }
+    std::string readString() {
+        uint32_t size = read<uint32_t>();
+        if (overrun || readPos + size > data.size()) {
+            overrun = true;
+            return "";
+        }
+        std::string ret((const char *)data.data() + readPos, size);
+        readPos += size;
+        return ret;
+    }
+};
 
 struct ReplayDecoder {
     std::vector<uint8_t> inputData;
@@ -26,7 +72,16 @@ struct ReplayDecoder {
     int prevInputState[2] = {0, 0};
     bool finished = false;
 
+    // control commands DecodeFrame reports, as 1 << cmd
+    static const uint32_t timerStartCommand = 1 << 1;
+    static const uint32_t roundEndCommand = 1 << 3;
+
     uint8_t DecodeTick();
+    // ticks up to the next frame of input, or the end of the round. only
+    // depends on the stream, so rounds can be found without simulating them
+    uint32_t DecodeFrame();
+    // this frame's input with press bits, and it becomes the previous frame's
+    void TakeInputs(int &inputLeft, int &inputRight);
 };
 
 struct FrameEvent {
@@ -57,11 +112,17 @@ public:
     void gatherEveryone(std::vector<Guy*> *vecOutEveryone = nullptr, bool simulationOrder = true);
     void Clone(Simulation *pOtherSim);
     void CreateGuy(std::string charName, int charVersion, Fixed x, Fixed y, int startDir, color color);
-    void CreateGuyFromDumpedPlayer(nlohmann::json &playerJson, int version);
+    void CreateGuyFromDumpedPlayer(int dumpFrame, int player, int version);
     void CreateGuyFromCharController(CharacterUIController &controller);
+    CharacterData *AcquireCharacterData(const std::string &charName, int charVersion);
+
+    // storage behind Guy's operator new/delete - slots never move or get freed
+    // before the sim is, and a clone mirrors them index for index
+    void *AllocGuySlot();
+    static void FreeGuySlot(void *pStorage);
 
     bool SetupFromGameDump(std::string dumpPath, int version);
-    void SetupReplayRound(nlohmann::json &replayInfo, int round, int version, ReplayDecoder &decoder, const Simulation *prevRoundEnd = nullptr);
+    void SetupReplayRound(const nlohmann::json &replayInfo, int round, int version, ReplayDecoder &decoder, const Simulation *prevRoundEnd = nullptr);
 
     enum ErrorType {
         ePos = 0,
@@ -80,21 +141,59 @@ public:
         eRandomSeed
     };
 
-    void CompareGameStateFixed( Fixed dumpValue, Fixed realValue, int player, int frame, ErrorType errorType, std::string description );
-    void CompareGameStateInt( int64_t dumpValue, int64_t realValue, int player, int frame, ErrorType errorType, std::string description );
+    struct GameStateError {
+        int player;
+        int frame;
+        ErrorType type;
+    };
+
+    // cheap enough to run on every field every frame, the description only
+    // gets turned into a string once there's an error to report
+    inline void CompareGameStateFixed( int64_t dumpValue, Fixed realValue, int player, int frame, ErrorType errorType, const char *description ) {
+        if (dumpValue != realValue.data) {
+            ReportGameStateFixedError(dumpValue, realValue, player, frame, errorType, description);
+        }
+    }
+    inline void CompareGameStateInt( int64_t dumpValue, int64_t realValue, int player, int frame, ErrorType errorType, const char *description ) {
+        if (dumpValue != realValue) {
+            ReportGameStateIntError(dumpValue, realValue, player, frame, errorType, description);
+        }
+    }
+    void ReportGameStateFixedError( int64_t dumpValue, Fixed realValue, int player, int frame, ErrorType errorType, const char *description );
+    void ReportGameStateIntError( int64_t dumpValue, int64_t realValue, int player, int frame, ErrorType errorType, const char *description );
 
     void Log(std::string logLine);
 
+    // everything needed to keep simulating from this exact frame - the dump
+    // being replayed isn't included, load it into the sim before LoadState
+    // if the checkpoint was taken during a dump replay, and pass the replay's
+    // decoder when it was taken during a replay. a detached load is only for
+    // looking at, it needs neither and the sim isn't replaying anything after
+    void SaveState(StateBlob &blob);
+    bool LoadState(StateBlob &blob, ReplayDecoder *pDecoder = nullptr, bool detached = false);
+
     void RunFrame();
     void AdvanceFrame();
     int GetRandom();
     void Render(float a = 1.0f, bool showDomain = true);
     std::vector<FrameEvent>& getCurrentFrameEvents() { return currentFrameEvents; }
 
+    // everyone is only rebuilt when the roster changed or the order flipped
+    // since the last gather - whatever adds or removes guys or minions needs
+    // to call this
+    void markRosterDirty() { rosterDirty = true; }
+
+    std::vector<GuySlot *> guySlots;
+    std::vector<uint32_t> freeGuySlots;
+
     std::vector<Guy *> everyone;
+    bool rosterDirty = true;
+    bool rosterFilterOdd = false;
     int guyIDCounter = 0;
     std::vector<Guy *> simGuys;
     std::vector<Guy *> vecGuysToDelete;
+    // keeps the shared char data alive as long as any guy of ours can point at it
+    std::vector<std::shared_ptr<CharacterData>> charDataRefs;
 
     int frameCounter = 0;
     int randomSeed = 0;
@@ -113,7 +212,8 @@ public:
 
     bool replayingGameStateDump = false;
     bool dumpCompareFirstFrame = true;
-    nlohmann::json gameStateDump;
+    GameDump gameStateDump;
+    std::vector<DumpFrame> dumpFrames;
     int gameStateFrame = 0;
     int gameStateStartFrame = 0;
     int replayErrors = 0;
@@ -124,10 +224,16 @@ public:
 
     std::vector<FrameEvent> currentFrameEvents;
     std::vector<std::string> errorLog;
+    // set to get dump errors as they happen instead of E; lines on stderr
+    std::function<void(const GameStateError &)> onGameStateError;
+
+    // on top of the viewer's global toggles, so parallel sims (like a dump
+    // named forcepc) don't leak into each other
+    bool forceCounter = false;
+    bool forcePunishCounter = false;
+    // scratch for the current frame, rewound at the end of AdvanceFrame
+    FrameArena frameArena;
+    // only counts in profile builds, see profile.hpp
+    SimProfile profile;
     bool enableCleanup = true;
 };
-
-struct RecordedFrame {
-    Simulation sim;
-    std::vector<FrameEvent> events;
-};
@@ -5,9 +5,6 @@ import subprocess
 import json
 import sys
 from datetime import datetime
-import concurrent.futures
-import multiprocessing
-import time
 
 scriptPath = os.path.abspath(__file__)
 scriptDir = os.path.dirname(scriptPath)
@@ -32,6 +29,10 @@ for root, dirs, files in os.walk(testDir):
             newTest['name'] = file.split('.')[0]
             newTest['filePath'] = os.path.join(root, file)
             newTest['charVersion'] = os.path.basename(root)
+            # use the binary dump from convert_dump when it's up to date
+            binaryPath = os.path.join(root, newTest['name'] + ".pdump")
+            if os.path.isfile(binaryPath) and os.path.getmtime(binaryPath) >= os.path.getmtime(newTest['filePath']):
+                newTest['filePath'] = binaryPath
             tests.append(newTest)
 
 testsUpToDate = True
@@ -57,82 +58,20 @@ if testsUpToDate:
     print("tests up to date! (--force to override)")
     exit(0)
 
-testResults = []
-
-def runTest(test):
-    testPath = test['filePath']
-    charVersion = test['charVersion']
-    print('.',end='')
-    sys.stdout.flush()
-    result = subprocess.run([psychodrivePath, 'run_dump', testPath, charVersion], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
-    newTestResult = {}
-    newTestResult['testName'] = test['name']
-    newTestResult['testVersion'] = charVersion
-    newTestResult['finished'] = False
-    newTestResult['errorTypes'] = []
-    while 12 > len(newTestResult['errorTypes']):
-        emptyErrorType = {}
-        emptyErrorType['count'] = 0
-        emptyErrorType['firstFrame'] = -1
-        emptyErrorType['lastFrame'] = -1
-        newTestResult['errorTypes'].append(emptyErrorType)
-
-    for line in result.stderr.splitlines():
-        errorLine = line.split(';')
-        if errorLine[0] == 'E':
-
-            errorType = int(errorLine[3])
-            while errorType + 1 > len(newTestResult['errorTypes']):
-                emptyErrorType = {}
-                emptyErrorType['count'] = 0
-                emptyErrorType['firstFrame'] = -1
-                emptyErrorType['lastFrame'] = -1
-                newTestResult['errorTypes'].append(emptyErrorType)
-
-            errorFrame = int(errorLine[2])
-            if newTestResult['errorTypes'][errorType]['firstFrame'] == -1:
-                newTestResult['errorTypes'][errorType]['firstFrame'] = errorFrame
-            newTestResult['errorTypes'][errorType]['lastFrame'] = errorFrame
-            newTestResult['errorTypes'][errorType]['count'] += 1
-        if errorLine[0] == 'F':
-            newTestResult['finished'] = True
-    return newTestResult
-
-numThreads = multiprocessing.cpu_count()
-executor = concurrent.futures.ThreadPoolExecutor(max_workers=numThreads)
-
-futures = []
-futuresNotDone = []
-
-print("running tests on", numThreads, "threads",end='')
+print("running", len(tests), "tests")
 sys.stdout.flush()
 
-for test in tests:
-    futures.append(executor.submit(runTest, test))
-
-while True:
-    for f in futures:
-        if f.done():
-            testResults.append(f.result())
-        else:
-            futuresNotDone.append(f)
-    futures = futuresNotDone
-    futuresNotDone = []
-    if len(futures) == 0:
-        break
-    time.sleep(0.1)
-
-print("\n")
-
-testResults = sorted(testResults, key=lambda x:x['testName'])
-
-with open(resultsPath, "w") as outFile:
-    outFile.write("var newResults =\n")
-    outFile.write(json.dumps(testResults, default=str, indent=4, ensure_ascii=False))
-    outFile.close()
+# one in-process run over the whole dump directory, it writes new_results.json itself
+result = subprocess.run([psychodrivePath, 'run_tests', testDir, resultsPath], stderr=subprocess.PIPE, text=True)
+if result.returncode != 0:
+    print(result.stderr)
+    exit(result.returncode)
 
 from history_utils import save_history, get_error_count, calculate_stats, parse_results_json
 
+with open(resultsPath, "r") as inFileNewResults:
+    testResults = parse_results_json(inFileNewResults.read())
+
 pendingPath = os.path.join(scriptDir, "test_history_pending.json")
 total_errors, total_frames = calculate_stats(testResults, testDir)
 
@@ -13,6 +13,8 @@
 #include "main.hpp"
 #include "input.hpp"
 #include "combogen.hpp"
+#include "render.hpp"
+#include "replay.hpp"
 
 #include <cstdlib>
 
@@ -63,6 +65,7 @@ ImGuiID curDropDownID = -1;
 
 SimulationController simController;
 bool simInputsChanged = true;
+int simInputsDirtyFrame = -1;
 
 extern "C" {
 
@@ -298,8 +301,15 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
     for (auto& i : vecInputLabels) {
         vecInputs.push_back(i.c_str());
     }
-    modalDropDown("input", pGuy->getInputListIDPtr(), vecInputs, 50);
-    *pGuy->getInputIDPtr() = atoi(vecInputLabels[*pGuy->getInputListIDPtr()].c_str());
+    int inputListID = *pGuy->getInputListIDPtr();
+    modalDropDown("input", &inputListID, vecInputs, 50);
+    int inputID = atoi(vecInputLabels[inputListID].c_str());
+    if (inputListID != *pGuy->getInputListIDPtr() || inputID != *pGuy->getInputIDPtr()) {
+        editTrainingGuy(pGuy, [inputListID, inputID](Guy *pEditGuy) {
+            *pEditGuy->getInputListIDPtr() = inputListID;
+            *pEditGuy->getInputIDPtr() = inputID;
+        });
+    }
 
     ImGui::SameLine();
     std::vector<std::string> vecGuyNames;
@@ -307,7 +317,7 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
     std::map<int, Guy *> mapDropDownIDToGuyPtr;
     mapDropDownIDToGuyPtr[0] = nullptr;
     int guyID = 1, newOpponentID = 0;
-    for (auto guy : pSim ? pSim->simGuys : guys) {
+    for (auto guy : pSim ? pSim->simGuys : trainingViewSim.simGuys) {
         if (guy == pGuy) {
             continue;
         }
@@ -328,7 +338,11 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
     newOpponentID = guyID;
     modalDropDown("opponent", &newOpponentID, vecInputs, 100);
     if (newOpponentID != guyID) {
-        pGuy->setOpponent(mapDropDownIDToGuyPtr[newOpponentID]);
+        GuyRef newOpponent(mapDropDownIDToGuyPtr[newOpponentID]);
+        editTrainingGuy(pGuy, [newOpponent](Guy *pEditGuy) mutable {
+            newOpponent.FixRef(guySlotOf(pEditGuy)->pSim);
+            pEditGuy->setOpponent(newOpponent.get());
+        });
     }
 
     float startPosX = pGuy->getStartPosX().f();
@@ -342,15 +356,21 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
     ImGui::InputText("##startpostext", startPosTest, sizeof(startPosTest));
     newStartPosX = atof(startPosTest);
     if (newStartPosX != startPosX) {
-        pGuy->setStartPosX(Fixed(newStartPosX, true));
+        editTrainingGuy(pGuy, [newStartPosX](Guy *pEditGuy) { pEditGuy->setStartPosX(Fixed(newStartPosX, true)); });
     }
-    ImGui::Text("action %i frame %i name %s input %d", pGuy->getCurrentAction(), pGuy->getCurrentFrame(), pGuy->getCurrentActionPtr()->name.c_str(), pGuy->getCurrentInput());
+    ImGui::Text("action %i frame %i name %s input %d", pGuy->getCurrentAction(), pGuy->getCurrentFrame(), pGuy->getCharData()->getActionNames(pGuy->getCurrentActionPtr()).name.c_str(), pGuy->getCurrentInput());
     if (!pGuy->getProjectile()) {
         const char* states[] = { "stand", "jump", "crouch", "not you", "block", "not you", "crouch block" };
-        modalDropDown("state", pGuy->getInputOverridePtr(), states, IM_ARRAYSIZE(states), 125);
+        int inputOverride = *pGuy->getInputOverridePtr();
+        if (modalDropDown("state", &inputOverride, states, IM_ARRAYSIZE(states), 125)) {
+            editTrainingGuy(pGuy, [inputOverride](Guy *pEditGuy) { *pEditGuy->getInputOverridePtr() = inputOverride; });
+        }
         ImGui::SameLine();
         std::vector<const char *> &vecMoveList = pGuy->getMoveList();
-        modalDropDown("recovery action", pGuy->getNeutralMovePtr(), vecMoveList, 300);
+        int neutralMove = *pGuy->getNeutralMovePtr();
+        if (modalDropDown("recovery action", &neutralMove, vecMoveList, 300)) {
+            editTrainingGuy(pGuy, [neutralMove](Guy *pEditGuy) { *pEditGuy->getNeutralMovePtr() = neutralMove; });
+        }
     }
     ImGui::Text("crouching %i airborne %i poseStatus %i landingAdjust %i", pGuy->getCrouchingDebug(), pGuy->getAirborneDebug(), pGuy->getforcedPoseStatus(), pGuy->getLandingAdjust());
     Fixed posX, posY, posOffsetX, posOffsetY, velX, velY, accelX, accelY;
@@ -360,11 +380,11 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
     ImGui::Text("vel %f %f %f accel %f %f %f", velX.f(), velY.f(), pGuy->getHitVelX().f(), accelX.f(), accelY.f(), pGuy->getHitAccelX().f());
     if ( !pGuy->getOpponent() ) {
         ImGui::SameLine();
-        if ( ImGui::Button("switch direction") ) { pGuy->switchDirection(); }
+        if ( ImGui::Button("switch direction") ) { editTrainingGuy(pGuy, [](Guy *pEditGuy) { pEditGuy->switchDirection(); }); }
     }
-    std::vector<HitBox> hitBoxes;
-    std::vector<Box> pushBoxes;
-    std::vector<HurtBox> hurtBoxes;
+    FrameVector<HitBox> hitBoxes;
+    FrameVector<Box> pushBoxes;
+    FrameVector<HurtBox> hurtBoxes;
     pGuy->getHitBoxes(&hitBoxes);
     pGuy->getPushBoxes(&pushBoxes);
     pGuy->getHurtBoxes(&hurtBoxes, nullptr);
@@ -403,37 +423,37 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
     bool logUnknowns = pGuy->getLogUnknowns();
     ImGui::Checkbox("unknowns", &logUnknowns);
     if (logUnknowns != pGuy->getLogUnknowns()) {
-        pGuy->setLogUnknowns(logUnknowns);
+        editTrainingGuy(pGuy, [logUnknowns](Guy *pEditGuy) { pEditGuy->setLogUnknowns(logUnknowns); });
     }
     ImGui::SameLine();
     bool logHits = pGuy->getLogHits();
     ImGui::Checkbox("hits", &logHits);
     if (logHits != pGuy->getLogHits()) {
-        pGuy->setLogHits(logHits);
+        editTrainingGuy(pGuy, [logHits](Guy *pEditGuy) { pEditGuy->setLogHits(logHits); });
     }
     ImGui::SameLine();
     bool logTriggers = pGuy->getLogTriggers();
     ImGui::Checkbox("triggers", &logTriggers);
     if (logTriggers != pGuy->getLogTriggers()) {
-        pGuy->setLogTriggers(logTriggers);
+        editTrainingGuy(pGuy, [logTriggers](Guy *pEditGuy) { pEditGuy->setLogTriggers(logTriggers); });
     }
     ImGui::SameLine();
     bool logBranches = pGuy->getLogBranches();
     ImGui::Checkbox("branches", &logBranches);
     if (logBranches != pGuy->getLogBranches()) {
-        pGuy->setLogBranches(logBranches);
+        editTrainingGuy(pGuy, [logBranches](Guy *pEditGuy) { pEditGuy->setLogBranches(logBranches); });
     }
     ImGui::SameLine();
     bool logTransitions = pGuy->getLogTransitions();
     ImGui::Checkbox("transitions", &logTransitions);
     if (logTransitions != pGuy->getLogTransitions()) {
-        pGuy->setLogTransitions(logTransitions);
+        editTrainingGuy(pGuy, [logTransitions](Guy *pEditGuy) { pEditGuy->setLogTransitions(logTransitions); });
     }
     ImGui::SameLine();
     bool logResources = pGuy->getLogResources();
     ImGui::Checkbox("resources", &logResources);
     if (logResources != pGuy->getLogResources()) {
-        pGuy->setLogResources(logResources);
+        editTrainingGuy(pGuy, [logResources](Guy *pEditGuy) { pEditGuy->setLogResources(logResources); });
     }
     auto logQueue = pGuy->getLogQueue();
     for (int i = logQueue.size() - 1; i >= 0; i--) {
@@ -447,8 +467,9 @@ void drawGuyStatusWindow(const char *windowName, Guy *pGuy, Simulation *pSim = n
         drawGuyStatusWindow(minionWinName.c_str(), minion, pSim);
     }
 
-    if (guys.size() >= 2 && (pGuy == guys[0] || pGuy == guys[1]) && pGuy->getOpponent() && pGuy->getOpponent()->getComboHits()) {
-        renderComboMeter(pGuy == guys[1], pGuy->getOpponent()->getComboHits(), pGuy->getOpponent()->getComboDamage(), pGuy->getOpponent()->getLastDamageScale());
+    std::vector<Guy *> &viewGuys = trainingViewSim.simGuys;
+    if (viewGuys.size() >= 2 && (pGuy == viewGuys[0] || pGuy == viewGuys[1]) && pGuy->getOpponent() && pGuy->getOpponent()->getComboHits()) {
+        renderComboMeter(pGuy == viewGuys[1], pGuy->getOpponent()->getComboHits(), pGuy->getOpponent()->getComboDamage(), pGuy->getOpponent()->getLastDamageScale());
     }
 }
 
@@ -546,11 +567,11 @@ void drawInputEditor()
     }
     recordedInput.clear();
 
-    if (playingBackInput) {
-        currentFrame = playBackFrame;
+    if (trainingStatus.playingBackInput) {
+        currentFrame = trainingStatus.playBackFrame;
     }
 
-    if (recordingInput) {
+    if (trainingStatus.recordingInput) {
         currentFrame++;
     }
 
@@ -647,24 +668,24 @@ void drawComboFinderWindow()
         ImGui::Text("fps: %s", formatWithCommas(fps).c_str());
     }
 
-    if (finder.doneRoutes.size() > 0 && guys.size() > 0) {
+    if (finder.doneRoutes.size() > 0 && trainingViewSim.simGuys.size() > 0) {
         ImGui::Separator();
         ImGui::Text("Top routes:");
 
         int routeCount = 0;
         const int maxRoutes = 10;
         for (auto it = finder.doneRoutes.rbegin(); it != finder.doneRoutes.rend() && routeCount < maxRoutes; ++it, ++routeCount) {
-            std::string routeStr = routeToString(**it, guys[0]);
+            std::string routeStr = routeToString(**it, trainingViewSim.simGuys[0]);
             ImGui::TextWrapped("%s", routeStr.c_str());
         }
     }
 
-    if (finder.recentRoutes.size() > 0 && guys.size() > 0) {
+    if (finder.recentRoutes.size() > 0 && trainingViewSim.simGuys.size() > 0) {
         ImGui::Separator();
         ImGui::Text("Recent routes:");
 
         for (auto it = finder.recentRoutes.rbegin(); it != finder.recentRoutes.rend(); ++it) {
-            std::string routeStr = routeToString(*it, guys[0]);
+            std::string routeStr = routeToString(*it, trainingViewSim.simGuys[0]);
             ImGui::TextWrapped("%s", routeStr.c_str());
         }
     }
@@ -682,7 +703,9 @@ void renderAdvancedUI(float frameRate, std::deque<std::string> *pLogQueue)
     static int charID = rand() % charNames.size();
     static int versionID = charVersionCount - 1;
     static float newCharPos = 0.0;
-    resetpos = resetpos || ImGui::Button("reset positions (Q)");
+    if (ImGui::Button("reset positions (Q)")) {
+        queueTrainingCommand([]() { resetpos = true; });
+    }
     ImGui::SameLine();
     if (ImGui::Button("combo finder (C)")) {
         showComboFinder = true;
@@ -690,9 +713,12 @@ void renderAdvancedUI(float frameRate, std::deque<std::string> *pLogQueue)
     ImGui::Text("add new guy:");
     ImGui::SliderFloat("##newcharpos", &newCharPos, -765.0, 765.0);
     ImGui::ColorEdit3("##newcharcolor", newCharColor);
-    modalDropDown("##newcharchar", &charID, charNames.data(), charNames.size(), 100);
+    bool newCharChanged = modalDropDown("##newcharchar", &charID, charNames.data(), charNames.size(), 100);
     ImGui::SameLine();
-    modalDropDown("##newcharversion", &versionID, charVersions, charVersionCount, 200);
+    newCharChanged = modalDropDown("##newcharversion", &versionID, charVersions, charVersionCount, 200) || newCharChanged;
+    if (newCharChanged) {
+        requestCharDownload(charNames[charID], atoi(charVersions[versionID]));
+    }
     ImGui::SameLine();
     if ( ImGui::Button("new guy") ) {
         color col = {newCharColor[0], newCharColor[1], newCharColor[2]};
@@ -709,37 +735,81 @@ void renderAdvancedUI(float frameRate, std::deque<std::string> *pLogQueue)
         }
         ImGui::Text("input %i %i", i.first, i.second);
     }
-    ImGui::Text("frame %d", defaultSim.frameCounter);
-    if (paused) {
+    ImGui::Text("frame %d", trainingViewSim.frameCounter);
+    if (trainingStatus.paused) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(1, 0, 0, 1), "PAUSED");
     }
-    if ( playingBackInput ) {
+    if ( trainingStatus.playingBackInput ) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(0, 1, 0, 1), "PLAY");
     }
-    if ( recordingInput ) {
+    if ( trainingStatus.recordingInput ) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(1, 0, 0, 1), "RECORDING");
     }
     ImGui::SameLine();
     if ( ImGui::Button("pause (P)") ) {
-        paused = !paused;
+        queueTrainingCommand([]() { paused = !paused; });
     }
     ImGui::SameLine();
     if ( ImGui::Button("step one (0)") ) {
-        oneframe = true;
+        queueTrainingCommand([]() { oneframe = true; });
+    }
+    if (trainingStatus.historyFirstFrame != -1) {
+        ImGui::SameLine();
+        if ( ImGui::Button("back one (9)") ) {
+            queueTrainingCommand([]() { rewindToFrame = defaultSim.frameCounter - 1; });
+        }
+        ImGui::SameLine();
+        int historyFrame = trainingViewSim.frameCounter;
+        ImGui::SetNextItemWidth( 200.0 );
+        if (ImGui::SliderInt("rewind (backspace)", &historyFrame, trainingStatus.historyFirstFrame, trainingStatus.historyLastFrame)) {
+            queueTrainingCommand([historyFrame]() { rewindToFrame = historyFrame; });
+        }
     }
     ImGui::SameLine();
     char goToFrameText[32] = {};
-    snprintf(goToFrameText, sizeof(goToFrameText), "%d", runUntilFrame);
+    snprintf(goToFrameText, sizeof(goToFrameText), "%d", trainingStatus.runUntilFrame);
     ImGui::SetNextItemWidth( 100.0 );
-    ImGui::InputText("##startpostext", goToFrameText, sizeof(goToFrameText));
-    runUntilFrame = atoi(goToFrameText);
-    ImGui::Checkbox("force counter", &forceCounter);
+    if (ImGui::InputText("##startpostext", goToFrameText, sizeof(goToFrameText))) {
+        int goToFrame = atoi(goToFrameText);
+        queueTrainingCommand([goToFrame]() { runUntilFrame = goToFrame; });
+    }
+    bool counter = forceCounter;
+    if (ImGui::Checkbox("force counter", &counter)) {
+        forceCounter = counter;
+    }
     ImGui::SameLine();
-    ImGui::Checkbox("force PC", &forcePunishCounter);
+    bool punishCounter = forcePunishCounter;
+    if (ImGui::Checkbox("force PC", &punishCounter)) {
+        forcePunishCounter = punishCounter;
+    }
     ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / frameRate, frameRate);
+    const TrainingTickStats &tickStats = trainingStatus.tickStats;
+    ImGui::Text("sim tick %.3f ms (worst %.3f ms off), input latency %.1f ms (worst %.1f ms)",
+                tickStats.tickIntervalMS, tickStats.worstTickErrorMS,
+                tickStats.inputLatencyMS, tickStats.worstInputLatencyMS);
+    RollbackSettings rollback = trainingStatus.rollback;
+    ImGui::Checkbox("rollback", &rollback.enabled);
+    if (rollback.enabled) {
+        ImGui::SameLine();
+        modalDropDown("remote", &rollback.remoteGuy, std::vector<const char *>{"P1", "P2"}, 100);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth( 100.0 );
+        ImGui::SliderInt("delay", &rollback.delayFrames, 0, 14);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth( 100.0 );
+        ImGui::SliderInt("jitter", &rollback.jitterFrames, 0, 14 - rollback.delayFrames);
+        ImGui::SameLine();
+        ImGui::Checkbox("every frame", &rollback.everyFrame);
+        ImGui::Text("%d rollbacks/s (worst %d frames), resim %.0f frames/s (%.0f per tick)",
+                    tickStats.rollbackCount, tickStats.worstRollbackFrames,
+                    tickStats.resimFramesPerSecond, tickStats.resimFramesPerSecond / 60.0f);
+    }
+    if (!(rollback == trainingStatus.rollback)) {
+        queueTrainingCommand([rollback]() { rollbackSettings = rollback; });
+    }
     for (int i = pLogQueue->size() - 1; i >= 0; i--) {
         ImGui::Text("%s", (*pLogQueue)[i].c_str());
     }
@@ -747,13 +817,13 @@ void renderAdvancedUI(float frameRate, std::deque<std::string> *pLogQueue)
 
     pGuyToDelete = nullptr;
     int guyID = 1;
-    for (auto guy : guys) {
+    for (auto guy : trainingViewSim.simGuys) {
         std::string windowName = "Guy " + std::to_string(guyID++);
         drawGuyStatusWindow( windowName.c_str(), guy );
     }
 
     if (pGuyToDelete) {
-        delete pGuyToDelete;
+        editTrainingGuy(pGuyToDelete, [](Guy *pEditGuy) { delete pEditGuy; });
         pGuyToDelete = nullptr;
     }
 
@@ -766,14 +836,30 @@ void renderAdvancedUI(float frameRate, std::deque<std::string> *pLogQueue)
     }
 }
 
+void renderCharLoadProgress(void)
+{
+    CharacterPreloadProgress progress = getCharacterPreloadProgress();
+    if (progress.completed == progress.requested) {
+        return;
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(renderSizeX * 0.5f, renderSizeY * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+    ImGui::Begin("##charloadprogress", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings);
+    ImGui::Text("loading %s (%d/%d)", progress.loading.c_str(), progress.completed, progress.requested);
+    ImGui::ProgressBar((float)progress.completed / progress.requested, ImVec2(250, 0));
+    ImGui::End();
+}
+
 void renderUI(float frameRate, std::deque<std::string> *pLogQueue, int sizeX, int sizeY)
 {
     renderSizeX = sizeX;
     renderSizeY = sizeY;
     if (!toggleRenderUI) {
-        for (auto pGuy : guys) {
-            if (guys.size() >= 2 && (pGuy == guys[0] || pGuy == guys[1]) && pGuy->getOpponent() && pGuy->getOpponent()->getComboHits()) {
-                renderComboMeter(pGuy == guys[1], pGuy->getOpponent()->getComboHits(), pGuy->getOpponent()->getComboDamage(), pGuy->getOpponent()->getLastDamageScale());
+        std::vector<Guy *> &viewGuys = trainingViewSim.simGuys;
+        for (auto pGuy : viewGuys) {
+            if (viewGuys.size() >= 2 && (pGuy == viewGuys[0] || pGuy == viewGuys[1]) && pGuy->getOpponent() && pGuy->getOpponent()->getComboHits()) {
+                renderComboMeter(pGuy == viewGuys[1], pGuy->getOpponent()->getComboHits(), pGuy->getOpponent()->getComboDamage(), pGuy->getOpponent()->getLastDamageScale());
             }
         }
         ImGui::Render();
@@ -786,6 +872,7 @@ void renderUI(float frameRate, std::deque<std::string> *pLogQueue, int sizeX, in
     }
     
     simController.RenderUI();
+    renderCharLoadProgress();
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -849,18 +936,27 @@ void destroyUI(void)
     ImGui::DestroyContext();
 }
 
+void markSimInputsDirty(int frame)
+{
+    if (simInputsDirtyFrame == -1 || frame < simInputsDirtyFrame) {
+        simInputsDirtyFrame = std::max(frame, 0);
+    }
+}
+
 void CharacterUIController::renderCharSetup(void)
 {
     if (modalDropDown("##char", &character, charNiceNames, 207)) {
         simInputsChanged = true;
         timelineTriggers.clear();
         simController.moveViewerInputsChanged = true;
+        requestCharDownload(charNames[character], atoi(charVersions[charVersion]));
     }
     ImGui::SameLine();
     if (modalDropDown("##charversion", &charVersion, charVersions, charVersionCount, 35)) {
         simInputsChanged = true;
         // todo some actino ids might not match - make stitching code to find by name if needed?
         simController.moveViewerInputsChanged = true;
+        requestCharDownload(charNames[character], atoi(charVersions[charVersion]));
     }
 
     if (gameMode == ComboMaker) {
@@ -876,10 +972,14 @@ void CharacterUIController::renderCharSetup(void)
                 newStartPosX = atof(startPosTest);
             }
         }
-        if (ImGui::Checkbox("Counter", &forceCounter) ) {
+        bool counter = forceCounter;
+        if (ImGui::Checkbox("Counter", &counter) ) {
+            forceCounter = counter;
             simInputsChanged = true;
         }
-        if (ImGui::Checkbox("Punish Counter", &forcePunishCounter) ) {
+        bool punishCounter = forcePunishCounter;
+        if (ImGui::Checkbox("Punish Counter", &punishCounter) ) {
+            forcePunishCounter = punishCounter;
             simInputsChanged = true;
         }
         if (newStartPosX != flStartPosX) {
@@ -961,7 +1061,7 @@ void CharacterUIController::renderHitBoxDetails(void)
         return;
     }
 
-    std::vector<HitBox> hitBoxes;
+    FrameVector<HitBox> hitBoxes;
     std::vector<RenderBox> renderBoxes;
     pGuy->getHitBoxes(&hitBoxes, &renderBoxes);
     for (auto &minion : pGuy->getMinions()) {
@@ -995,17 +1095,18 @@ void CharacterUIController::renderActionSetup(int frameIndex)
     }
 
     Guy *pGuy = simController.getRecordedGuy(frameIndex, getSimCharSlot());
+    const RecordedGuyFrame *pGuyFrame = simController.getRecordedGuyFrame(frameIndex, getSimCharSlot());
 
     ImGui::Text("Navigation:");
     if (ImGui::Button("<")) {
         int searchFrame = frameIndex;
         bool foundNoWindow = false;
         while (searchFrame >= 0) {
-            Guy *pFrameGuy = simController.getRecordedGuy(searchFrame, getSimCharSlot());
-            if (pFrameGuy && !foundNoWindow && pFrameGuy->getFrameTriggers() != pGuy->getFrameTriggers()) {
+            const RecordedGuyFrame *pFrameGuy = simController.getRecordedGuyFrame(searchFrame, getSimCharSlot());
+            if (pFrameGuy && !foundNoWindow && pFrameGuy->frameTriggers != pGuyFrame->frameTriggers) {
                 foundNoWindow = true;
             }
-            if (foundNoWindow && pFrameGuy->getFrameTriggers().size()) {
+            if (foundNoWindow && pFrameGuy->frameTriggers.size()) {
                 simController.playing = true;
                 simController.playUntilFrame = searchFrame;
                 simController.playSpeed = -1;
@@ -1021,11 +1122,11 @@ void CharacterUIController::renderActionSetup(int frameIndex)
         int searchFrame = frameIndex;
         bool foundNoWindow = false;
         while (searchFrame < simController.simFrameCount) {
-            Guy *pFrameGuy = simController.getRecordedGuy(searchFrame, getSimCharSlot());
-            if (pFrameGuy && !foundNoWindow && pFrameGuy->getFrameTriggers() != pGuy->getFrameTriggers()) {
+            const RecordedGuyFrame *pFrameGuy = simController.getRecordedGuyFrame(searchFrame, getSimCharSlot());
+            if (pFrameGuy && !foundNoWindow && pFrameGuy->frameTriggers != pGuyFrame->frameTriggers) {
                 foundNoWindow = true;
             }
-            if (foundNoWindow && pFrameGuy->getFrameTriggers().size()) {
+            if (foundNoWindow && pFrameGuy->frameTriggers.size()) {
                 simController.playing = true;
                 simController.playUntilFrame = searchFrame;
                 simController.playSpeed = 1;
@@ -1039,7 +1140,7 @@ void CharacterUIController::renderActionSetup(int frameIndex)
         std::string strLabel = "Delete " + timelineTriggerToString(trigger, pGuy);
         if (ImGui::Button(strLabel.c_str())) {
             timelineTriggers.erase(timelineTriggers.find(frameIndex));
-            simInputsChanged = true;
+            markSimInputsDirty(frameIndex);
             changed = true;
         }
     } else if (pGuy && pGuy->getFrameTriggers().size()) {
@@ -1054,7 +1155,7 @@ void CharacterUIController::renderActionSetup(int frameIndex)
             if (pendingTriggerAdd != 0) {
                 timelineTriggers[frameIndex] = vecTriggers[pendingTriggerAdd - 1];
 
-                simInputsChanged = true;
+                markSimInputsDirty(frameIndex);
                 changed = true;
                 pendingTriggerAdd = 0;
                 triggerAdded = true;
@@ -1110,7 +1211,7 @@ void CharacterUIController::renderActionSetup(int frameIndex)
                 if (ImGui::Button("##", ImVec2(24.0,24.0))) {
                     region.input &= ~0xf;
                     region.input |= dirIDToInput[id];
-                    simInputsChanged = true;
+                    markSimInputsDirty(region.frame);
                     changed = true;
                 }
                 if (highlighted) {
@@ -1138,7 +1239,7 @@ void CharacterUIController::renderActionSetup(int frameIndex)
                 }
                 if (ImGui::Button("##", ImVec2(32.0,32.0))) {
                     region.input = region.input ^ buttonIDToInput[id];
-                    simInputsChanged = true;
+                    markSimInputsDirty(region.frame);
                     changed = true;
                 }
                 if (highlighted) {
@@ -1158,11 +1259,12 @@ void CharacterUIController::renderActionSetup(int frameIndex)
         ImGui::Button(startFrameLabel.c_str());
 
         if (ImGui::IsItemActive()) {
+            int prevFrame = region.frame;
             region.frame += (int)ImGui::GetMouseDragDelta(0, 0.0).x;
             simController.clampFrame(region.frame);
             ImGui::ResetMouseDragDelta();
             pendingDragID = regionID;
-            simInputsChanged = true;
+            markSimInputsDirty(std::min(prevFrame, region.frame));
             changed = true;
         }
 
@@ -1174,11 +1276,12 @@ void CharacterUIController::renderActionSetup(int frameIndex)
         ImGui::Button(frameCountLabel.c_str());
 
         if (ImGui::IsItemActive()) {
+            int prevDuration = region.duration;
             region.duration += (int)ImGui::GetMouseDragDelta(0, 0.0).x;
             simController.clampFrame(region.duration);
             ImGui::ResetMouseDragDelta();
             pendingDragID = regionID;
-            simInputsChanged = true;
+            markSimInputsDirty(region.frame + std::min(prevDuration, region.duration));
             changed = true;
         }
 
@@ -1233,17 +1336,17 @@ void CharacterUIController::renderFrameMeterCancelWindows(int frameIndex)
     ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.45,0.15,0.1,1.0));
     ImGui::BeginDisabled();
     for (int i = 0; i < frameCount; i++) {
-        Guy *pGuy = simController.getRecordedGuy(i, getSimCharSlot());
-        Guy *pGuyPrevFrame = simController.getRecordedGuy(i-1, getSimCharSlot());
+        const RecordedGuyFrame *pGuy = simController.getRecordedGuyFrame(i, getSimCharSlot());
+        const RecordedGuyFrame *pGuyPrevFrame = simController.getRecordedGuyFrame(i-1, getSimCharSlot());
 
-        if (!pGuyPrevFrame || (pGuy->getFrameTriggers().size() && (pGuyPrevFrame->getFrameTriggers() != pGuy->getFrameTriggers()))) {
+        if (!pGuyPrevFrame || (pGuy->frameTriggers.size() && (pGuyPrevFrame->frameTriggers != pGuy->frameTriggers))) {
             // cancel window, figure out how far it goes
             int j = i;
             pGuyPrevFrame = pGuy;
             while (true) {
                 j++;
-                Guy *pGuyJ = simController.getRecordedGuy(j, getSimCharSlot());
-                if (!pGuyJ || (pGuyPrevFrame->getFrameTriggers() != pGuyJ->getFrameTriggers())) {
+                const RecordedGuyFrame *pGuyJ = simController.getRecordedGuyFrame(j, getSimCharSlot());
+                if (!pGuyJ || (pGuyPrevFrame->frameTriggers != pGuyJ->frameTriggers)) {
                     break;
                 }
                 pGuyPrevFrame = pGuyJ;
@@ -1358,7 +1461,7 @@ void CharacterUIController::renderCharSummaryRow()
     }
     ImGui::SameLine();
     ImGui::SetCursorPosX(startCursorX + kFrameOffset * (kHorizSpacing + kFrameButtonWidth));
-    ImGui::Text("%s %d/%d", pGuy->getCurrentActionPtr()->niceNameDyn.c_str(), pGuy->getCurrentFrame(), pGuy->getCurrentActionPtr()->actionFrameDuration);
+    ImGui::Text("%s %d/%d", pGuy->getCharData()->getActionNames(pGuy->getCurrentActionPtr()).niceNameDyn.c_str(), pGuy->getCurrentFrame(), pGuy->getCurrentActionPtr()->actionFrameDuration);
 }
 
 void CharacterUIController::renderFrameMeter(int frameIndex)
@@ -1387,14 +1490,14 @@ void CharacterUIController::renderFrameMeter(int frameIndex)
         // walk from the end and find advantage
         int i = frameCount - 1;
         while (i > 0) {
-            Guy *pGuy = simController.getRecordedGuy(i, getSimCharSlot());
-            Guy *pOtherGuy = simController.getRecordedGuy(i, !getSimCharSlot());
-            if (pGuy->getFrameMeterColorIndex() == 1 && pOtherGuy->getFrameMeterColorIndex() != 1) {
+            const RecordedGuyFrame *pGuy = simController.getRecordedGuyFrame(i, getSimCharSlot());
+            const RecordedGuyFrame *pOtherGuy = simController.getRecordedGuyFrame(i, !getSimCharSlot());
+            if (pGuy->frameMeterColorIndex == 1 && pOtherGuy->frameMeterColorIndex != 1) {
                 foundAdvantageWindow = true;
                 endAdvantageWindowFrame = i;
                 while (i > 0) {
-                    Guy *pGuy = simController.getRecordedGuy(i, getSimCharSlot());
-                    if (pGuy->getFrameMeterColorIndex() != 1) {
+                    const RecordedGuyFrame *pGuy = simController.getRecordedGuyFrame(i, getSimCharSlot());
+                    if (pGuy->frameMeterColorIndex != 1) {
                         break;
                     }
                     advantageFrames++;
@@ -1407,7 +1510,7 @@ void CharacterUIController::renderFrameMeter(int frameIndex)
                     break;
                 }
             }
-            if (pGuy->getFrameMeterColorIndex() != 1 && pOtherGuy->getFrameMeterColorIndex() != 1) {
+            if (pGuy->frameMeterColorIndex != 1 && pOtherGuy->frameMeterColorIndex != 1) {
                 break;
             }
             i--;
@@ -1415,14 +1518,14 @@ void CharacterUIController::renderFrameMeter(int frameIndex)
     }
 
     for (int i = 0; i < frameCount; i++) {
-        Guy *pGuy = simController.getRecordedGuy(i, getSimCharSlot());
-        Guy *pGuyNextFrame = simController.getRecordedGuy(i+1, getSimCharSlot());
-        Guy *pGuyPrevFrame = i > 0 ? simController.getRecordedGuy(i-1, getSimCharSlot()) : nullptr;
+        const RecordedGuyFrame *pGuy = simController.getRecordedGuyFrame(i, getSimCharSlot());
+        const RecordedGuyFrame *pGuyNextFrame = simController.getRecordedGuyFrame(i+1, getSimCharSlot());
+        const RecordedGuyFrame *pGuyPrevFrame = i > 0 ? simController.getRecordedGuyFrame(i-1, getSimCharSlot()) : nullptr;
         if (i != 0) ImGui::SameLine();
 
         ImGui::PushID(i);
 
-        int colorIndex = pGuy->getFrameMeterColorIndex();
+        int colorIndex = pGuy->frameMeterColorIndex;
         ImGui::PushStyleColor(ImGuiCol_Button, frameMeterColors[colorIndex]);
         bool darkText = false;
         if (colorIndex != 1 && colorIndex != 6) {
@@ -1432,7 +1535,7 @@ void CharacterUIController::renderFrameMeter(int frameIndex)
             ImGui::PushStyleColor(ImGuiCol_Text, kFrameButtonBorderColor);
         }
         std::string strButtonCaption = "";
-        if (!pGuyNextFrame || colorIndex != pGuyNextFrame->getFrameMeterColorIndex()) {
+        if (!pGuyNextFrame || colorIndex != pGuyNextFrame->frameMeterColorIndex) {
             strButtonCaption = std::to_string(sameColorCount+1);
             sameColorCount = 0;
         } else {
@@ -1473,10 +1576,10 @@ void CharacterUIController::renderFrameMeter(int frameIndex)
         } else {
             ImGui::Dummy(ImVec2(kFrameButtonWidth,kFrameButtonHeight));
         }
-        Guy *guyToUse = gameMode == Viewer ? pGuyPrevFrame : pGuy;
+        const RecordedGuyFrame *guyToUse = gameMode == Viewer ? pGuyPrevFrame : pGuy;
         if (draw && guyToUse) {
-            int inputToUse = guyToUse->getCurrentInput();
-            if (guyToUse->getDirection() < 0) {
+            int inputToUse = guyToUse->currentInput;
+            if (guyToUse->direction < 0) {
                 inputToUse = invertDirection(inputToUse);
             }
             if (rightSide) {
@@ -1537,6 +1640,45 @@ void CharacterUIController::renderFrameMeter(int frameIndex)
     ImGui::PopID();
 }
 
+void Simulation::CreateGuyFromCharController(CharacterUIController &controller)
+{
+    std::string charName = charNames[controller.character];
+
+    int version = atoi(charVersions[controller.charVersion]);
+    CreateGuy(charName, version, controller.startPosX, Fixed(0), controller.rightSide ? -1 : 1, controller.charColor);
+
+    Guy *pGuy = simGuys[controller.getSimCharSlot()];
+
+    controller.maxStartHealth = pGuy->getCharData()->vitality;
+    controller.maxStartGauge = pGuy->getCharData()->gauge;
+
+    if (controller.startHealth == 0) {
+        controller.startHealth = controller.maxStartHealth;
+    }
+    if (controller.startHealth > controller.maxStartHealth) {
+        controller.startHealth = controller.maxStartHealth;
+    }
+    if (controller.startGauge == 0) {
+        controller.startGauge = controller.maxStartGauge;
+    }
+    if (controller.startGauge > controller.maxStartGauge) {
+        controller.startGauge = controller.maxStartGauge;
+    }
+    pGuy->setHealth(controller.startHealth);
+    pGuy->setFocus(controller.startFocus);
+    pGuy->setGauge(controller.startGauge);
+
+    pGuy->DoInstantAction(580); // IMM_STAGE_INIT
+    pGuy->DoInstantAction(581); // IMM_ROUND_INIT
+
+    if (controller.buffLevel != pGuy->getUniqueParam(0)) {
+        pGuy->getUniqueParam(0) = controller.buffLevel;
+        if (controller.buffLevel && controller.buffLevel < (int)(pGuy->getCharData()->styles.size())) {
+            pGuy->ChangeStyle(controller.buffLevel);
+        }
+    }
+}
+
 int CharacterUIController::getInput(int frameID)
 {
     int input = 0;
@@ -1551,6 +1693,7 @@ int CharacterUIController::getInput(int frameID)
 
 SimulationController::~SimulationController()
 {
+    CancelSimulation();
     stateRecording.clear();
 }
 
@@ -1665,6 +1808,8 @@ bool SimulationController::NewSim(void)
         return false;
     }
 
+    CancelSimulation();
+
     if (pSim != nullptr) {
         delete pSim;
         pSim = nullptr;
@@ -1677,20 +1822,13 @@ bool SimulationController::NewSim(void)
     }
 
     stateRecording.clear();
+    simulatedFrames.clear();
 
     for (int i = 0; i < charCount; i++) {
         pSim->CreateGuyFromCharController(charControllers[i]);
     }
 
-    for (auto &guy : pSim->simGuys) {
-        guy->setRecordFrameTriggers(true, true);
-        guy->setLogTransitions(viewerLogTransitions);
-        guy->setLogTriggers(viewerLogTriggers);
-        guy->setLogUnknowns(viewerLogUnknowns);
-        guy->setLogHits(viewerLogHits);
-        guy->setLogBranches(viewerLogBranches);
-        guy->setLogResources(viewerLogResources);
-    }
+    setupViewerGuys(pSim);
 
 
     maxComboCount = 0;
@@ -1710,26 +1848,87 @@ bool SimulationController::NewSim(void)
     return true;
 }
 
-void SimulationController::RecordFrame(void)
+void SimulationController::RecordFrame(Simulation *pFrameSim, FrameRecording &recording)
 {
     if (!recordFrames) return;
 
-    stateRecording.emplace_back();
-    RecordedFrame &frame = stateRecording[stateRecording.size()-1];
+    recording.Record(pFrameSim);
+}
+
+void SimulationController::StartSimulation(Simulation *pNewJobSim, std::function<void()> job)
+{
+    CancelSimulation();
+    pJobSim = pNewJobSim;
+    jobRecording.ContinueFrom(stateRecording);
+    publishedRecording.ContinueFrom(stateRecording);
+    simDone = false;
+    simThread = std::thread([this, job]() {
+        job();
+        simDone = true;
+    });
+}
+
+void SimulationController::CancelSimulation(void)
+{
+    if (simThread.joinable()) {
+        simCancel = true;
+        simThread.join();
+        simCancel = false;
+    }
+    delete pJobSim;
+    pJobSim = nullptr;
+    simulatingRound = -1;
+    jobRecording.clear();
+    publishedRecording.clear();
+    publishedUpdates.clear();
+}
+
+void SimulationController::PollSimulation(void)
+{
+    if (!simThread.joinable()) {
+        return;
+    }
+    // the job publishes everything before it's done, check first so the
+    // last of it can't slip past
+    bool done = simDone;
+    std::vector<std::function<void()>> updates;
+    {
+        std::scoped_lock lock(simMutex);
+        publishedRecording.MoveFramesTo(stateRecording);
+        updates.swap(publishedUpdates);
+    }
+    // updates can start the next job
+    if (done) {
+        simThread.join();
+    }
+    simFrameCount = stateRecording.size();
+    for (auto &update : updates) {
+        update();
+    }
+}
+
+void SimulationController::Publish(std::function<void()> update)
+{
+    std::scoped_lock lock(simMutex);
+    jobRecording.MoveFramesTo(publishedRecording);
+    if (update) {
+        publishedUpdates.push_back(std::move(update));
+    }
+}
 
-    frame.sim.Clone(pSim);
-    for (int i = 0; i < (int)pSim->everyone.size() && i < (int)frame.sim.everyone.size(); i++) {
-        frame.sim.everyone[i]->getLogQueue() = pSim->everyone[i]->getLogQueue();
-        frame.sim.everyone[i]->getLastLogFrame() = pSim->everyone[i]->getLastLogFrame();
+void SimulationController::RecordJobFrame(Simulation *pFrameSim)
+{
+    RecordFrame(pFrameSim, jobRecording);
+    if ((int)jobRecording.size() >= kPublishFrameCount) {
+        Publish();
     }
-    frame.events = pSim->getCurrentFrameEvents();
-    pSim->getCurrentFrameEvents().clear();
 }
 
 Guy *SimulationController::getRecordedGuy(int frameIndex, int guyID)
 {
-    if (frameIndex >= 0 && frameIndex < (int)stateRecording.size()) {
-        for (auto guy : stateRecording[frameIndex].sim.everyone) {
+    Simulation *pFrameSim = stateRecording.GetFrame(frameIndex);
+    if (pFrameSim) {
+        for (auto guy : pFrameSim->everyone) {
             if (guy->getUniqueID() == guyID) {
                 return guy;
             }
@@ -1746,24 +1945,18 @@ void SimulationController::renderRecordedHitMarkers(int frameIndex)
     if (frameIndex >= (int)stateRecording.size()) return;
 
     for (int checkFrame = startFrame; checkFrame <= frameIndex; checkFrame++) {
-        if (checkFrame >= (int)stateRecording.size()) continue;
-        auto &histFrame = stateRecording[checkFrame];
+        const std::vector<FrameEvent> *pEvents = stateRecording.GetEvents(checkFrame);
+        if (!pEvents) continue;
 
-        for (const auto &event : histFrame.events) {
+        for (const auto &event : *pEvents) {
             if (event.type == FrameEvent::Hit) {
                 int markerAge = frameIndex - checkFrame;
 
-                Guy* targetGuy = nullptr;
-                for (auto guy : histFrame.sim.everyone) {
-                    if (guy->getUniqueID() == event.hitEventData.targetID) {
-                        targetGuy = guy;
-                        break;
-                    }
-                }
+                const RecordedGuyFrame *targetGuy = getRecordedGuyFrame(checkFrame, event.hitEventData.targetID);
 
                 if (targetGuy) {
-                    float worldX = targetGuy->getPosX().f() + event.hitEventData.x;
-                    float worldY = targetGuy->getPosY().f() + event.hitEventData.y;
+                    float worldX = targetGuy->posX + event.hitEventData.x;
+                    float worldY = targetGuy->posY + event.hitEventData.y;
                     drawHitMarker(worldX, worldY, event.hitEventData.radius,
                                  event.hitEventData.hitType, markerAge, maxMarkerAge,
                                  event.hitEventData.dirX, event.hitEventData.dirY, event.hitEventData.seed);
@@ -1775,10 +1968,7 @@ void SimulationController::renderRecordedHitMarkers(int frameIndex)
 
 Simulation *SimulationController::getSnapshotAtFrame(int frameIndex)
 {
-    if (frameIndex >= 0 && frameIndex < (int)stateRecording.size()) {
-        return &stateRecording[frameIndex].sim;
-    }
-    return nullptr;
+    return stateRecording.GetFrame(frameIndex);
 }
 
 void SimulationController::doFrameMeterDrag(void)
@@ -2594,8 +2784,9 @@ void SimulationController::RenderUI(void)
 
 void SimulationController::getFinishedSnapshotAtFrame(Simulation *pSimDst, int frameIndex)
 {
-    if (frameIndex >= 0 && frameIndex < (int)stateRecording.size()) {
-        pSimDst->Clone(&stateRecording[frameIndex].sim);
+    Simulation *pFrameSim = stateRecording.GetFrame(frameIndex);
+    if (pFrameSim) {
+        pSimDst->Clone(pFrameSim);
 
         for (int i = 0; i < charCount; i++) {
             Guy *pGuy = pSimDst->simGuys[charControllers[i].getSimCharSlot()];
@@ -2608,70 +2799,101 @@ void SimulationController::getFinishedSnapshotAtFrame(Simulation *pSimDst, int f
     }
 }
 
-void SimulationController::AdvanceUntilComplete(void)
+void SimulationController::AdvanceUntilComplete(int startFrame)
+{
+    Simulation *pNewJobSim = new Simulation;
+    pNewJobSim->Clone(pSim);
+
+    // the ui keeps editing the timeline while this runs
+    StartSimulation(pNewJobSim, [this, controllers = charControllers, jobCharCount = charCount, startFrame,
+                                 jobMaxComboCount = maxComboCount, jobMaxComboDamage = maxComboDamage]() {
+        RunTimeline(controllers, jobCharCount, startFrame, jobMaxComboCount, jobMaxComboDamage);
+    });
+}
+
+void SimulationController::RunTimeline(std::vector<CharacterUIController> controllers, int jobCharCount, int startFrame,
+                                       int jobMaxComboCount, int jobMaxComboDamage)
 {
-    int frameCount = 0;
+    std::vector<SimulatedFrame> simulatedBatch;
+    auto publishBatch = [this, &simulatedBatch]() {
+        Publish([this, simulatedBatch]() {
+            simulatedFrames.insert(simulatedFrames.end(), simulatedBatch.begin(), simulatedBatch.end());
+            if (!simulatedBatch.empty()) {
+                maxComboCount = simulatedBatch.back().maxComboCount;
+                maxComboDamage = simulatedBatch.back().maxComboDamage;
+            }
+        });
+        simulatedBatch.clear();
+    };
+
+    int frameCount = startFrame;
     bool bLastFrame = false;
     while (true) {
-        for (int i = 0; i < charCount; i++) {
+        if (simCancel) {
+            return;
+        }
+
+        for (int i = 0; i < jobCharCount; i++) {
             // put forced triggers in place before RunFrame(), because it contains the hitstop end AdvanceFrame()
-            Guy *pGuy = pSim->simGuys[charControllers[i].getSimCharSlot()];
-            charControllers[i].forcedInput = 0;
+            Guy *pGuy = pJobSim->simGuys[controllers[i].getSimCharSlot()];
+            controllers[i].forcedInput = 0;
             auto &forcedTrigger = pGuy->getForcedTrigger();
-            auto frameTrigger = charControllers[i].timelineTriggers.find(frameCount);
-            if (frameTrigger != charControllers[i].timelineTriggers.end()) {
+            auto frameTrigger = controllers[i].timelineTriggers.find(frameCount);
+            if (frameTrigger != controllers[i].timelineTriggers.end()) {
                 if (frameTrigger->second.actionID() > 0) {
                     forcedTrigger = frameTrigger->second;
                 } else {
-                    charControllers[i].forcedInput = -frameTrigger->second.actionID();
+                    controllers[i].forcedInput = -frameTrigger->second.actionID();
                     if (pGuy->getDirection() < 0) {
-                        charControllers[i].forcedInput = invertDirection(charControllers[i].forcedInput);
+                        controllers[i].forcedInput = invertDirection(controllers[i].forcedInput);
                     }
                 }
             }
         }
-        pSim->RunFrame();
-        RecordFrame();
+        pJobSim->RunFrame();
+        RecordFrame(pJobSim, jobRecording);
 
-        for (int i = 0; i < charCount; i++) {
-            Guy *pGuy = pSim->simGuys[charControllers[i].getSimCharSlot()];
+        SimulatedFrame simulatedFrame;
+        for (int i = 0; i < jobCharCount; i++) {
+            Guy *pGuy = pJobSim->simGuys[controllers[i].getSimCharSlot()];
 
-            if (pGuy->getComboHits() > maxComboCount) {
-                maxComboCount = pGuy->getComboHits();
+            if (pGuy->getComboHits() > jobMaxComboCount) {
+                jobMaxComboCount = pGuy->getComboHits();
             }
-            if (pGuy->getComboDamage() > maxComboDamage) {
-                maxComboDamage = pGuy->getComboDamage();
+            if (pGuy->getComboDamage() > jobMaxComboDamage) {
+                jobMaxComboDamage = pGuy->getComboDamage();
             }
 
-            int input = charControllers[i].getInput(frameCount);
-            if (charControllers[i].forcedInput) {
-                input = charControllers[i].forcedInput;
+            int input = controllers[i].getInput(frameCount);
+            if (controllers[i].forcedInput) {
+                input = controllers[i].forcedInput;
             }
             int prevInput = pGuy->getCurrentInput();
-            pGuy->Input(addPressBits(input, prevInput));
+            input = addPressBits(input, prevInput);
+            pGuy->Input(input);
+            simulatedFrame.inputs.push_back(input);
         }
-        pSim->AdvanceFrame();
+        pJobSim->AdvanceFrame();
+        simulatedFrame.maxComboCount = jobMaxComboCount;
+        simulatedFrame.maxComboDamage = jobMaxComboDamage;
+        simulatedBatch.push_back(std::move(simulatedFrame));
 
         // update frame triggers after AdvanceFrame
-        RecordedFrame &frame = stateRecording[stateRecording.size()-1];
-        for (auto guy : pSim->everyone) {
-            for (auto recordedGuy : frame.sim.everyone) {
-                if (recordedGuy->getUniqueID() == guy->getUniqueID()) {
-                    recordedGuy->getFrameTriggers() = guy->getFrameTriggers();
-                    break;
-                }
-            }
-        }
+        jobRecording.UpdateLastFrameTriggers(pJobSim);
         frameCount++;
 
+        if ((int)simulatedBatch.size() >= kPublishFrameCount) {
+            publishBatch();
+        }
+
         if (bLastFrame) {
             break;
         }
 
         bool bDone = true;
 
-        for (int i = 0; i < charCount; i++) {
-            Guy *pGuy = pSim->simGuys[charControllers[i].getSimCharSlot()];
+        for (int i = 0; i < jobCharCount; i++) {
+            Guy *pGuy = pJobSim->simGuys[controllers[i].getSimCharSlot()];
             // if we're not idle, we're not done
             if (!pGuy->canAct()) {
                 bDone = false;
@@ -2685,12 +2907,12 @@ void SimulationController::AdvanceUntilComplete(void)
             // bias a bit to have some buffer for stuff to get delayed?
             const int kBias = 10;
 
-            for (auto &[key, trigger] : charControllers[i].timelineTriggers) {
+            for (auto &[key, trigger] : controllers[i].timelineTriggers) {
                 if (key > frameCount - kBias) {
                     bDone = false;
                 }
             }
-            for (auto &region : charControllers[i].inputRegions) {
+            for (auto &region : controllers[i].inputRegions) {
                 if (region.frame + region.duration > frameCount - kBias) {
                     bDone = false;
                 }
@@ -2712,6 +2934,17 @@ void SimulationController::AdvanceUntilComplete(void)
         }
     }
 
+    publishBatch();
+    Publish([this]() {
+        delete pSim;
+        pSim = pJobSim;
+        pJobSim = nullptr;
+        FinishAdvance();
+    });
+}
+
+void SimulationController::FinishAdvance(void)
+{
     simFrameCount = stateRecording.size();
 
     int controllerSearchForNextTrigger = -1;
@@ -2730,8 +2963,8 @@ void SimulationController::AdvanceUntilComplete(void)
         simController.playSpeed = 1;
         int searchFrame = scrubberFrame + 2; // skip kara cancel :/
         while (searchFrame < simFrameCount) {
-            Guy *pGuy = getRecordedGuy(searchFrame, charControllers[controllerSearchForNextTrigger].getSimCharSlot());
-            if (pGuy->getFrameTriggers().size()) {
+            const RecordedGuyFrame *pGuy = getRecordedGuyFrame(searchFrame, charControllers[controllerSearchForNextTrigger].getSimCharSlot());
+            if (pGuy->frameTriggers.size()) {
                 playUntilFrame = searchFrame;
                 break;
             }
@@ -2741,25 +2974,60 @@ void SimulationController::AdvanceUntilComplete(void)
     }
 }
 
+void SimulationController::ResimulateFrom(int frame)
+{
+    // frames that haven't come in yet get simulated again anyway
+    CancelSimulation();
+    frame = std::min(frame, (int)stateRecording.size());
+    Simulation *pFrameSim = nullptr;
+    if (pSim && frame > 0 && simulatedFrames.size() == stateRecording.size()) {
+        pFrameSim = stateRecording.GetFrame(frame - 1);
+    }
+    if (!pFrameSim) {
+        // nothing to pick up from, go through NewSim next time around
+        simInputsChanged = true;
+        return;
+    }
+
+    // the recorded frame is right after RunFrame, finish it the way
+    // AdvanceUntilComplete did and carry on from there
+    pSim->Clone(pFrameSim);
+    const SimulatedFrame &simulatedFrame = simulatedFrames[frame - 1];
+    for (int i = 0; i < charCount; i++) {
+        pSim->simGuys[charControllers[i].getSimCharSlot()]->Input(simulatedFrame.inputs[i]);
+    }
+    pSim->AdvanceFrame();
+    maxComboCount = simulatedFrame.maxComboCount;
+    maxComboDamage = simulatedFrame.maxComboDamage;
+
+    stateRecording.Truncate(frame);
+    simulatedFrames.resize(frame);
+    AdvanceUntilComplete(frame);
+}
+
 void SimulationController::ReloadViewer()
 {
     bool isReload = (simFrameCount > 0);
     int savedFrame = scrubberFrame;
-    bool savedPlaying = playing;
     int savedPlaySpeed = playSpeed;
 
-    if (!replayInputData.empty()) {
+    // the frames come back in on the sim thread, go back to where we were
+    // once they're all in
+    if (isReload) {
+        restoreFrame = savedFrame;
+    }
+
+    if (!replay.inputData.empty()) {
         int round = (replayCurrentRound >= 0) ? replayCurrentRound : 0;
-        SimulateAllReplayRounds();
-        LoadReplayRound(round);
+        // log flags changed, the checkpoints still hold and only the round
+        // being viewed gets simulated again
+        SimulateAllReplayRounds(round);
     } else if (!viewerDumpPath.empty()) {
         LoadFromGameDump(viewerDumpPath, viewerDumpVersion);
     }
 
     if (isReload) {
-        scrubberFrame = savedFrame;
-        clampFrame(scrubberFrame);
-        playing = savedPlaying;
+        playing = false;
         playSpeed = savedPlaySpeed;
     }
     prevScrubberFrame = -1;
@@ -2767,45 +3035,46 @@ void SimulationController::ReloadViewer()
 
 void SimulationController::LoadFromGameDump(const std::string &path, int version)
 {
+    CancelSimulation();
+
     viewerDumpPath = path;
     viewerDumpVersion = version;
 
     stateRecording.clear();
 
+    // the error list reads pSim, leave an empty one until the job's done
     if (pSim) {
         delete pSim;
     }
     pSim = new Simulation;
 
-    if (path.find("match") != std::string::npos) {
-        pSim->match = true;
-    }
-    if (path.find("forcepc") != std::string::npos) {
-        forcePunishCounter = true;
-    }
-
-    pSim->SetupFromGameDump(path, version);
-    for (auto &guy : pSim->simGuys) {
-        guy->setRecordFrameTriggers(true, true);
-        guy->setLogTransitions(viewerLogTransitions);
-        guy->setLogTriggers(viewerLogTriggers);
-        guy->setLogUnknowns(viewerLogUnknowns);
-        guy->setLogHits(viewerLogHits);
-        guy->setLogBranches(viewerLogBranches);
-        guy->setLogResources(viewerLogResources);
-    }
-
-    while (pSim->replayingGameStateDump) {
-        pSim->RunFrame();
-        RecordFrame();
-        pSim->AdvanceFrame();
-    }
-
-    simFrameCount = stateRecording.size();
+    simFrameCount = 0;
     scrubberFrame = 0;
     playing = true;
     playSpeed = 1;
 
+    StartSimulation(new Simulation, [this, path, version]() {
+        simulateGameDump(pJobSim, path, version, [this](Simulation *pDumpSim) {
+            if (simCancel) {
+                pDumpSim->replayingGameStateDump = false;
+                return;
+            }
+            RecordJobFrame(pDumpSim);
+        });
+        if (simCancel) {
+            return;
+        }
+        Publish([this]() {
+            delete pSim;
+            pSim = pJobSim;
+            pJobSim = nullptr;
+            applyRestoreFrame();
+        });
+    });
+}
+
+void SimulationController::applyRestoreFrame(void)
+{
     if (restoreFrame > -1) {
         scrubberFrame = restoreFrame;
         playing = false;
@@ -2816,257 +3085,103 @@ void SimulationController::LoadFromGameDump(const std::string &path, int version
     }
 }
 
-static const nlohmann::json &replayInputBytes(const nlohmann::json &inputData)
-{
-    if (inputData.is_object() && inputData.contains("mValue")) {
-        return inputData["mValue"];
-    }
-    return inputData;
-}
-
-static bool isOldReplayFormat(const nlohmann::json &replayInfo)
+bool SimulationController::LoadFromReplay(nlohmann::json &parsed, int version)
 {
-    if (replayInfo.contains("RoundInfo") && replayInfo["RoundInfo"].is_object()) {
-        return true;
-    }
-    if (replayInfo.contains("Fighters") && replayInfo["Fighters"].is_object()
-        && replayInfo["Fighters"].contains("FighterID")
-        && replayInfo["Fighters"]["FighterID"].is_array()) {
-        return true;
-    }
-    return false;
+    // a replay job reads the old one
+    CancelSimulation();
+    return loadReplayData(parsed, version, replay);
 }
 
-static void fixupOldReplayInfo(nlohmann::json &replayInfo)
+// the checkpoints only live in replayIndex
+static ReplayRoundResult summarizeRoundResult(const ReplayRoundResult &indexRound)
 {
-    // fix up everything except input data, which still needs mValue accessed by hand
-
-    if (replayInfo["Fighters"].is_object() && replayInfo["Fighters"].contains("FighterID")
-        && replayInfo["Fighters"]["FighterID"].is_array()) {
-        nlohmann::json oldFighters = replayInfo["Fighters"];
-        nlohmann::json newFighters = nlohmann::json::array();
-        size_t n = oldFighters["FighterID"].size();
-        for (size_t i = 0; i < n; i++) {
-            nlohmann::json f = nlohmann::json::object();
-            for (auto it = oldFighters.begin(); it != oldFighters.end(); ++it) {
-                if (it.value().is_array() && it.value().size() > i) {
-                    f[it.key()] = it.value()[i];
-                }
-            }
-            newFighters.push_back(f);
-        }
-        replayInfo["Fighters"] = newFighters;
-    }
-
-    if (replayInfo["RoundInfo"].is_object()) {
-        nlohmann::json old = replayInfo["RoundInfo"];
-
-        nlohmann::json saGauge = nlohmann::json::array({0, 0});
-        if (old.contains("SAGaugeStart")) {
-            const auto &sg = old["SAGaugeStart"];
-            if (sg.is_object() && sg.contains("mValue")) saGauge = sg["mValue"];
-            else if (sg.is_array()) saGauge = sg;
-        }
-        nlohmann::json styleNo = nlohmann::json::array({0, 0});
-        if (old.contains("StyleNo")) {
-            const auto &sn = old["StyleNo"];
-            if (sn.is_object() && sn.contains("mValue")) styleNo = sn["mValue"];
-            else if (sn.is_array()) styleNo = sn;
-        }
-        nlohmann::json uniqueParam = nlohmann::json::array({0, 0});
-        if (old.contains("UniqueParam")) {
-            const auto &up = old["UniqueParam"];
-            if (up.is_object() && up.contains("raw")) uniqueParam = up["raw"];
-            else if (up.is_array()) uniqueParam = up;
-        }
-
-        int roundCount = 0;
-        if (old.contains("RandomSeed") && old["RandomSeed"].is_array()) {
-            roundCount = (int)old["RandomSeed"].size();
-        }
-
-        nlohmann::json newRounds = nlohmann::json::array();
-        for (int r = 0; r < roundCount; r++) {
-            nlohmann::json ri = nlohmann::json::object();
-            ri["RandomSeed"] = old["RandomSeed"][r];
-            ri["WinPlayerType"] = 0;
-            if (old.contains("WinPlayerType") && old["WinPlayerType"].is_array() && (int)old["WinPlayerType"].size() > r) {
-                ri["WinPlayerType"] = old["WinPlayerType"][r];
-            }
-            ri["FinishType"] = 0;
-            if (old.contains("FinishType") && old["FinishType"].is_array() && (int)old["FinishType"].size() > r) {
-                ri["FinishType"] = old["FinishType"][r];
-            }
-            // old format only stores end-of-match values for these fields; use them on the
-            // last round only and zero earlier rounds so simulation code can safely consume
-            // RoundInfo[r] without picking up wrong per-round state
-            bool isLast = (r == roundCount - 1);
-            ri["SAGaugeStart"] = isLast ? saGauge : nlohmann::json::array({0, 0});
-            ri["StyleNo"] = isLast ? styleNo : nlohmann::json::array({0, 0});
-            ri["UniqueParam"] = isLast ? uniqueParam : nlohmann::json::array({0, 0});
-            if (old.contains("BgmInfo")) ri["BgmInfo"] = old["BgmInfo"];
-            newRounds.push_back(ri);
-        }
-        replayInfo["RoundInfo"] = newRounds;
-    }
+    ReplayRoundResult result;
+    result.summary = indexRound.summary;
+    result.hasErrors = indexRound.hasErrors;
+    result.finishFrame = indexRound.finishFrame;
+    result.start = indexRound.start;
+    result.frameCount = indexRound.frameCount;
+    return result;
 }
 
-bool SimulationController::LoadFromReplay(nlohmann::json &parsed, int version)
+void SimulationController::SimulateAllReplayRounds(int loadRound)
 {
-    nlohmann::json &data = parsed.contains("BattleReplayData") ? parsed["BattleReplayData"] : parsed;
-    if (!data.contains("InputData") || !data.contains("ReplayInfo")) {
-        return false;
-    }
-
-    replayInfo = data["ReplayInfo"];
-    replayIsOldFormat = isOldReplayFormat(replayInfo);
-    if (replayIsOldFormat) {
-        fixupOldReplayInfo(replayInfo);
-    }
-    replayInputData = replayInputBytes(data["InputData"]).get<std::vector<uint8_t>>();
-    if (version == -1) {
-        if (replayInfo.contains("Version") && replayInfo["Version"].is_number_integer()) {
-            int64_t startTime = 0;
-            if (parsed.contains("ReplayResultInfo") && parsed["ReplayResultInfo"].is_object()
-                && parsed["ReplayResultInfo"].contains("StartTime")
-                && parsed["ReplayResultInfo"]["StartTime"].is_number_integer()) {
-                startTime = parsed["ReplayResultInfo"]["StartTime"].get<int64_t>();
-            }
-            version = simVersionFromGameVersion(replayInfo["Version"].get<int>(), startTime);
-        } else {
-            version = atoi(charVersions[charVersionCount - 1]);
-        }
-    }
-    replayVersion = version;
-    return true;
-}
+    CancelSimulation();
 
-void SimulationController::SimulateAllReplayRounds()
-{
     replayRoundRecordings.clear();
     replayRoundCount = 0;
     replayCurrentRound = -1;
     stateRecording.clear();
-    if (pSim) { delete pSim; pSim = nullptr; }
-
-    int roundCount = (int)replayInfo["RoundInfo"].size();
-
-    ReplayDecoder decoder;
-    decoder.inputData = replayInputData;
-
-    bool batchMode = (gameMode == Batch);
-
-    Simulation *prevRoundSim = nullptr;
-
-    for (int round = 0; round < roundCount; round++) {
-        nlohmann::json &roundInfo = replayInfo["RoundInfo"][round];
-
-        if (roundInfo["RandomSeed"] == 0) {
-            break;
-        }
-
-        const Simulation *prevRoundEnd = (replayIsOldFormat && round > 0) ? prevRoundSim : nullptr;
-
-        pSim = new Simulation;
-        pSim->SetupReplayRound(replayInfo, round, replayVersion, decoder, prevRoundEnd);
-        for (auto &guy : pSim->simGuys) {
-            guy->setRecordFrameTriggers(true, true);
-            guy->setLogTransitions(viewerLogTransitions);
-            guy->setLogTriggers(viewerLogTriggers);
-            guy->setLogUnknowns(viewerLogUnknowns);
-            guy->setLogHits(viewerLogHits);
-            guy->setLogBranches(viewerLogBranches);
-            guy->setLogResources(viewerLogResources);
-        }
+    simFrameCount = 0;
+    // the round sims are gone, leave an empty one for the rest of the ui
+    if (pSim) { delete pSim; }
+    pSim = new Simulation;
 
-        int prevHealth[2] = {0, 0};
-        while (!decoder.finished && pSim->replayingReplay) {
-            prevHealth[0] = pSim->simGuys[0]->getHealth();
-            prevHealth[1] = pSim->simGuys[1]->getHealth();
-            pSim->RunFrame();
-            RecordFrame();
-            pSim->AdvanceFrame();
+    bool haveIndex = !replayIndex.rounds.empty() && replayIndex.replayHash == hashReplayData(replay);
+    if (!haveIndex && !replayPath.empty()) {
+        haveIndex = loadReplayIndex(replayIndexPath(replayPath), replay, replayIndex);
+    }
+    if (haveIndex) {
+        for (const ReplayRoundResult &indexRound : replayIndex.rounds) {
+            ReplayRoundRecording recording;
+            recording.result = summarizeRoundResult(indexRound);
+            replayRoundRecordings.push_back(std::move(recording));
+            replayRoundCount++;
         }
+        LoadReplayRound(loadRound);
+        return;
+    }
 
-        if (batchMode) {
-            fprintf(stderr, "R;round %d finished at frame %d\n", round + 1, pSim->frameCounter);
-        }
+    replayIndex = ReplayIndex();
 
-        int winPlayer = roundInfo["WinPlayerType"];
+    // rounds show up in the list as they come in, the index only once it's
+    // complete
+    StartSimulation(nullptr, [this, loadRound, path = replayPath]() {
+        auto pIndex = std::make_shared<ReplayIndex>();
+        pIndex->replayHash = hashReplayData(replay);
+        pIndex->checkpointInterval = defaultReplayCheckpointInterval;
 
-        ReplayRoundResult result;
-        std::string errors;
+        // rounds can be simulating on several threads, each records into its own
+        std::vector<FrameRecording> roundFrames(replay.replayInfo["RoundInfo"].size());
 
-        if (winPlayer == 0 || winPlayer == 1) {
-            int losePlayer = winPlayer ^ 1;
-            int loserHealth = pSim->simGuys[losePlayer]->getHealth();
-            if (loserHealth != 0 || prevHealth[losePlayer] == 0) {
-                if (batchMode) {
-                    fprintf(stderr, "E;round %d loser (P%d) health %d expected zero prev health %d expected nonzero\n", round + 1, losePlayer + 1, loserHealth, prevHealth[losePlayer]);
+        ReplayRunOptions options;
+        options.checkpointInterval = pIndex->checkpointInterval;
+        simulateReplayRounds(replay,
+            [this, &roundFrames](int round, Simulation *pRoundSim) {
+                if (simCancel) {
+                    pRoundSim->replayingReplay = false;
+                    return;
                 }
-                errors += "loser P" + std::to_string(losePlayer + 1) + " health " + std::to_string(loserHealth) + "; ";
-                result.hasErrors = true;
-            }
-        } else {
-            for (int p = 0; p < 2; p++) {
-                int h = pSim->simGuys[p]->getHealth();
-                if (h != 0 || prevHealth[p] == 0) {
-                    if (batchMode) {
-                        fprintf(stderr, "E;round %d draw P%d health %d expected zero prev health %d expected nonzero\n", round + 1, p + 1, h, prevHealth[p]);
-                    }
-                    errors += "draw P" + std::to_string(p + 1) + " health " + std::to_string(h) + "; ";
-                    result.hasErrors = true;
+                RecordFrame(pRoundSim, roundFrames[round]);
+            },
+            [this, &roundFrames, pIndex](int round, Simulation *, ReplayRoundResult &result) {
+                if (simCancel) {
+                    return;
                 }
-            }
-        }
+                auto pRecording = std::make_shared<ReplayRoundRecording>();
+                pRecording->frames = std::move(roundFrames[round]);
+                pIndex->rounds.push_back(std::move(result));
+                pRecording->result = summarizeRoundResult(pIndex->rounds.back());
+                Publish([this, pRecording]() {
+                    replayRoundRecordings.push_back(std::move(*pRecording));
+                    replayRoundCount++;
+                });
+            }, options);
 
-        bool checkGauge = !replayIsOldFormat || round == roundCount - 1;
-        if (checkGauge) {
-            for (int p = 0; p < 2; p++) {
-                int simGauge = pSim->simGuys[p]->getGauge();
-                int expectedGauge = roundInfo["SAGaugeStart"][p];
-                if (expectedGauge != simGauge) {
-                    if (batchMode) {
-                        fprintf(stderr, "E;round %d P%d end gauge %d expected %d\n", round + 1, p + 1, simGauge, expectedGauge);
-                    }
-                    errors += "P" + std::to_string(p + 1) + " gauge " + std::to_string(simGauge) + " expected " + std::to_string(expectedGauge) + "; ";
-                    result.hasErrors = true;
-                }
-            }
+        if (simCancel) {
+            return;
         }
-
-        if (result.hasErrors) {
-            result.summary = "Round " + std::to_string(round + 1) + ": " + errors;
-        } else {
-            result.summary = "Round " + std::to_string(round + 1) + ": OK";
+        if (!path.empty() && !writeReplayIndex(*pIndex, replayIndexPath(path))) {
+            log("couldn't write replay index for " + path);
         }
-
-        ReplayRoundRecording recording;
-        recording.frames = std::move(stateRecording);
-        recording.result = std::move(result);
-        replayRoundRecordings.push_back(std::move(recording));
-        replayRoundCount++;
-
-        stateRecording.clear();
-        delete prevRoundSim;
-        prevRoundSim = pSim;
-        pSim = nullptr;
-
-        decoder.inputState[0] = 0;
-        decoder.inputState[1] = 0;
-        decoder.prevInputState[0] = 0;
-        decoder.prevInputState[1] = 0;
-    }
-
-    delete prevRoundSim;
-
-    if (batchMode) {
-        fprintf(stderr, "F;replay finished;%d\n", replayVersion);
-    }
-
-    if (!pSim) {
-        pSim = new Simulation;
-    }
+        Publish([this, pIndex, loadRound]() {
+            replayIndex = std::move(*pIndex);
+            // unless a round got picked while they were coming in
+            if (replayCurrentRound == -1) {
+                LoadReplayRound(loadRound);
+            }
+        });
+    });
 }
 
 void SimulationController::LoadReplayRound(int round)
@@ -3078,6 +3193,12 @@ void SimulationController::LoadReplayRound(int round)
     if (round == replayCurrentRound) return;
     if (round < 0 || round >= (int)replayRoundRecordings.size()) return;
 
+    // half a round isn't worth keeping, it gets simulated again next time
+    if (simulatingRound != -1) {
+        CancelSimulation();
+        stateRecording.clear();
+    }
+
     // stash the previously-viewed round's frames back in their slot before swapping in the new round
     if (replayCurrentRound >= 0 && replayCurrentRound < (int)replayRoundRecordings.size()) {
         replayRoundRecordings[replayCurrentRound].frames = std::move(stateRecording);
@@ -3091,14 +3212,35 @@ void SimulationController::LoadReplayRound(int round)
     playing = true;
     playSpeed = 1;
 
-    if (restoreFrame > -1) {
-        scrubberFrame = restoreFrame;
-        playing = false;
-        restoreFrame = -1;
-        if (scrubberFrame >= (int)stateRecording.size()) {
-            scrubberFrame = stateRecording.size() - 1;
-        }
+    // results came from the index, this round hasn't been simulated yet
+    if (stateRecording.empty() && round < (int)replayIndex.rounds.size()) {
+        StartSimulation(nullptr, [this, round]() {
+            Simulation roundSim;
+            ReplayDecoder decoder;
+            auto recordRoundFrame = [this](int, Simulation *pRoundSim) {
+                if (simCancel) {
+                    pRoundSim->replayingReplay = false;
+                    return;
+                }
+                RecordJobFrame(pRoundSim);
+            };
+            if (seekReplayIndex(replayIndex, replay, round, 0, &roundSim, decoder, recordRoundFrame)) {
+                finishReplayRound(round, &roundSim, decoder, recordRoundFrame);
+            }
+            roundSim.pReplayDecoder = nullptr;
+            if (simCancel) {
+                return;
+            }
+            Publish([this]() {
+                simulatingRound = -1;
+                applyRestoreFrame();
+            });
+        });
+        simulatingRound = round;
+        return;
     }
+
+    applyRestoreFrame();
 }
 
 int CharacterUIController::getOptionFlags()
@@ -1,12 +1,18 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #include "chara.hpp"
 #include "simulation.hpp"
 #include "guy.hpp"
 #include "combogen.hpp"
+#include "recording.hpp"
+#include "replay.hpp"
 
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
@@ -97,10 +103,20 @@ public:
     void RenderUI(void);
     void RenderMoveViewerWindow(void);
     void RenderComboMinerSetup(void);
-    void AdvanceUntilComplete(void);
+    // simulates from pSim on the sim thread, pSim gets the end state once
+    // it's done
+    void AdvanceUntilComplete(int startFrame = 0);
+    // the AdvanceUntilComplete job, and what the ui does when it's done
+    void RunTimeline(std::vector<CharacterUIController> controllers, int jobCharCount, int startFrame,
+                     int jobMaxComboCount, int jobMaxComboDamage);
+    void FinishAdvance(void);
+    // picks the sim back up right before frame instead of starting over
+    void ResimulateFrom(int frame);
     void doFrameMeterDrag(void);
-    void RecordFrame(void);
+    void RecordFrame(Simulation *pFrameSim, FrameRecording &recording);
     Guy *getRecordedGuy(int frameIndex, int guyID);
+    // for going over lots of frames, getRecordedGuy rebuilds the whole frame
+    const RecordedGuyFrame *getRecordedGuyFrame(int frameIndex, int guyID) { return stateRecording.GetGuy(frameIndex, guyID); }
     void renderRecordedHitMarkers(int frameIndex);
     Simulation *getSnapshotAtFrame(int frameIndex);
     void getFinishedSnapshotAtFrame(Simulation *pSimDst, int frameIndex);
@@ -146,47 +162,82 @@ public:
     float curMomentum;
     ImGuiID activeDragID = 0;
 
-    std::deque<RecordedFrame> stateRecording;
+    FrameRecording stateRecording;
+    // what AdvanceUntilComplete did after recording each frame, enough to
+    // carry on from any of them
+    struct SimulatedFrame {
+        std::vector<int> inputs;
+        int maxComboCount;
+        int maxComboDamage;
+    };
+    std::vector<SimulatedFrame> simulatedFrames;
 
     // dump viewer state
     std::string viewerDumpPath;
     int viewerDumpVersion = -1;
 
     // replay viewer state
-    struct ReplayRoundResult {
-        std::string summary;
-        bool hasErrors = false;
-    };
     struct ReplayRoundRecording {
-        std::deque<RecordedFrame> frames;
+        FrameRecording frames;
         ReplayRoundResult result;
     };
     std::deque<ReplayRoundRecording> replayRoundRecordings;
-    nlohmann::json replayInfo;
-    std::vector<uint8_t> replayInputData;
-    int replayVersion = -1;
+    ReplayData replay;
+    std::string replayPath;
+    // checkpoints for every round, from the sidecar or the last full simulation
+    ReplayIndex replayIndex;
     int replayCurrentRound = -1;
     int replayRoundCount = 0;
-    bool replayIsOldFormat = false;
 
     bool LoadFromReplay(nlohmann::json &parsed, int version);
-    void SimulateAllReplayRounds();
+    // with an index for this replay (already loaded or next to the file) only
+    // the results get loaded, rounds get simulated from their checkpoints
+    // when they're opened. loadRound gets opened once the results are in
+    void SimulateAllReplayRounds(int loadRound = 0);
     void LoadReplayRound(int round);
     void LoadFromGameDump(const std::string &path, int version);
     void ReloadViewer();
+    // jumps to restoreFrame once a load has all its frames
+    void applyRestoreFrame(void);
+    // round whose frames are still coming in on stateRecording, -1 if none
+    int simulatingRound = -1;
+
+    // the viewer and combo maker simulate on simThread so the ui keeps
+    // drawing while they run. a job only touches its own sim and
+    // jobRecording, and Publishes every so often: PollSimulation moves the
+    // frames onto stateRecording on the ui thread and runs the updates the
+    // job sent along, so the timeline fills in as it goes
+    void StartSimulation(Simulation *pNewJobSim, std::function<void()> job);
+    // throws away whatever the job hasn't handed over yet
+    void CancelSimulation(void);
+    void PollSimulation(void);
+    bool simulationRunning(void) { return simThread.joinable(); }
+    // on the sim thread
+    void Publish(std::function<void()> update = nullptr);
+    void RecordJobFrame(Simulation *pFrameSim);
+
+    static constexpr int kPublishFrameCount = 30;
+
+    std::thread simThread;
+    std::atomic<bool> simCancel = false;
+    std::atomic<bool> simDone = false;
+    // the job's sim, becomes pSim when a job hands it over
+    Simulation *pJobSim = nullptr;
+    FrameRecording jobRecording;
+    // handed over by the job, not picked up by the ui yet
+    std::mutex simMutex;
+    FrameRecording publishedRecording;
+    std::vector<std::function<void()>> publishedUpdates;
 
     bool viewerErrorTypeFilter[14] = {true,false,false,false,false,true,true,true,true,true,true,true,true,true};
 
-    bool viewerLogTransitions = false;
-    bool viewerLogTriggers = false;
-    bool viewerLogUnknowns = true;
-    bool viewerLogHits = false;
-    bool viewerLogBranches = false;
-    bool viewerLogResources = false;
 };
 
 extern SimulationController simController;
 extern bool simInputsChanged;
+// earliest frame a timeline edit touched, -1 if none, simInputsChanged wins
+extern int simInputsDirtyFrame;
+void markSimInputsDirty(int frame);
 
 extern class ComboFinder finder;
 extern std::map<int, ActionRef> finderStartTimelineTriggers[2];